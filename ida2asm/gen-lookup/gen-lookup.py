@@ -211,21 +211,20 @@ static const char *parseString(const char *src, char *dst, Token& token)
     return src;
 }
 
-static const char *parseNumber(const char *src, char *dst, Token& token)
+static const char *parseNumber(const char *src, Token& token)
 {
     assert(isNumberStart(*src));
     auto start = src;
 
     if (*src == '+' || *src == '-') {
         if (!isDigit(src[1])) {
-            *dst = *src;
             token.type = *src == '+' ? Token::T_PLUS : Token::T_MINUS;
             token.category = Token::kOperator;
-            token.textLength = 1;
+            token.setSourceText(start, 1);
             return src + 1;
         }
 
-        *dst++ = *src++;
+        src++;
     }
 
     assert(isDigit(*src));
@@ -235,9 +234,7 @@ static const char *parseNumber(const char *src, char *dst, Token& token)
 
     const char *binEnd = nullptr;
 
-    for (; !isDelimiter(*src); src++, dst++) {
-        *dst = *src;
-
+    for (; !isDelimiter(*src); src++) {
         if (*src == 'b' && isBin ) {
             binEnd = src + 1;
             isBin = false;
@@ -245,7 +242,7 @@ static const char *parseNumber(const char *src, char *dst, Token& token)
 
         if (*src == 'h') {
             token.type = Token::T_HEX;
-            token.textLength = src - start + 1;
+            token.setSourceText(start, src - start + 1);
             return src + 1;
         } else if (*src != '0' && *src != '1') {
             isBin = false;
@@ -259,7 +256,7 @@ static const char *parseNumber(const char *src, char *dst, Token& token)
 
     if (binEnd) {
         token.type = Token::T_BIN;
-        token.textLength = binEnd - start;
+        token.setSourceText(start, binEnd - start);
         return binEnd;
     }
 
@@ -269,7 +266,7 @@ static const char *parseNumber(const char *src, char *dst, Token& token)
             src++;
     }
 
-    token.textLength = src - start;
+    token.setSourceText(start, src - start);
     token.type = Token::T_NUM;
     return src;
 }
@@ -286,34 +283,29 @@ static const char *parseDup(const char *src, char *dst, Token& token)
         src++;
 
     if (isDigit(*src) || (*src == '+' || *src == '-') && isDigit(src[1])) {
-        src = parseNumber(src, dst, token);
+        src = parseNumber(src, token);
     } else if (*src == '\'') {
         src = parseString(src + 1, dst, token);
     } else if (src[0] == '<' && src[1] == '0' && src[2] == '>' && src[3] == ')') {
         token.type = Token::T_DUP_STRUCT_INIT;
-        *dst++ = '<';
-        *dst++ = '0';
-        *dst++ = '>';
-        token.textLength = 3;
+        token.setSourceText(src, 3);
         return src + 4;
     } else if (*src == '?' && src[1] == ')') {
-        *dst = '?';
+        token.setSourceText(src, 1);
         token.type = Token::T_DUP_QMARK;
-        token.textLength = 1;
         return src + 2;
     } else {
         src -= 4;
         auto start = src;
 
         while (*src != ')' && *src != '\n')
-            *dst++ = *src++;
+            src++;
 
-        if (*src == ')')
-            *dst++ = *src++;
+        src += *src == ')';
 
         token.category = Token::kId;
         token.type = Token::T_ID;
-        token.textLength = src - start;
+        token.setSourceText(start, src - start);
         token.hash = Util::hash(start, token.textLength);
 
         return src;
@@ -325,14 +317,14 @@ static const char *parseDup(const char *src, char *dst, Token& token)
     return src + (*src == ')');
 }
 
-static const char *parseId(const char *start, const char *src, char *dst, Token& token)
+static const char *parseId(const char *start, const char *src, Token& token)
 {
     while (!isDelimiter(*src))
-        *dst++ = *src++;
+        src++;
 
     token.category = Token::kId;
     token.type = Token::T_ID;
-    token.textLength = src - start;
+    token.setSourceText(start, src - start);
     token.hash = Util::hash(start, token.textLength);
 
     return src;
@@ -343,14 +335,14 @@ def lookupTokenPrologue():
     op = lambda ch, type: f'''
     }} else if (*p == '{ch}') {{
         token.type = Token::{type};
-        token.textLength = 1;
         token.category = Token::kOperator;
-        *id = '{ch}';
+        token.setSourceText(p, 1);
         return p + 1;'''
 
     return r'''    memset(&token, 0, sizeof(Token));
     auto start = p;
 
+    // tokens point straight into the input, only text that had to be altered gets stored after the token
     auto id = const_cast<char *>(token.text());
 
     while (*p == ' ' || *p == '\r' || *p == '\t')
@@ -361,12 +353,18 @@ def lookupTokenPrologue():
         token.type = Token::T_NL;
         token.textLength = 2;
         token.category = Token::kWhitespace;
-        *id++ = '\r';
-        *id = '\n';
+
+        if (*p == '\n' && p > start && p[-1] == '\r') {
+            token.setSourceText(p - 1, 2);
+        } else {
+            *id++ = '\r';
+            *id = '\n';
+        }
+
         return p + 1 + (p[1] == '\n');
     } else if (isNumberStart(*p)) {
         token.category = Token::kNumber;
-        return parseNumber(p, id, token);''' + \
+        return parseNumber(p, token);''' + \
     op(',', 'T_COMMA') + r'''
     } else if (*p == ';') {
         token.type = Token::T_COMMENT;
@@ -398,10 +396,9 @@ def lookupTokenPrologue():
     op('[', 'T_LBRACKET') + op(']', 'T_RBRACKET') + op('(', 'T_LPAREN') + op(')', 'T_RPAREN') + r'''
     } else if (*p == '+') {
         // to disambiguate uses of + we will have to regard it as binary operator always, and numbers can't start with it
-        token.textLength = 1;
         token.type = Token::T_PLUS;
         token.category = Token::kOperator;
-        *id = '+';
+        token.setSourceText(p, 1);
         return p + 1;
     } else if (*p == '\'') {
         token.category = Token::kId;
@@ -444,9 +441,9 @@ def outputLookupToken(tokens, useIfs):
         while len(stem) < len(word):
             stem += word[len(stem)]
             if useIfs:
-                out(indent + f"if ((*id++ = *p++) == '{stem[-1]}') {{")
+                out(indent + f"if (*p++ == '{stem[-1]}') {{")
             else:
-                out(indent + 'switch (*id++ = *p++) {')
+                out(indent + 'switch (*p++) {')
                 out(indent + f"case '{stem[-1]}':")
             indent += ' ' * kTabSize
 
@@ -456,7 +453,7 @@ def outputLookupToken(tokens, useIfs):
 
         out(indent + f'token.category = Token::{token["category"]};')
         out(indent + f'token.type = Token::{token["type"]};')
-        out(indent + 'token.textLength = p - start;')
+        out(indent + 'token.setSourceText(start, p - start);')
 
         if token['category'] == 'kRegister' and 'subCategory' in token:
             registerType = token['subCategory']
@@ -479,7 +476,7 @@ def outputLookupToken(tokens, useIfs):
         out(indent + '}')
 
     out(r'''
-    return parseId(start, p - 1, id - 1, token);
+    return parseId(start, p - 1, token);
 }''')
 
 # the main output routine
@@ -685,11 +682,10 @@ def testLookupEpilogue(specificPart):
 
     // assume there's a new line at the end
     while (!isDelimiter(*p))
-        *id++ = *p++;
+        p++;
 
     int length = p - start;
-    memcpy(id, start, length);
-    token.textLength = length;
+    token.setSourceText(start, length);
 
     if (length == 1) {
         switch (*start) {
@@ -720,13 +716,13 @@ def testLookupEpilogue(specificPart):
 ''' + specificPart + r'''
     } else {
         if (isNumberStart(*start))
-            return parseNumber(start, id, token);
+            return parseNumber(start, token);
         else if (*start == '\'')
             return parseString(start + 1, id, token);
         else if (start[0] == 'd' && start[1] == 'u' && start[2] == 'p' && start[3] == '(' && start[4] != ')')
             return parseDup(start, id, token);
         else
-            return parseId(start, p, id, token);
+            return parseId(start, p, token);
     }
 
     return p;
@@ -2,46 +2,72 @@
 #include "InputConverterWorker.h"
 #include "Tokenizer.h"
 #include "IdaAsmParser.h"
+#include "ShardPlanner.h"
 #include "Util.h"
 
 constexpr int kDefinesCapacity = 45'000;
+constexpr char kProcCacheFilename[] = "ida2asm-procs.cache";
 
 InputConverter::InputConverter(const char *inputPath, const char *outputPath, const char *swosHeaderFile,
-    OutputFormatResolver::OutputFormat format, int numFiles, int extraMemorySize, bool disableOptimizations,
-    bool disableAlignmentChecks, SymbolFileParser& symFileParser)
+    OutputFormatResolver::OutputFormat format, int numFiles, int numThreads, int extraMemorySize, bool disableOptimizations,
+    bool disableAlignmentChecks, bool disableProcCache, bool instrumentProcs, const char *procProfilePath,
+    SymbolFileParser& symFileParser)
 :
     m_inputPath(inputPath), m_outputPath(outputPath), m_headerPath(swosHeaderFile), m_format(format), m_numFiles(numFiles),
     m_extraMemorySize(extraMemorySize), m_disableOptimizations(disableOptimizations), m_disableAlignmentChecks(disableAlignmentChecks),
-    m_defines(kDefinesCapacity), m_symFileParser(symFileParser), m_dataBank(symFileParser)
+    m_disableProcCache(disableProcCache), m_instrumentProcs(instrumentProcs), m_procProfilePath(procProfilePath),
+    m_defines(kDefinesCapacity), m_symFileParser(symFileParser), m_dataBank(symFileParser),
+    m_stackNeutralProcs(symFileParser), m_taskPool(numThreads)
 {
-    loadFile(inputPath);
+    timePhase("load", [&]() { loadFile(inputPath); });
 }
 
 void InputConverter::convert()
 {
     auto [codeStart, commonPrefix] = findCodeDataStart();
 
-    int commonPartLength = codeStart - m_data.get();
-    int remainingLength = m_dataLength - commonPartLength;
+    int commonPartLength = codeStart - m_data;
 
-    int blockSize = remainingLength / m_numFiles;
+    ShardPlanner shardPlanner(m_data, m_dataLength, commonPartLength);
+    std::vector<ShardPlanner::Shard> shards;
+    timePhase("plan", [&]() { shards = shardPlanner.plan(m_numFiles); });
 
-    auto lineNo = parse(commonPartLength, blockSize);
+    size_t lineNo;
+    timePhase("parse", [&]() { lineNo = parse(commonPartLength, shards); });
 
     checkForParsingErrors(lineNo);
-    auto workersToOutput = connectRanges();
-    resolveExterns(workersToOutput);
-    consolidateVariables();
-    output(commonPrefix, workersToOutput);
-    checkForUnusedSymbols();
+
+    timePhase("index", [&]() { buildSymbolIndex(); });
+
+    AllowedChunkList workersToOutput;
+    timePhase("resolve", [&]() {
+        workersToOutput = connectRanges();
+        resolveExterns(workersToOutput);
+    });
+
+    timePhase("variables", [&]() { consolidateVariables(); });
+    timePhase("stack", [&]() { findStackNeutralProcs(); });
+
+    timePhase("output", [&]() {
+        loadProcProfile();
+        initProcCache(commonPartLength);
+        output(commonPrefix, workersToOutput);
+        saveProcCache();
+    });
+
+    timePhase("unused symbols", [&]() { checkForUnusedSymbols(); });
+
+    shardPlanner.showReport(shards);
+    showPhaseTimes();
 }
 
 void InputConverter::loadFile(const char *path)
 {
-    // make sure new line is guaranteed to end the file, so the tokenizer can be a bit simpler
-    auto result = Util::loadFile(path, true);
-    m_data.reset(result.first);
-    m_dataLength = result.second;
+    // make sure new line is guaranteed to end the file, so the tokenizer can be a bit simpler;
+    // input stays mapped until we're done, since the tokens point straight into it
+    m_inputFile.open(path, true);
+    m_data = m_inputFile.data();
+    m_dataLength = m_inputFile.size();
 
     if (!m_dataLength)
         Util::exit("Could not process file %s, it seems to be empty", EXIT_FAILURE, path);
@@ -50,7 +76,7 @@ void InputConverter::loadFile(const char *path)
 std::pair<const char *, String> InputConverter::findCodeDataStart() const
 {
     // skip structs, defines and intro comments
-    auto start = strstr(m_data.get(), ".586");
+    auto start = strstr(m_data, ".586");
     assert(start);
     auto p = start;
 
@@ -71,7 +97,7 @@ std::pair<const char *, String> InputConverter::findCodeDataStart() const
 
 const char *InputConverter::skipBom(int& length)
 {
-    auto data = m_data.get();
+    auto data = m_data;
 
     if (length >= 3 && !memcmp(data, "\xef\xbb\xbf", 3)) {
         data += 3;
@@ -99,29 +125,31 @@ size_t InputConverter::parseCommonPart(int length)
     return parser.lineCount();
 }
 
-size_t InputConverter::parse(int commonPartLength, int blockSize)
+size_t InputConverter::parse(int commonPartLength, const std::vector<ShardPlanner::Shard>& shards)
 {
+    assert(static_cast<int>(shards.size()) == m_numFiles);
+
     for (int i = 0; i < m_numFiles; i++) {
         m_symbolTables.push_back(new SymbolTable(m_symFileParser.symbolTable()));
-        int chunkOffset = commonPartLength - Util::kNewLine.size() + i * blockSize;
 
-        m_workers.push_back(new InputConverterWorker(i + 1, m_data.get(), m_dataLength,
-            chunkOffset, blockSize, m_symFileParser, *m_symbolTables.back()));
+        m_workers.push_back(new InputConverterWorker(i + 1, m_data, m_dataLength,
+            shards[i].offset, shards[i].length, m_symFileParser, *m_symbolTables.back()));
 
         if (m_format == OutputFormatResolver::kCpp)
             m_workers.back()->setDataBank(&m_dataBank);
-
-        auto future = std::async(std::launch::async, &InputConverterWorker::process, m_workers.back());
-        m_futures.push_back(std::move(future));
     }
 
-    // utilize main thread too, this should finish first
-    auto lineNo = parseCommonPart(commonPartLength);
+    size_t lineNo = 0;
 
-    // workers should still be busy, so we basically we get this for free :)
-    m_symFileParser.outputHeaderFile(m_headerPath);
-
-    waitForWorkers();
+    // common part is the first task, and the header gets written while the chunks are still being parsed
+    m_taskPool.run(m_workers.size() + 1, [&](size_t i) {
+        if (i == 0) {
+            lineNo = parseCommonPart(commonPartLength);
+            m_symFileParser.outputHeaderFile(m_headerPath);
+        } else {
+            m_workers[i - 1]->process();
+        }
+    });
 
     return lineNo;
 }
@@ -175,21 +203,24 @@ std::vector<int> InputConverter::connectRanges()
     return activeChunks;
 }
 
-void InputConverter::resolveExterns(const AllowedChunkList& allowedChunks)
+// Inactive chunks are indexed too, since active ones might still reference their labels.
+void InputConverter::buildSymbolIndex()
 {
-    collectSegments();
+    std::vector<References *> chunkReferences;
 
-    auto constWorkers = std::vector<const InputConverterWorker *>{ m_workers.begin(), m_workers.end() };
+    for (auto worker : m_workers)
+        chunkReferences.push_back(&worker->parser().references());
 
-    for (size_t i = 0; i < m_futures.size(); i++) {
-        if (allowedChunks[i]) {
-            auto future = std::async(std::launch::async, &InputConverterWorker::resolveReferences, m_workers[i],
-                std::ref(constWorkers), std::ref(m_segments), std::ref(m_structs), std::ref(m_defines));
-            m_futures[i] = std::move(future);
-        }
-    }
+    m_symbolIndex.build(chunkReferences);
+}
+
+void InputConverter::resolveExterns(const AllowedChunkList& allowedChunks)
+{
+    collectSegments();
 
-    waitForWorkers();
+    m_taskPool.run(workersBySize(allowedChunks), [&](size_t i) {
+        m_workers[i]->resolveReferences(m_symbolIndex, m_segments, m_structs, m_defines);
+    });
 }
 
 void InputConverter::collectSegments()
@@ -212,6 +243,69 @@ void InputConverter::consolidateVariables()
     }
 }
 
+void InputConverter::loadProcProfile()
+{
+    if (m_format != OutputFormatResolver::kCpp || !m_procProfilePath)
+        return;
+
+    m_procProfile = std::make_unique<ProcProfile>(m_procProfilePath);
+    m_procProfile->load();
+    m_procProfile->showReport();
+}
+
+// Needed to keep pushed values in local variables across calls, which only the optimized C++ output does.
+void InputConverter::findStackNeutralProcs()
+{
+    if (m_format != OutputFormatResolver::kCpp || m_disableOptimizations)
+        return;
+
+    std::vector<const OutputItemStream *> chunks;
+
+    for (auto worker : m_workers)
+        chunks.push_back(&worker->parser().outputItems());
+
+    m_stackNeutralProcs.build(chunks, m_taskPool);
+}
+
+// Everything that the generated code of all the procs depends on goes into the context hash: converter build,
+// options, structs and defines (the common part), and variable layout. Should any of it change, the cache is void.
+void InputConverter::initProcCache(int commonPartLength)
+{
+    if (m_format != OutputFormatResolver::kCpp || m_disableProcCache)
+        return;
+
+    auto hash = Util::hash64Value(ProcCache::kGeneratorVersion, Util::kInitialHash64Value);
+    hash = Util::hash64Value(m_disableOptimizations, hash);
+    hash = Util::hash64Value(m_disableAlignmentChecks, hash);
+    hash = Util::hash64Value(m_instrumentProcs, hash);
+    hash = Util::hash64(m_data, commonPartLength, hash);
+    hash = Util::hash64Value(m_dataBank.layoutHash(), hash);
+
+    m_procCacheContextHash = hash;
+
+    const auto& path = Util::joinPaths(Util::getBasePath(m_outputPath), kProcCacheFilename);
+    m_procCache = std::make_unique<ProcCache>(path);
+    m_procCache->load();
+}
+
+void InputConverter::saveProcCache()
+{
+    int numChangedFiles = 0;
+    for (auto worker : m_workers)
+        numChangedFiles += worker->outputOk() && worker->outputWriter().outputFileChanged();
+
+    std::cout << "Output files changed: " << numChangedFiles << '/' << m_workers.size() << '\n';
+
+    if (m_procCache) {
+        auto numHits = m_procCache->numHits();
+        auto numProcs = numHits + m_procCache->numMisses();
+        std::cout << "Procs reused from cache: " << numHits << '/' << numProcs << '\n';
+
+        if (!m_procCache->save())
+            std::cout << "Failed to save proc cache\n";
+    }
+}
+
 void InputConverter::output(const String& commonPrefix, const AllowedChunkList& activeChunks)
 {
     assert(!m_segments.empty());
@@ -220,8 +314,9 @@ void InputConverter::output(const String& commonPrefix, const AllowedChunkList&
     CToken *openSegment = m_workers[0]->parser().firstSegment();
     CToken *externDefSegment{};
     std::string prefix = commonPrefix.string() + Util::kNewLineString();
+    std::vector<CToken *> openSegments(m_workers.size());
 
-    for (size_t i = 0; i < m_futures.size(); i++) {
+    for (size_t i = 0; i < m_workers.size(); i++) {
         if (!activeChunks[i])
             continue;
 
@@ -239,16 +334,24 @@ void InputConverter::output(const String& commonPrefix, const AllowedChunkList&
 
         m_workers[i]->setCImportSymbols(m_symFileParser.imports());
         m_workers[i]->setCExportSymbols(m_symFileParser.exports());
+        m_workers[i]->setProcCache(m_procCache.get(), m_procCacheContextHash);
+        m_workers[i]->setProcProfile(m_procProfile.get(), m_instrumentProcs);
+        m_workers[i]->setStackNeutralProcs(m_stackNeutralProcs.numProcs() ? &m_stackNeutralProcs : nullptr);
 
-        auto future = std::async(std::launch::async, &InputConverterWorker::output, m_workers[i], m_format, m_outputPath,
-            m_extraMemorySize, m_disableOptimizations, m_disableAlignmentChecks, std::ref(m_structs), std::ref(m_defines),
-            std::cref(prefix), std::make_pair(openSegment, i == 0));
-        m_futures[i] = std::move(future);
+        openSegments[i] = openSegment;
     }
 
-    outputStructsAndDefines();
+    // structs and defines file also carries VM data, which makes it one of the biggest tasks, so it goes first
+    auto order = workersBySize(activeChunks);
+    order.insert(order.begin(), m_workers.size());
 
-    waitForWorkers();
+    m_taskPool.run(order, [&](size_t i) {
+        if (i == m_workers.size())
+            outputStructsAndDefines();
+        else
+            m_workers[i]->output(m_format, m_outputPath, m_extraMemorySize, m_disableOptimizations,
+                m_disableAlignmentChecks, m_structs, m_defines, prefix, std::make_pair(openSegments[i], i == 0));
+    });
 
     checkForOutputErrors();
 }
@@ -264,7 +367,7 @@ void InputConverter::checkForOutputErrors()
         }
     }
 
-    assert(m_numFiles == m_workers.size() && m_numFiles == m_futures.size());
+    assert(m_numFiles == m_workers.size());
 
     for (int i = 0; i < m_numFiles - 1; i++) {
         const auto& limitsError = m_workers[i]->limitsError();
@@ -319,15 +422,9 @@ void InputConverter::checkForUnusedSymbols()
     if (!possiblyUnusedSymbols.empty()) {
         decltype(possiblyUnusedSymbols) unusedSymbols;
 
-        for (const auto& sym : possiblyUnusedSymbols) {
-            auto it = std::find_if(m_workers.begin(), m_workers.end(), [&sym](const auto worker) {
-                const auto& refs = worker->parser().references();
-                return refs.hasReference(sym) || refs.hasPublic(sym);
-            });
-
-            if (it == m_workers.end() && !m_symFileParser.isImport(sym))
+        for (const auto& sym : possiblyUnusedSymbols)
+            if (!m_symbolIndex.isUsed(sym) && !m_symFileParser.isImport(sym))
                 unusedSymbols.push_back(sym);
-        }
 
         exitIfUndefinedSymbols("Unknown symbol(s) found: ", unusedSymbols);
     }
@@ -344,10 +441,48 @@ void InputConverter::outputStructsAndDefines()
             m_outputWriter->getOutputError().c_str());
 }
 
-void InputConverter::waitForWorkers()
+// Returns indices of active workers, the ones with the most output items first.
+std::vector<size_t> InputConverter::workersBySize(const AllowedChunkList& activeChunks) const
 {
-    for (auto& future : m_futures)
-        future.wait();
+    std::vector<size_t> order;
+
+    for (size_t i = 0; i < m_workers.size(); i++)
+        if (activeChunks[i])
+            order.push_back(i);
+
+    std::stable_sort(order.begin(), order.end(), [this](auto i, auto j) {
+        return m_workers[i]->parser().outputItems().size() > m_workers[j]->parser().outputItems().size();
+    });
+
+    return order;
+}
+
+void InputConverter::timePhase(const char *name, std::function<void()> phase)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    phase();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    auto timeElapsed = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    m_phaseTimes.emplace_back(name, timeElapsed);
+}
+
+void InputConverter::showPhaseTimes() const
+{
+    std::cout << "Phase times (" << m_taskPool.numThreads() << " threads, " << m_workers.size() << " files):";
+
+    for (const auto& [name, time] : m_phaseTimes)
+        std::cout << ' ' << name << ' ' << Util::formatDelimitedNumber(time) << "ms" <<
+            (&time != &m_phaseTimes.back().second ? "," : "");
+
+    std::cout << "\nSymbol index: " << Util::formatDelimitedNumber(m_symbolIndex.numSymbols()) << " symbols, " <<
+        Util::formatDelimitedNumber(m_symbolIndex.numLabels()) << " labels\n";
+
+    if (m_stackNeutralProcs.numProcs())
+        std::cout << "Stack neutral procs: " << Util::formatDelimitedNumber(m_stackNeutralProcs.numNeutralProcs()) << '/' <<
+            Util::formatDelimitedNumber(m_stackNeutralProcs.numProcs()) << '\n';
 }
 
 void InputConverter::error(const std::string& desc, size_t lineNo)
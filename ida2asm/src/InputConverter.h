@@ -6,7 +6,14 @@
 #include "OutputWriter/OutputFactory.h"
 #include "OutputWriter/OutputFormatResolver.h"
 #include "OutputWriter/CppOutput/DataBank.h"
+#include "OutputWriter/CppOutput/ProcCache.h"
+#include "OutputWriter/CppOutput/ProcProfile.h"
+#include "OutputWriter/CppOutput/StackNeutralProcs.h"
 #include "OutputItem/Segment.h"
+#include "TaskPool.h"
+#include "MappedFile.h"
+#include "ShardPlanner.h"
+#include "SymbolIndex.h"
 
 class InputConverterWorker;
 
@@ -14,7 +21,8 @@ class InputConverter
 {
 public:
     InputConverter(const char *inputPath, const char *outputPath, const char *swosHeaderFile, OutputFormatResolver::OutputFormat format,
-        int numFiles, int extraMemorySize, bool disableOptimizations, bool disableAlignmentChecks, SymbolFileParser& symFileParser);
+        int numFiles, int numThreads, int extraMemorySize, bool disableOptimizations, bool disableAlignmentChecks,
+        bool disableProcCache, bool instrumentProcs, const char *procProfilePath, SymbolFileParser& symFileParser);
     void convert();
 
 private:
@@ -22,33 +30,44 @@ private:
     std::pair<const char *, String> findCodeDataStart() const;
     const char *skipBom(int& length);
     size_t parseCommonPart(int length);
-    size_t parse(int commonPartLength, int blockSize);
+    size_t parse(int commonPartLength, const std::vector<ShardPlanner::Shard>& shards);
     void checkForParsingErrors(size_t lineNo);
 
     using AllowedChunkList = std::vector<int>;
 
     AllowedChunkList connectRanges();
+    void buildSymbolIndex();
     void resolveExterns(const AllowedChunkList& activeChunks);
 
     void collectSegments();
     void consolidateVariables();
+    void findStackNeutralProcs();
+    void loadProcProfile();
+    void initProcCache(int commonPartLength);
+    void saveProcCache();
     void output(const String& commonPrefix, const AllowedChunkList& activeChunks);
     void checkForOutputErrors();
     void checkForUnusedSymbols();
     void outputStructsAndDefines();
-    void waitForWorkers();
+    std::vector<size_t> workersBySize(const AllowedChunkList& activeChunks) const;
+    void timePhase(const char *name, std::function<void()> phase);
+    void showPhaseTimes() const;
     void error(const std::string& desc, size_t lineNo);
 
     int m_numFiles;
     int m_extraMemorySize;
     bool m_disableOptimizations;
     bool m_disableAlignmentChecks;
+    bool m_disableProcCache;
+    bool m_instrumentProcs;
+    const char *m_procProfilePath;
 
     const char *m_inputPath;
     const char *m_outputPath;
     const char *m_headerPath;
     OutputFormatResolver::OutputFormat m_format;
-    std::unique_ptr<const char[]> m_data;
+    MappedFile m_inputFile;
+    const char *m_data = nullptr;
     long m_dataLength = 0;
 
     SymbolFileParser& m_symFileParser;
@@ -58,8 +77,16 @@ private:
     std::unique_ptr<OutputWriter> m_outputWriter;
     DataBank m_dataBank;
 
+    std::unique_ptr<ProcCache> m_procCache;
+    Util::hash64_t m_procCacheContextHash = 0;
+    std::unique_ptr<ProcProfile> m_procProfile;
+
     std::vector<InputConverterWorker *> m_workers;
-    std::vector<std::future<void>> m_futures;
+    SymbolIndex m_symbolIndex;
+    StackNeutralProcs m_stackNeutralProcs;
+    TaskPool m_taskPool;
+
+    std::vector<std::pair<const char *, int64_t>> m_phaseTimes;
 
     std::vector<SymbolTable *> m_symbolTables;
 };
@@ -47,6 +47,9 @@ void InputConverterWorker::output(OutputFormatResolver::OutputFormat format, con
 
     m_outputWriter->setCImportSymbols(m_cImportSymbols);
     m_outputWriter->setCExportSymbols(m_cExportSymbols);
+    m_outputWriter->setProcCache(m_procCache, m_procCacheContextHash);
+    m_outputWriter->setProcProfile(m_procProfile, m_instrumentProcs);
+    m_outputWriter->setStackNeutralProcs(m_stackNeutralProcs);
 
     if (openingSegments.second) {
         const auto& range = m_segments->segmentRange(openingSegments.first);
@@ -57,7 +60,7 @@ void InputConverterWorker::output(OutputFormatResolver::OutputFormat format, con
     m_outputOk = m_outputWriter->output(OutputWriter::kFullDisasembly, openingSegments.first);
 }
 
-void InputConverterWorker::resolveReferences(const std::vector<const InputConverterWorker *>& workers, const SegmentSet& segments,
+void InputConverterWorker::resolveReferences(const SymbolIndex& symbolIndex, const SegmentSet& segments,
     const StructStream& structs, const DefinesMap& defines)
 {
     m_segments = &segments;
@@ -65,9 +68,7 @@ void InputConverterWorker::resolveReferences(const std::vector<const InputConver
     m_parser.references().resolveSegments(segments);
     resolveStructsAndDefines(structs, defines);
 
-    for (auto worker : workers)
-        if (worker != this)
-            m_parser.references().resolve(worker->m_parser.references());
+    symbolIndex.resolve(m_parser.references());
 
     if (m_dataBank)
         m_varData = m_dataBank->processRegion(m_parser.outputItems(), structs, defines);
@@ -88,6 +89,23 @@ void InputConverterWorker::setDataBank(DataBank *dataBank)
     m_dataBank = dataBank;
 }
 
+void InputConverterWorker::setProcCache(ProcCache *procCache, Util::hash64_t contextHash)
+{
+    m_procCache = procCache;
+    m_procCacheContextHash = contextHash;
+}
+
+void InputConverterWorker::setProcProfile(const ProcProfile *procProfile, bool instrumentProcs)
+{
+    m_procProfile = procProfile;
+    m_instrumentProcs = instrumentProcs;
+}
+
+void InputConverterWorker::setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs)
+{
+    m_stackNeutralProcs = stackNeutralProcs;
+}
+
 DataBank::VarData&& InputConverterWorker::variables()
 {
     return std::move(m_varData);
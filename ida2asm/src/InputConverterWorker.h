@@ -5,6 +5,7 @@
 #include "IdaAsmParser.h"
 #include "Struct.h"
 #include "DefinesMap.h"
+#include "SymbolIndex.h"
 #include "OutputWriter/OutputFactory.h"
 #include "OutputWriter/CppOutput/DataBank.h"
 
@@ -17,11 +18,14 @@ public:
     void output(OutputFormatResolver::OutputFormat format, const char *path, int extraMemorySize, bool disableOptimizations,
         bool disableAlignmentChecks, const StructStream& structs, const DefinesMap& defines, const std::string& prefix,
         std::pair<CToken *, bool> openSegment);
-    void resolveReferences(const std::vector<const InputConverterWorker *>& workers, const SegmentSet& segments,
-        const StructStream& structs, const DefinesMap& defines);
+    void resolveReferences(const SymbolIndex& symbolIndex, const SegmentSet& segments, const StructStream& structs,
+        const DefinesMap& defines);
     void setCImportSymbols(const StringSet& syms);
     void setCExportSymbols(const StringList& syms);
     void setDataBank(DataBank *dataBank);
+    void setProcCache(ProcCache *procCache, Util::hash64_t contextHash);
+    void setProcProfile(const ProcProfile *procProfile, bool instrumentProcs);
+    void setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs);
     DataBank::VarData&& variables();
     std::pair<bool, bool> noBreakTagState() const;
     bool outputOk() const;
@@ -61,6 +65,12 @@ private:
     const StringList *m_cExportSymbols = nullptr;
 
     DataBank *m_dataBank = nullptr;
+
+    ProcCache *m_procCache = nullptr;
+    Util::hash64_t m_procCacheContextHash = 0;
+    const ProcProfile *m_procProfile = nullptr;
+    bool m_instrumentProcs = false;
+    const StackNeutralProcs *m_stackNeutralProcs = nullptr;
     DataBank::VarData m_varData;
 
     std::string m_filename;
@@ -137,11 +137,10 @@ const SymbolTable & SymbolFileParser::symbolTable() const
     return m_symbolTable;
 }
 
+// Header is included all over the place, so don't touch it unless it changed.
 void SymbolFileParser::outputHeaderFile(const char *path)
 {
-    m_headerFile = fopen(path, "w");
-    if (!m_headerFile)
-        Util::exit("Could not open %s for write", EXIT_FAILURE, path);
+    m_headerContents.clear();
 
     xfwrite(kHeader);
 
@@ -158,7 +157,8 @@ void SymbolFileParser::outputHeaderFile(const char *path)
     if (!m_cppOutput)
         xfwrite("}\n");
 
-    fclose(m_headerFile);
+    if (Util::writeFileIfChanged(path, m_headerContents.data(), m_headerContents.size(), true) == Util::kWriteFailed)
+        Util::exit("Error writing %s", EXIT_FAILURE, path);
 }
 
 const StringList& SymbolFileParser::exports() const
@@ -1120,10 +1120,7 @@ void SymbolFileParser::commaExpectedError() const
 
 void SymbolFileParser::xfwrite(const char *buf, size_t len)
 {
-    assert(m_headerFile);
-
-    if (fwrite(buf, len, 1, m_headerFile) != 1)
-        Util::exit("Error writing %s", EXIT_FAILURE, m_headerPath);
+    m_headerContents.append(buf, len);
 }
 
 void SymbolFileParser::xfwrite(const String& str)
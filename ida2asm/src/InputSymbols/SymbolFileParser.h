@@ -179,7 +179,7 @@ private:
     std::unique_ptr<const char[]> m_data;
     size_t m_dataSize = 0;
     size_t m_lineNo = 1;
-    FILE *m_headerFile = nullptr;
+    std::string m_headerContents;
 
     StringList m_exports;
     StringSet m_imports;
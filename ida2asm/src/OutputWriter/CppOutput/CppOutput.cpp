@@ -27,6 +27,35 @@ void CppOutput::setCExportSymbols(const StringList *syms)
     m_cExportSymbols = syms;
 }
 
+// Context hash covers everything global that affects the generated code, here we add what's specific to this file:
+// types of the symbols defined and referenced by it.
+void CppOutput::setProcCache(ProcCache *procCache, Util::hash64_t contextHash)
+{
+    m_procCache = procCache;
+
+    // order independent, whatever order the references come in
+    Util::hash64_t symbolsHash = 0;
+
+    for (const auto& [name, refType, customType, refProc] : m_references.externs())
+        symbolsHash += Util::hash64Value(refType, Util::hash64(name.data(), name.length()));
+    for (const auto& name : m_references.publics())
+        symbolsHash += Util::hash64(name.data(), name.length(), 1);
+
+    m_contextHash = Util::hash64Value(symbolsHash, contextHash);
+}
+
+void CppOutput::setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs)
+{
+    m_stackNeutralProcs = stackNeutralProcs;
+    m_irConverter.setStackNeutralProcs(stackNeutralProcs);
+}
+
+void CppOutput::setProcProfile(const ProcProfile *procProfile, bool instrumentProcs)
+{
+    m_procProfile = procProfile;
+    m_instrumentProcs = instrumentProcs;
+}
+
 bool CppOutput::output(OutputFlags flags, CToken *)
 {
     // we'll need a bigger output buffer to accommodate large number of C++ statements per line
@@ -205,9 +234,14 @@ void CppOutput::outputCodeAndData(OutputFlags flags)
     runFirstPass(flags);
 
     const auto& instructions = m_irConverter.instructions();
+    auto cachedProc = m_cachedProcs.begin();
+
     for (auto it = instructions.begin(); it != instructions.end(); ++it) {
         auto isLastItem = it + 1 == instructions.end();
 
+        for (; cachedProc != m_cachedProcs.end() && cachedProc->first == it - instructions.begin(); ++cachedProc)
+            outputCachedProc(*cachedProc->second);
+
         if (it->deleted)
             continue;
 
@@ -236,39 +270,70 @@ void CppOutput::outputCodeAndData(OutputFlags flags)
         }
     }
 
+    for (; cachedProc != m_cachedProcs.end(); ++cachedProc)
+        outputCachedProc(*cachedProc->second);
+
     if (m_insideProc)
         out('}', Util::kNewLine);
 }
 
 // Since assembler might reference labels without declaring them first, we'll simply forward declare all the data.
 // Also divide labels into global (outside a proc) and local (inside a proc).
+// Procs found in the cache are not converted at all, their code is simply inserted at the right spot in the output.
 void CppOutput::runFirstPass(OutputFlags flags)
 {
-    bool inProc = false;
+    bool procCached = false;
 
     out(Util::kNewLine, "// first pass forward declarations", Util::kNewLine);
 
+    // labels go first since they are a part of proc fingerprints
+    collectInProcLabels();
+
     for (const auto& item : m_outputItems) {
         switch (item.type()) {
         case OutputItem::kProc:
             {
                 auto proc = item.getItem<Proc>();
                 out("void ", proc->name(), "();", Util::kNewLine);
-                inProc = true;
-                m_irConverter.convertProc(&item, m_outputItems.end());
+
+                auto cachedCode = findCachedProc(&item);
+                procCached = cachedCode != nullptr;
+
+                if (procCached)
+                    m_cachedProcs.emplace_back(m_irConverter.instructions().size(), cachedCode);
+                else
+                    m_irConverter.convertProc(&item, m_outputItems.end());
             }
             break;
         case OutputItem::kEndProc:
-            {
-                inProc = false;
+            if (!procCached) {
                 auto fallThroughFunction = m_irConverter.instructions().back().label;
                 if (fallThroughFunction && (&item == m_outputItems.end() || item.next()->type() != OutputItem::kProc ||
                     item.next()->getItem<Proc>()->name() != fallThroughFunction))
                     throw OutputException("missing fallthrough function " + fallThroughFunction.string(),
                         getOutputFilename(flags).c_str());
-
             }
             break;
+        }
+    }
+
+    out(Util::kNewLine);
+
+    m_irConverter.optimizeFlags();
+}
+
+void CppOutput::collectInProcLabels()
+{
+    bool inProc = false;
+
+    for (const auto& item : m_outputItems) {
+        switch (item.type()) {
+        case OutputItem::kProc:
+            inProc = true;
+            break;
+        case OutputItem::kEndProc:
+            inProc = false;
+            break;
         case OutputItem::kLabel:
             if (inProc) {
                 auto label = item.getItem<Label>();
@@ -279,11 +344,81 @@ void CppOutput::runFirstPass(OutputFlags flags)
         }
     }
 
-    out(Util::kNewLine);
-
     m_inProcLabels.seal();
+}
 
-    m_irConverter.optimizeFlags();
+// Returns code generated for the proc in one of the previous runs, if it's still valid. Otherwise remembers
+// the fingerprint so the proc can be added to the cache once it's converted.
+const std::string *CppOutput::findCachedProc(const OutputItem *item)
+{
+    if (!m_procCache)
+        return nullptr;
+
+    auto key = procFingerprint(item);
+
+    auto code = m_procCache->find(key, item->getItem<Proc>()->name());
+    if (!code)
+        m_convertedProcKeys.push_back(key);
+
+    return code;
+}
+
+// Proc items are self-contained (all the text is copied into them, no pointers) so their memory can be hashed
+// directly. That includes the effects of the symbol file actions, since they are applied during parsing.
+// Add anything from outside of the proc that changes its output: whether the jump targets are labels or procs,
+// which procs are imported or stack neutral, which proc follows in case execution falls through, and how hot the
+// proc is.
+ProcCache::Key CppOutput::procFingerprint(const OutputItem *item) const
+{
+    assert(item->type() == OutputItem::kProc);
+
+    auto hash = m_contextHash;
+    auto procStart = item;
+
+    if (m_procProfile)
+        hash = Util::hash64Value(m_procProfile->classify(item->getItem<Proc>()->name()), hash);
+
+    auto hashTarget = [this, &hash](const String& target) {
+        hash = Util::hash64Value(m_inProcLabels.present(target), hash);
+        hash = Util::hash64Value(m_symFileParser.isImport(target), hash);
+        if (m_stackNeutralProcs)
+            hash = Util::hash64Value(m_stackNeutralProcs->isNeutral(target), hash);
+    };
+
+    for (; item != m_outputItems.end() && item->type() != OutputItem::kEndProc; item = item->next()) {
+        if (item->type() == OutputItem::kInstruction) {
+            auto instruction = item->getItem<Instruction>();
+            if (instruction->isBranch() && instruction->numOperands() == 1)
+                if (const auto& target = instruction->getBranchTarget())
+                    hashTarget(target);
+        }
+    }
+
+    if (item != m_outputItems.end()) {
+        item = item->next();
+        hash = Util::hash64(procStart, reinterpret_cast<const char *>(item) - reinterpret_cast<const char *>(procStart), hash);
+
+        while (item != m_outputItems.end() && item->type() != OutputItem::kProc)
+            item = item->next();
+
+        if (item != m_outputItems.end()) {
+            const auto& nextProc = item->getItem<Proc>()->name();
+            hash = Util::hash64(nextProc.data(), nextProc.length(), hash);
+            hashTarget(nextProc);
+        }
+    }
+
+    return hash;
+}
+
+void CppOutput::outputCachedProc(const std::string& code)
+{
+    if (m_insideProc) {
+        out('}', Util::kDoubleNewLine);
+        m_insideProc = false;
+    }
+
+    out(String(code.data(), code.size()));
 }
 
 void CppOutput::outputInstruction(const InstructionNode& node)
@@ -319,6 +454,8 @@ void CppOutput::outputProcStart(const InstructionNode& node)
         out('}', Util::kDoubleNewLine);
 
     m_insideProc = true;
+    m_procCodeStart = outputLength();
+    m_currentProcName = node.label;
 
     const auto& leadingComments = node.leadingComments.trimmed();
     outputComment(leadingComments);
@@ -326,12 +463,42 @@ void CppOutput::outputProcStart(const InstructionNode& node)
     if (leadingComments)
         out("//", Util::kNewLine);
 
+    outputProcClass(node.label);
     out("void ", node.label, "()", Util::kNewLine, '{', Util::kNewLine);
 
+    if (node.numStackSlots) {
+        out(kIndent, "int32_t ");
+        for (int i = 0; i < node.numStackSlots; i++)
+            out(i ? ", " : "", kStackSlotPrefix, i, " = 0");
+        out(';', Util::kNewLine);
+    }
+
+    // count entries only, start label is a target of the jumps from within the proc
+    if (m_instrumentProcs)
+        out(kIndent, "SWOS_PROFILE_PROC(\"", node.label, "\");", Util::kNewLine);
+
     if (node.needsStartLabel)
         out(kStartLabel, ":;", Util::kNewLine);
 }
 
+// Procs that take up most of the execution time get optimized harder, and the ones that never ran get moved
+// out of the way (both only with compilers that support it, see vm.h).
+void CppOutput::outputProcClass(const String& procName)
+{
+    if (m_procProfile) {
+        switch (m_procProfile->classify(procName)) {
+        case ProcProfile::kHot:
+            out("SWOS_HOT_PROC ");
+            break;
+        case ProcProfile::kCold:
+            out("SWOS_COLD_PROC ");
+            break;
+        default:
+            break;
+        }
+    }
+}
+
 void CppOutput::outputEndProc(const InstructionNode& node)
 {
     assert(m_insideProc);
@@ -351,6 +518,13 @@ void CppOutput::outputEndProc(const InstructionNode& node)
     }
 
     out('}', Util::kDoubleNewLine);
+
+    if (m_procCache) {
+        assert(m_currentProc < m_convertedProcKeys.size());
+
+        auto procCode = getOutputPtr() - (outputLength() - m_procCodeStart);
+        m_procCache->add(m_convertedProcKeys[m_currentProc++], m_currentProcName, procCode, outputLength() - m_procCodeStart);
+    }
 }
 
 void CppOutput::outputLabel(const InstructionNode& node)
@@ -366,6 +540,10 @@ void CppOutput::outputLabel(const InstructionNode& node)
 
         outputLabel(node.label);
         out(":;");
+
+        // labels are as close as we get to basic blocks
+        if (m_instrumentProcs)
+            out(Util::kNewLine, kIndent, "SWOS_PROFILE_BLOCK(\"", m_currentProcName, "\", \"", node.label, "\");");
     } else {
         out("// ", node.label);
     }
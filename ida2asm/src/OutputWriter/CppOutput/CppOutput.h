@@ -6,6 +6,8 @@
 #include "IntermediateFormConverter.h"
 #include "DataBank.h"
 #include "X86InstructionWriter.h"
+#include "ProcCache.h"
+#include "ProcProfile.h"
 
 class CppOutput : public OutputWriter
 {
@@ -17,6 +19,9 @@ public:
     void setCImportSymbols(const StringSet *syms) override;
     void setCExportSymbols(const StringList *syms) override;
     void setDisassemblyPrefix(const std::string& prefix) override {}
+    void setProcCache(ProcCache *procCache, Util::hash64_t contextHash) override;
+    void setProcProfile(const ProcProfile *procProfile, bool instrumentProcs) override;
+    void setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs) override;
     bool output(OutputFlags flags, CToken *openingSegment = nullptr) override;
     const char *getDefsFilename() const override;
     std::string segmentDirective(const TokenRange&) const override { return {}; }
@@ -33,9 +38,14 @@ private:
     void outputCodeAndData(OutputFlags flags);
 
     void runFirstPass(OutputFlags flags);
+    void collectInProcLabels();
+    const std::string *findCachedProc(const OutputItem *item);
+    ProcCache::Key procFingerprint(const OutputItem *item) const;
+    void outputCachedProc(const std::string& code);
 
     void outputInstruction(const InstructionNode& node);
     void outputProcStart(const InstructionNode& node);
+    void outputProcClass(const String& procName);
     void outputEndProc(const InstructionNode& node);
     void outputLabel(const InstructionNode& node);
     void outputLabel(const String& label);
@@ -49,6 +59,7 @@ private:
     void outputComment(const String& comment, bool endWithNewLine = true);
 
     static constexpr char kStartLabel[] = "_l_start";
+    static constexpr char kStackSlotPrefix[] = "stackSlot";
 
     const StringSet *m_cImportSymbols = nullptr;
     const StringList *m_cExportSymbols = nullptr;
@@ -66,6 +77,18 @@ private:
 
     std::vector<std::pair<const OutputItem *, const OutputItem *>> m_tableVarRanges;
 
+    ProcCache *m_procCache = nullptr;
+    Util::hash64_t m_contextHash = 0;
+    std::vector<std::pair<size_t, const std::string *>> m_cachedProcs;  // instruction index to insert at, code
+    std::vector<ProcCache::Key> m_convertedProcKeys;
+    size_t m_currentProc = 0;
+    size_t m_procCodeStart = 0;
+    String m_currentProcName;
+
+    const ProcProfile *m_procProfile = nullptr;
+    const StackNeutralProcs *m_stackNeutralProcs = nullptr;
+    bool m_instrumentProcs = false;
+
     friend class X86InstructionWriter;
     friend class OpWriter;
 };
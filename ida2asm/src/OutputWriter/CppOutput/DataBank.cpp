@@ -177,11 +177,62 @@ int DataBank::getProcOffset(const String& varName) const
     return varInfo->index;
 }
 
+// Returns the proc table which contains the given address, if any.
+auto DataBank::procTableAt(size_t address) const -> const ProcTable *
+{
+    auto it = std::upper_bound(m_procTables.begin(), m_procTables.end(), address, [](size_t address, const auto& table) {
+        return address < table.address;
+    });
+
+    if (it == m_procTables.begin())
+        return nullptr;
+
+    --it;
+    return address < it->address + it->size ? &*it : nullptr;
+}
+
 const PascalString *DataBank::structNameFromVar(const String& varName) const
 {
     return m_globalStructVarMap.get(varName);
 }
 
+// Fingerprint of everything about the variables and procs that ends up in the generated code (names, addresses,
+// sizes and proc indices), but not the initial values.
+Util::hash64_t DataBank::layoutHash() const
+{
+    auto hash = Util::kInitialHash64Value;
+
+    traverseVars([&hash](const Var& var) {
+        hash = Util::hash64(var.name.data(), var.name.length(), hash);
+        hash = Util::hash64Value(var.type, hash);
+        hash = Util::hash64Value(var.offset, hash);
+        hash = Util::hash64Value(var.size, hash);
+        hash = Util::hash64Value(var.dup, hash);
+        hash = Util::hash64Value(var.declaredSize(), hash);
+        hash = Util::hash64(var.exportedDecl.data(), var.exportedDecl.length(), hash);
+    });
+
+    // proc map order is not significant, so combine them in an order independent way
+    Util::hash64_t procsHash = 0;
+
+    traverseProcs([&procsHash](const String& procName, bool imported, int index) {
+        auto procHash = Util::hash64(procName.data(), procName.length());
+        procHash = Util::hash64Value(imported, procHash);
+        procsHash += Util::hash64Value(index, procHash);
+    });
+
+    hash = Util::hash64Value(procsHash, hash);
+
+    // contents of proc tables end up in the code as well
+    for (const auto& table : m_procTables) {
+        hash = Util::hash64Value(table.address, hash);
+        for (const auto& proc : table.procs)
+            hash = Util::hash64(proc.data(), proc.length(), hash);
+    }
+
+    return hash;
+}
+
 void DataBank::traverseVars(std::function<bool(const Var& var, const Var *next)> f) const
 {
     for (const auto& varList : m_vars) {
@@ -211,6 +262,12 @@ void DataBank::traverseProcs(std::function<void(const String& procName, bool imp
         f(procVar.text, procVar.cargo->imported, procVar.cargo->index);
 }
 
+void DataBank::traverseProcTables(std::function<void(const ProcTable& table)> f) const
+{
+    for (const auto& table : m_procTables)
+        f(table);
+}
+
 void DataBank::addVariable(const OutputItem& item, const DataItem *dataItem, const StructStream& structs,
     const DefinesMap& defines, VarList& varList)
 {
@@ -412,6 +469,7 @@ void DataBank::consolidateOffsetVariables()
     filterPotentialProcOffsetList();
     fillExportedProcs();
     fillProcIndicesAndFixupVars();
+    fillProcTables();
 }
 
 // Merges introduced variables from @constant-to-variable to real, parsed variables.
@@ -574,3 +632,49 @@ void DataBank::fillProcIndicesAndFixupVars()
 
     m_procToIndex.seal();
 }
+
+// Proc pointers are plain ints by now, so go by the variables that used to hold them. A table starts at a named
+// variable and runs through the unnamed elements that follow it, as long as they are all proc pointers.
+void DataBank::fillProcTables()
+{
+    std::unordered_map<const Var *, const String *> procPointers;
+
+    for (const auto& proc : m_procs)
+        if (proc.second.var)
+            procPointers.emplace(proc.second.var, &proc.first);
+
+    m_procTables.clear();
+
+    for (const auto& varList : m_vars) {
+        bool insideTable = false;
+
+        for (const auto& var : varList) {
+            auto proc = procPointers.find(&var);
+
+            if (proc == procPointers.end()) {
+                insideTable = false;
+                continue;
+            }
+
+            if (var.name) {
+                m_procTables.push_back({ var.offset, 0, {} });
+                insideTable = true;
+            }
+
+            if (insideTable) {
+                auto& table = m_procTables.back();
+                table.size += var.size * var.dup;
+                table.procs.push_back(*proc->second);
+            }
+        }
+    }
+
+    for (auto& table : m_procTables) {
+        std::sort(table.procs.begin(), table.procs.end());
+        table.procs.erase(std::unique(table.procs.begin(), table.procs.end()), table.procs.end());
+    }
+
+    std::sort(m_procTables.begin(), m_procTables.end(), [](const auto& table1, const auto& table2) {
+        return table1.address < table2.address;
+    });
+}
@@ -58,6 +58,14 @@ public:
     };
     using OffsetMap = StringMap<OffsetReference>;
 
+    // run of consecutive `dd offset proc' elements, as found in IDA's jump and call tables
+    struct ProcTable
+    {
+        size_t address;
+        size_t size;
+        std::vector<String> procs;      // distinct procs, sorted by name
+    };
+
     using VarList = std::vector<Var>;
     using StructVarsMap = StringMap<PascalString>;
     using VarData = std::tuple<VarList, StructVarsMap, OffsetMap>;
@@ -75,11 +83,14 @@ public:
     size_t getVarOffset(const String& varName) const;
     bool isVariable(const String& name) const;
     int getProcOffset(const String& varName) const;
+    const ProcTable *procTableAt(size_t address) const;
     const PascalString *structNameFromVar(const String& varName) const;
+    Util::hash64_t layoutHash() const;
 
     void traverseVars(std::function<bool(const Var& var, const Var *next)> f) const;
     void traverseVars(std::function<void(const Var& var)> f) const;
     void traverseProcs(std::function<void(const String& procName, bool imported, int index)> f) const;
+    void traverseProcTables(std::function<void(const ProcTable& table)> f) const;
 
 private:
     static void addVariable(const OutputItem& item, const DataItem *dataItem, const StructStream& structs,
@@ -100,6 +111,7 @@ private:
     void filterPotentialProcOffsetList();
     void fillExportedProcs();
     void fillProcIndicesAndFixupVars();
+    void fillProcTables();
 
     const SymbolFileParser& m_symFileParser;
 
@@ -108,6 +120,7 @@ private:
     OffsetMap m_globalOffsetMap;
     std::vector<std::pair<String, OffsetReference>> m_procs;
     OffsetMap m_procToIndex;
+    std::vector<ProcTable> m_procTables;    // sorted by address
 
     size_t m_memoryByteSize;
     size_t m_numProcPointers;
@@ -42,6 +42,15 @@ struct InstructionNode
     bool startOverJump = false;
     bool returnJump = false;
 
+    int stackSlot = -1;         // push/pop goes to this local variable instead of the VM stack
+    int numStackSlots = 0;      // number of those variables in the proc, set in proc node
+
+    int procTable = -1;         // address of the proc table an indirect call/jump target was loaded from
+
+    enum FlagBits : int8_t { kCarryFlag = 1, kZeroFlag = 2, kSignFlag = 4, kOverflowFlag = 8 };
+    int8_t constantFlags = -1;  // flags set by cmp/test on values known at conversion time
+    bool alwaysTaken = false;   // conditional jump whose condition is known to hold
+
     bool suppressCarryFlag = false;
     bool suppressOverflowFlag = false;
     bool suppressSignFlag = false;
@@ -75,6 +75,11 @@ void IntermediateFormConverter::fillStructInfo(const StructStream& structs)
     m_structMap.seal();
 }
 
+void IntermediateFormConverter::setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs)
+{
+    m_stackNeutralProcs = stackNeutralProcs;
+}
+
 void IntermediateFormConverter::convertProc(const OutputItem *item, const OutputItem *end)
 {
     assert(item && item->type() == OutputItem::kProc);
@@ -84,8 +89,11 @@ void IntermediateFormConverter::convertProc(const OutputItem *item, const Output
     markJumpTargetInstructions(instructionStartIndex, labels);
     assert(instructionStartIndex < m_instructions.size());
 
-    if (!m_disableOptimizations)
+    if (!m_disableOptimizations) {
         m_optimizer.markRedundantProcInstructions(m_instructions, instructionStartIndex, m_instructions.size() - 1);
+        localizeStackSlots(instructionStartIndex, m_instructions.size() - 1);
+        findProcTableDispatches(instructionStartIndex, m_instructions.size() - 1);
+    }
 }
 
 void IntermediateFormConverter::optimizeFlags()
@@ -223,3 +231,111 @@ void IntermediateFormConverter::markJumpTargetInstructions(size_t start, const L
         }
     }
 }
+
+// Pushes and pops of a balanced proc become assignments to local variables, one for each stack depth, as long as
+// nobody else gets to look at the stack meanwhile: only stack neutral procs may be called while anything's pushed.
+// Pushes and pops in unreachable code (unknown depth) are left alone, it doesn't matter what they do.
+void IntermediateFormConverter::localizeStackSlots(size_t start, size_t end)
+{
+    if (!m_stackNeutralProcs)
+        return;
+
+    m_stackAnalyzer.analyze(m_instructions, start, end);
+
+    auto numSlots = m_stackAnalyzer.maxDepth();
+    if (!m_stackAnalyzer.balanced() || m_stackAnalyzer.usesBulkStackInstructions() || !numSlots || numSlots > kMaxStackSlots)
+        return;
+
+    for (const auto& target : m_stackAnalyzer.callTargets())
+        if (target.depth && !m_stackNeutralProcs->isNeutral(target.name))
+            return;
+
+    auto isStackInstruction = [this](size_t i, Token::Type type) {
+        const auto& node = m_instructions[i];
+        return node.instruction && !node.deleted && node.instruction->type() == type &&
+            m_stackAnalyzer.depthAt(i) != StackDepthAnalyzer::kUnknownDepth;
+    };
+
+    // popping into memory or a word register needs the full treatment
+    for (auto i = start + 1; i < end; i++) {
+        const auto& dst = m_instructions[i].opInfo[0];
+        if (isStackInstruction(i, Token::T_POP) && (dst.size() == 2 || dst.needsMemoryFetch()))
+            return;
+    }
+
+    for (auto i = start + 1; i < end; i++) {
+        if (isStackInstruction(i, Token::T_PUSH))
+            m_instructions[i].stackSlot = m_stackAnalyzer.depthAt(i);
+        else if (isStackInstruction(i, Token::T_POP))
+            m_instructions[i].stackSlot = m_stackAnalyzer.depthAt(i) - 1;
+    }
+
+    m_instructions[start].numStackSlots = numSlots;
+}
+
+// Indirect calls and jumps that got their target from a proc table can dispatch directly to the procs in it instead
+// of going through invokeProc(). Memory might have changed since the conversion, so this only gives the writer the
+// candidates, it still needs to fall back to invokeProc() for anything else.
+void IntermediateFormConverter::findProcTableDispatches(size_t start, size_t end)
+{
+    for (auto i = start + 1; i < end; i++) {
+        auto& node = m_instructions[i];
+        auto instruction = node.instruction;
+
+        if (node.type != OutputItem::kInstruction || node.deleted || !instruction->isBranch() ||
+            instruction->numOperands() != 1)
+            continue;
+
+        if (const auto& target = instruction->getBranchTarget())
+            node.procTable = findProcTable(i, start, target);
+    }
+}
+
+// Looks back through the basic block for the mov that loaded the target, following register to register moves.
+// Labels, branches and anything else writing to the target end the search.
+int IntermediateFormConverter::findProcTable(size_t index, size_t start, String target) const
+{
+    for (auto i = index; i > start + 1 && index - i < kMaxProcTableLookback; ) {
+        const auto& node = m_instructions[--i];
+
+        if (node.type != OutputItem::kInstruction)
+            return -1;
+
+        auto instruction = node.instruction;
+        if (instruction->isBranch())
+            return -1;
+
+        if (!instruction->numOperands() || singleTokenOperand(instruction, 0) != target)
+            continue;
+
+        if (instruction->type() != Token::T_MOV || instruction->numOperands() != 2)
+            return -1;
+
+        const auto& src = node.opInfo[1];
+
+        if (src.isRegister()) {
+            target = singleTokenOperand(instruction, 1);
+            if (!target)
+                return -1;
+        } else {
+            if ((src.isFixedMem() || src.isDynamicMem()) && src.memSize == 4 && src.displacement.num &&
+                m_dataBank.procTableAt(*src.displacement.num))
+                return *src.displacement.num;
+
+            return -1;
+        }
+    }
+
+    return -1;
+}
+
+String IntermediateFormConverter::singleTokenOperand(const Instruction *instruction, size_t index)
+{
+    const auto& operand = instruction->operands()[index];
+    auto op = operand.begin();
+
+    if (op == operand.end() || op->next() != operand.end())
+        return {};
+
+    return op->text();
+}
@@ -7,12 +7,15 @@
 #include "Struct.h"
 #include "DataBank.h"
 #include "RedundantInstructionRemover.h"
+#include "StackDepthAnalyzer.h"
+#include "StackNeutralProcs.h"
 
 class IntermediateFormConverter
 {
 public:
     IntermediateFormConverter(bool disableOptimizations, const StructStream& structs, const DefinesMap& defines,
         const References& references, const DataBank& dataBank);
+    void setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs);
     void convertProc(const OutputItem *item, const OutputItem *end);
     void optimizeFlags();
     const Instructions& instructions() const;
@@ -25,6 +28,13 @@ private:
 
     LabelList gatherLabels(size_t start, const OutputItem *item);
     void markJumpTargetInstructions(size_t start, const LabelList& labels);
+    void localizeStackSlots(size_t start, size_t end);
+    void findProcTableDispatches(size_t start, size_t end);
+    int findProcTable(size_t index, size_t start, String target) const;
+    static String singleTokenOperand(const Instruction *instruction, size_t index);
+
+    static constexpr int kMaxStackSlots = 32;
+    static constexpr int kMaxProcTableLookback = 16;
 
     bool m_disableOptimizations;
 
@@ -35,6 +45,8 @@ private:
 
     Instructions m_instructions;
     RedundantInstructionRemover m_optimizer;
+    StackDepthAnalyzer m_stackAnalyzer;
+    const StackNeutralProcs *m_stackNeutralProcs = nullptr;
 
     StructMap m_structMap;
 };
@@ -0,0 +1,119 @@
+#include "ProcCache.h"
+
+ProcCache::ProcCache(const std::string& path)
+    : m_path(path)
+{
+}
+
+// Missing or damaged cache is not an error, everything will simply get converted again.
+void ProcCache::load()
+{
+    auto f = fopen(m_path.c_str(), "rb");
+    if (!f)
+        return;
+
+    std::setbuf(f, nullptr);
+
+    auto readValue = [f](auto& value) {
+        return fread(&value, sizeof(value), 1, f) == 1;
+    };
+    auto readString = [f](std::string& str, uint32_t length) {
+        str.resize(length);
+        return !length || fread(&str[0], length, 1, f) == 1;
+    };
+
+    char magic[sizeof(kMagic)];
+    uint32_t version, numEntries;
+
+    bool ok = fread(magic, sizeof(magic), 1, f) == 1 && !memcmp(magic, kMagic, sizeof(kMagic)) &&
+        readValue(version) && version == kVersion && readValue(numEntries);
+
+    for (uint32_t i = 0; ok && i < numEntries; i++) {
+        Key key;
+        uint32_t nameLength, textLength;
+        Entry entry;
+
+        ok = readValue(key) && readValue(nameLength) && readValue(textLength) &&
+            readString(entry.procName, nameLength) && readString(entry.text, textLength);
+
+        if (ok)
+            m_entries.emplace(key, std::move(entry));
+    }
+
+    fclose(f);
+
+    if (!ok) {
+        std::cout << "Ignoring corrupt proc cache " << m_path << '\n';
+        m_entries.clear();
+    }
+}
+
+// Only the entries used in this run survive, so the cache doesn't keep growing. Entries are written sorted
+// so that the unchanged cache results in an identical file.
+bool ProcCache::save()
+{
+    std::vector<std::pair<Key, const Entry *>> entries;
+    std::string data(kMagic, sizeof(kMagic));
+
+    for (const auto& [key, entry] : m_entries)
+        if (entry.used)
+            entries.emplace_back(key, &entry);
+
+    std::sort(entries.begin(), entries.end(), [](const auto& e1, const auto& e2) { return e1.first < e2.first; });
+
+    auto appendValue = [&data](auto value) {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    };
+
+    appendValue(kVersion);
+    appendValue(static_cast<uint32_t>(entries.size()));
+
+    for (const auto& [key, entry] : entries) {
+        appendValue(key);
+        appendValue(static_cast<uint32_t>(entry->procName.size()));
+        appendValue(static_cast<uint32_t>(entry->text.size()));
+        data += entry->procName;
+        data += entry->text;
+    }
+
+    return Util::writeFileIfChanged(m_path.c_str(), data.data(), data.size()) != Util::kWriteFailed;
+}
+
+// Returns cached code for the proc, or null if there isn't any. Proc name is checked too, just in case.
+const std::string *ProcCache::find(Key key, const String& procName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second.procName.size() != procName.length() ||
+        memcmp(it->second.procName.data(), procName.data(), procName.length())) {
+        m_numMisses++;
+        return nullptr;
+    }
+
+    m_numHits++;
+    it->second.used = true;
+
+    // unordered_map never moves its elements so this stays valid while others are being added
+    return &it->second.text;
+}
+
+void ProcCache::add(Key key, const String& procName, const char *text, size_t length)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto& entry = m_entries[key];
+    entry.procName.assign(procName.data(), procName.length());
+    entry.text.assign(text, length);
+    entry.used = true;
+}
+
+size_t ProcCache::numHits() const
+{
+    return m_numHits;
+}
+
+size_t ProcCache::numMisses() const
+{
+    return m_numMisses;
+}
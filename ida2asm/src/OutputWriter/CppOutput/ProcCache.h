@@ -0,0 +1,44 @@
+#pragma once
+
+// Keeps C++ code generated for each proc between runs, keyed by a fingerprint of everything that goes into
+// converting the proc. Procs whose fingerprint didn't change are copied from the cache instead of being converted.
+// Lookups and additions are thread safe, all the output writers share a single cache.
+class ProcCache
+{
+public:
+    using Key = Util::hash64_t;
+
+    // Version of the C++ code generator, part of every key. Bump it with each change to the converter that alters
+    // generated code (instruction output, optimizations, externs, runtime interface...), otherwise stale procs
+    // will keep getting copied from the cache.
+    static constexpr uint32_t kGeneratorVersion = 2;
+
+    ProcCache(const std::string& path);
+    void load();
+    bool save();
+
+    const std::string *find(Key key, const String& procName);
+    void add(Key key, const String& procName, const char *text, size_t length);
+
+    size_t numHits() const;
+    size_t numMisses() const;
+
+private:
+    struct Entry {
+        std::string procName;
+        std::string text;
+        bool used = false;
+    };
+
+    static constexpr char kMagic[] = "ida2asm proc cache";
+    // version of the cache file format
+    static constexpr uint32_t kVersion = 2;
+
+    std::string m_path;
+
+    std::unordered_map<Key, Entry> m_entries;
+    std::mutex m_mutex;
+
+    std::atomic<size_t> m_numHits{ 0 };
+    std::atomic<size_t> m_numMisses{ 0 };
+};
@@ -0,0 +1,85 @@
+#include "ProcProfile.h"
+
+ProcProfile::ProcProfile(const char *path)
+    : m_path(path)
+{
+}
+
+// Unlike the proc cache, profile is explicitly requested, so failing to read it is fatal.
+void ProcProfile::load()
+{
+    auto f = fopen(m_path.c_str(), "r");
+    if (!f)
+        Util::exit("Could not open proc profile: %s\n", EXIT_FAILURE, m_path.c_str());
+
+    char line[1024];
+    size_t lineNo = 1;
+
+    while (fgets(line, sizeof(line), f))
+        parseLine(line, lineNo++);
+
+    fclose(f);
+
+    if (!m_totalCount)
+        Util::exit("Proc profile %s doesn't contain any executions\n", EXIT_FAILURE, m_path.c_str());
+
+    selectHotProcs();
+}
+
+// Procs that aren't in the profile at all were never entered, so it's safe to assume they're cold.
+auto ProcProfile::classify(const String& procName) const -> ProcClass
+{
+    const auto& name = procName.string();
+
+    if (m_hotProcs.count(name))
+        return kHot;
+
+    return m_procCounts.count(name) ? kNormal : kCold;
+}
+
+void ProcProfile::showReport() const
+{
+    std::cout << "Proc profile: " << m_procCounts.size() << " procs executed, " << m_hotProcs.size() << " hot\n";
+}
+
+void ProcProfile::parseLine(const char *line, size_t lineNo)
+{
+    char proc[256], label[256];
+    unsigned long long count;
+
+    while (Util::isSpace(*line))
+        line++;
+
+    if (!*line)
+        return;
+
+    if (sscanf(line, "%255s %255s %llu", proc, label, &count) != 3)
+        Util::exit("Invalid line %zu in proc profile %s\n", EXIT_FAILURE, lineNo, m_path.c_str());
+
+    m_procCounts[proc] += count;
+    m_totalCount += count;
+}
+
+void ProcProfile::selectHotProcs()
+{
+    std::vector<std::pair<const std::string *, uint64_t>> procs;
+    procs.reserve(m_procCounts.size());
+
+    for (const auto& [name, count] : m_procCounts)
+        procs.emplace_back(&name, count);
+
+    // break ties by name so that the same profile always gives the same result
+    std::sort(procs.begin(), procs.end(), [](const auto& p1, const auto& p2) {
+        return p1.second > p2.second || p1.second == p2.second && *p1.first < *p2.first;
+    });
+
+    uint64_t hotCount = 0;
+
+    for (const auto& [name, count] : procs) {
+        if (hotCount >= kHotExecutionShare * m_totalCount)
+            break;
+
+        m_hotProcs.insert(*name);
+        hotCount += count;
+    }
+}
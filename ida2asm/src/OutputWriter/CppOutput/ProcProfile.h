@@ -0,0 +1,30 @@
+#pragma once
+
+// Execution profile of the generated code, as written by an instrumented build (--instrument-procs) on exit.
+// Each line holds a proc name, a label within it ("-" for the proc entry) and how many times it was reached.
+// Used to split procs into hot ones, which account for the bulk of the execution, and cold ones, which were
+// never entered at all; code generator marks them so the compiler can optimize and place them accordingly.
+class ProcProfile
+{
+public:
+    enum ProcClass { kNormal, kHot, kCold };
+
+    ProcProfile(const char *path);
+    void load();
+
+    ProcClass classify(const String& procName) const;
+    void showReport() const;
+
+private:
+    void parseLine(const char *line, size_t lineNo);
+    void selectHotProcs();
+
+    // smallest set of procs that covers this much of the total executions is considered hot
+    static constexpr double kHotExecutionShare = 0.9;
+
+    std::string m_path;
+
+    std::unordered_map<std::string, uint64_t> m_procCounts;     // proc entries plus all the labels inside
+    std::unordered_set<std::string> m_hotProcs;
+    uint64_t m_totalCount = 0;
+};
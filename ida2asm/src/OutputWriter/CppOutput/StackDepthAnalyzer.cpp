@@ -0,0 +1,194 @@
+#include "StackDepthAnalyzer.h"
+
+// Start and end are indices of proc and end proc nodes. Labels reachable only by backward jumps get their depth
+// on the first pass, so keep walking until nothing new is learned.
+void StackDepthAnalyzer::analyze(const Instructions& nodes, size_t start, size_t end)
+{
+    assert(start < end && nodes[start].type == OutputItem::kProc && nodes[end].type == OutputItem::kEndProc);
+
+    m_nodes = &nodes;
+    m_start = start;
+    m_end = end;
+
+    m_depths.assign(end - start + 1, kUnknownDepth);
+    m_labelDepths.clear();
+    m_usesBulkStackInstructions = false;
+    m_maxDepth = 0;
+
+    for (auto i = start + 1; i < end; i++)
+        if (nodes[i].type == OutputItem::kLabel)
+            m_labelDepths.emplace_back(nodes[i].label, kUnknownDepth);
+
+    do {
+        m_changed = false;
+        m_balanced = walk();
+    } while (m_balanced && m_changed);
+}
+
+bool StackDepthAnalyzer::balanced() const
+{
+    return m_balanced;
+}
+
+// pusha, popa, pushf and popf
+bool StackDepthAnalyzer::usesBulkStackInstructions() const
+{
+    return m_usesBulkStackInstructions;
+}
+
+int StackDepthAnalyzer::maxDepth() const
+{
+    return m_maxDepth;
+}
+
+int StackDepthAnalyzer::depthAt(size_t index) const
+{
+    assert(index >= m_start && index <= m_end);
+    return m_depths[index - m_start];
+}
+
+auto StackDepthAnalyzer::callTargets() const -> const std::vector<CallTarget>&
+{
+    return m_callTargets;
+}
+
+bool StackDepthAnalyzer::walk()
+{
+    int depth = 0;
+    m_callTargets.clear();
+
+    for (auto i = m_start + 1; i < m_end; i++) {
+        const auto& node = (*m_nodes)[i];
+
+        if (node.type == OutputItem::kLabel) {
+            auto it = std::find_if(m_labelDepths.begin(), m_labelDepths.end(), [&node](const auto& label) {
+                return label.first == node.label;
+            });
+            assert(it != m_labelDepths.end());
+
+            if (depth == kUnknownDepth)
+                depth = it->second;
+            else if (it->second == kUnknownDepth)
+                it->second = depth;
+            else if (it->second != depth)
+                return false;
+        }
+
+        m_depths[i - m_start] = depth;
+
+        if (node.type == OutputItem::kInstruction && !node.deleted && depth != kUnknownDepth)
+            if (!processInstruction(node.instruction, depth))
+                return false;
+    }
+
+    m_depths[m_end - m_start] = depth;
+
+    if (depth != kUnknownDepth) {
+        if (depth)
+            return false;
+
+        if (const auto& fallThroughProc = (*m_nodes)[m_end].label)
+            m_callTargets.push_back({ fallThroughProc, depth });
+    }
+
+    return true;
+}
+
+bool StackDepthAnalyzer::processInstruction(const Instruction *instruction, int& depth)
+{
+    assert(instruction && depth >= 0);
+
+    if (accessesEsp(instruction))
+        return false;
+
+    auto type = instruction->type();
+
+    if (!instruction->isBranch()) {
+        if (auto effect = stackEffect(type)) {
+            if (type != Token::T_PUSH && type != Token::T_POP)
+                m_usesBulkStackInstructions = true;
+
+            depth += effect;
+            m_maxDepth = std::max(m_maxDepth, depth);
+        }
+
+        return depth >= 0;
+    }
+
+    if (type == Token::T_RETN || type == Token::T_RET || type == Token::T_RETF || type == Token::T_RETFW ||
+        type == Token::T_IRET) {
+        if (depth)
+            return false;
+
+        depth = kUnknownDepth;
+        return true;
+    }
+
+    const auto& target = instruction->getBranchTarget();
+
+    // nothing gets generated for jumps relative to the current address
+    if (!target)
+        return true;
+
+    if (type == Token::T_CALL) {
+        m_callTargets.push_back({ target, depth });
+        return true;
+    }
+
+    auto label = std::find_if(m_labelDepths.begin(), m_labelDepths.end(), [&target](const auto& label) {
+        return label.first == target;
+    });
+
+    if (label != m_labelDepths.end()) {
+        if (label->second == kUnknownDepth) {
+            label->second = depth;
+            m_changed = true;
+        } else if (label->second != depth) {
+            return false;
+        }
+    } else {
+        // starting over, returning, or going to another proc for good, either way the stack must be as we found it
+        if (depth)
+            return false;
+
+        if (target != (*m_nodes)[m_start].label && target != "return")
+            m_callTargets.push_back({ target, depth });
+    }
+
+    if (type == Token::T_JMP)
+        depth = kUnknownDepth;
+
+    return true;
+}
+
+bool StackDepthAnalyzer::accessesEsp(const Instruction *instruction)
+{
+    const auto& operands = instruction->operands();
+
+    for (size_t i = 0; i < instruction->numOperands(); i++)
+        for (const auto& op : operands[i])
+            if (op.isRegister() && (op.type() == Token::T_ESP || op.type() == Token::T_SP))
+                return true;
+
+    return false;
+}
+
+int StackDepthAnalyzer::stackEffect(Token::Type type)
+{
+    switch (type) {
+    case Token::T_PUSH:
+    case Token::T_PUSHF:
+    case Token::T_PUSHFW:
+        return 1;
+    case Token::T_POP:
+    case Token::T_POPF:
+    case Token::T_POPFW:
+        return -1;
+    case Token::T_PUSHA:
+        return 8;
+    case Token::T_POPA:
+        return -8;
+    default:
+        return 0;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "InstructionNode.h"
+
+// Follows the depth of the VM stack through a single proc, relative to the depth at proc entry. Depth at every
+// reachable instruction must be the same along all the paths leading to it, otherwise we know nothing about it.
+// Proc is balanced if its depth is consistent, it never pops below the entry depth, never accesses the stack
+// through esp, and leaves with the same depth it came in. Only looks at the instructions themselves, not at the
+// operand info, so it can run on raw parser output too.
+class StackDepthAnalyzer
+{
+public:
+    static constexpr int kUnknownDepth = -1;
+
+    struct CallTarget {
+        String name;
+        int depth;
+    };
+
+    void analyze(const Instructions& nodes, size_t start, size_t end);
+
+    bool balanced() const;
+    bool usesBulkStackInstructions() const;
+    int maxDepth() const;
+
+    // depth before the node executes, unknown for unreachable nodes
+    int depthAt(size_t index) const;
+
+    // procs called, jumped to, or fallen through into, with the stack depth at that point
+    const std::vector<CallTarget>& callTargets() const;
+
+private:
+    bool walk();
+    bool processInstruction(const Instruction *instruction, int& depth);
+    static bool accessesEsp(const Instruction *instruction);
+    static int stackEffect(Token::Type type);
+
+    const Instructions *m_nodes = nullptr;
+    size_t m_start = 0;
+    size_t m_end = 0;
+
+    std::vector<int> m_depths;
+    std::vector<std::pair<String, int>> m_labelDepths;
+    std::vector<CallTarget> m_callTargets;
+
+    bool m_balanced = false;
+    bool m_changed = false;
+    bool m_usesBulkStackInstructions = false;
+    int m_maxDepth = 0;
+};
@@ -0,0 +1,117 @@
+#include "StackNeutralProcs.h"
+#include "StackDepthAnalyzer.h"
+#include "SymbolFileParser.h"
+#include "TaskPool.h"
+
+StackNeutralProcs::StackNeutralProcs(const SymbolFileParser& symFileParser)
+    : m_symFileParser(symFileParser)
+{
+}
+
+// Start from all the balanced procs and keep dropping the ones that reach a proc which isn't neutral, until
+// there's nothing left to drop. Anything that isn't a known proc (registers, variables, missing procs) spoils it.
+void StackNeutralProcs::build(const std::vector<const OutputItemStream *>& chunks, TaskPool& taskPool)
+{
+    std::vector<std::vector<ProcInfo>> chunkProcs(chunks.size());
+    taskPool.run(chunks.size(), [&](size_t i) { analyzeChunk(*chunks[i], chunkProcs[i]); });
+
+    std::unordered_map<String, ProcInfo *> procs;
+
+    for (auto& chunk : chunkProcs)
+        for (auto& proc : chunk)
+            procs.emplace(proc.name, &proc);
+
+    bool changed;
+
+    do {
+        changed = false;
+
+        for (auto& [name, proc] : procs) {
+            if (!proc->neutral)
+                continue;
+
+            for (const auto& target : proc->targets) {
+                if (m_symFileParser.isImport(target))
+                    continue;
+
+                auto it = procs.find(target);
+                if (it == procs.end() || !it->second->neutral) {
+                    proc->neutral = false;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    } while (changed);
+
+    m_neutralProcs.clear();
+    m_numProcs = procs.size();
+
+    for (const auto& [name, proc] : procs)
+        if (proc->neutral)
+            m_neutralProcs.insert(name);
+}
+
+// C++ functions are assumed not to touch the VM stack below what they pushed themselves.
+bool StackNeutralProcs::isNeutral(const String& procName) const
+{
+    return m_symFileParser.isImport(procName) || m_neutralProcs.count(procName) != 0;
+}
+
+size_t StackNeutralProcs::numProcs() const
+{
+    return m_numProcs;
+}
+
+size_t StackNeutralProcs::numNeutralProcs() const
+{
+    return m_neutralProcs.size();
+}
+
+// Builds just enough of the intermediate form for the stack analyzer: proc, labels, instructions and the proc
+// that follows, in case the execution falls through into it.
+void StackNeutralProcs::analyzeChunk(const OutputItemStream& items, std::vector<ProcInfo>& procs)
+{
+    StackDepthAnalyzer analyzer;
+    Instructions nodes;
+    bool insideProc = false;
+
+    for (const auto& item : items) {
+        switch (item.type()) {
+        case OutputItem::kProc:
+            nodes.clear();
+            nodes.emplace_back(OutputItem::kProc, item.getItem<Proc>()->name());
+            insideProc = true;
+            break;
+
+        case OutputItem::kInstruction:
+            // same as the converter, JO instructions are skipped
+            if (insideProc && item.getItem<Instruction>()->type() != Token::T_JO)
+                nodes.emplace_back(&item);
+            break;
+
+        case OutputItem::kLabel:
+            if (insideProc)
+                nodes.emplace_back(OutputItem::kLabel, item.getItem<Label>()->name());
+            break;
+
+        case OutputItem::kEndProc:
+            if (insideProc) {
+                auto next = item.next();
+                while (next != items.end() && next->type() != OutputItem::kProc)
+                    next = next->next();
+
+                nodes.emplace_back(OutputItem::kEndProc, next != items.end() ? next->getItem<Proc>()->name() : String());
+
+                analyzer.analyze(nodes, 0, nodes.size() - 1);
+
+                procs.push_back({ nodes.front().label, analyzer.balanced() });
+                for (const auto& target : analyzer.callTargets())
+                    procs.back().targets.push_back(target.name);
+
+                insideProc = false;
+            }
+            break;
+        }
+    }
+}
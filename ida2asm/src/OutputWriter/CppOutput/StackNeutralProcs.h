@@ -0,0 +1,34 @@
+#pragma once
+
+#include "OutputItem/OutputItem.h"
+
+class SymbolFileParser;
+class TaskPool;
+
+// Procs that leave the stack of their callers alone: they're balanced (see StackDepthAnalyzer), and so is everything
+// they call, jump to, or fall through into. Whatever the caller pushed is safe to keep outside of the VM stack while
+// calling one of them. Built once from all the chunks, since calls cross chunk boundaries freely.
+class StackNeutralProcs
+{
+public:
+    StackNeutralProcs(const SymbolFileParser& symFileParser);
+    void build(const std::vector<const OutputItemStream *>& chunks, TaskPool& taskPool);
+
+    bool isNeutral(const String& procName) const;
+    size_t numProcs() const;
+    size_t numNeutralProcs() const;
+
+private:
+    struct ProcInfo {
+        String name;
+        bool neutral;
+        std::vector<String> targets;
+    };
+
+    static void analyzeChunk(const OutputItemStream& items, std::vector<ProcInfo>& procs);
+
+    const SymbolFileParser& m_symFileParser;
+
+    std::unordered_set<String> m_neutralProcs;
+    size_t m_numProcs = 0;
+};
@@ -26,6 +26,14 @@
 //   inc ecx
 //   mov eax, ecx   ; <-- gets eliminated (same initial value and subsequent operations)
 //
+// Known constants are also propagated into source operands, and comparisons of known values are done right here.
+// Their flags are stored in the instruction, and conditional jumps depending on them are resolved:
+//   mov eax, 3
+//   mov ebx, eax   ; <-- becomes mov ebx, 3
+//   cmp ebx, 5     ; <-- flags are known: carry, sign
+//   jb  short @@x  ; <-- always taken
+//   jz  short @@y  ; <-- never taken, gets eliminated
+//
 
 void VmDataState::startNewProc()
 {
@@ -47,19 +55,30 @@ void VmDataState::reset()
     m_mem.clear();
     m_expressions.clear();
     m_expressionId = 0;
+    m_knownFlags.reset();
 }
 
 void VmDataState::processInstruction(InstructionNode& node)
 {
     assert(node.instruction);
 
-    if (node.instruction->isBranch())
+    propagateConstantSource(node);
+
+    if (!preservesFlags(node.instruction))
+        m_knownFlags.reset();
+
+    if (node.instruction->isBranch()) {
+        foldConditionalJump(node);
         handleBranching(node);
+    }
 
     switch(node.instruction->type()) {
-    case Token::T_NOP:
     case Token::T_CMP:
     case Token::T_TEST:
+        handleCompare(node);
+        break;
+
+    case Token::T_NOP:
     case Token::T_STC:
     case Token::T_CLC:
     case Token::T_CLD:
@@ -156,6 +175,155 @@ void VmDataState::processLabel(InstructionNode& node)
         m_ignoredLabels.insert(node.label);
 }
 
+// Replaces register and memory sources holding known values with the values themselves.
+void VmDataState::propagateConstantSource(InstructionNode& node)
+{
+    switch (node.instruction->type()) {
+    case Token::T_MOV:
+    case Token::T_CMP:
+    case Token::T_TEST:
+    case Token::T_ADD:
+    case Token::T_SUB:
+    case Token::T_AND:
+    case Token::T_OR:
+    case Token::T_XOR:
+        break;
+    default:
+        return;
+    }
+
+    if (node.instruction->numOperands() != 2 || node.opInfo[1].isConst())
+        return;
+
+    auto [dst, src] = extractOperands(node);
+
+    if (src.type == OperandInfo::kReg || src.type == OperandInfo::kFixedMem) {
+        if (auto value = getConstantValue(src)) {
+            node.opInfo[1].reset();
+            node.opInfo[1].setAsConstant(*value);
+        }
+    }
+}
+
+void VmDataState::handleCompare(InstructionNode& node)
+{
+    auto [dst, src] = extractOperands(node);
+
+    auto dstValue = dst.isDynamicMem() ? std::nullopt : getConstantValue(dst);
+    auto srcValue = src.isDynamicMem() ? std::nullopt : getConstantValue(src);
+
+    if (!dstValue || !srcValue)
+        return;
+
+    auto size = dst.size() ? dst.size() : src.size();
+    assert(size == 1 || size == 2 || size == 4);
+
+    auto mask = size == 4 ? ~0u : (1u << size * 8) - 1;
+    auto signBit = 1u << (size * 8 - 1);
+
+    auto a = *dstValue & mask;
+    auto b = *srcValue & mask;
+    int flags = 0;
+
+    if (node.instruction->type() == Token::T_CMP) {
+        auto result = (a - b) & mask;
+        if (a < b)
+            flags |= InstructionNode::kCarryFlag;
+        if ((a ^ b) & (a ^ result) & signBit)
+            flags |= InstructionNode::kOverflowFlag;
+        if (!result)
+            flags |= InstructionNode::kZeroFlag;
+        if (result & signBit)
+            flags |= InstructionNode::kSignFlag;
+    } else {
+        auto result = a & b;
+        if (!result)
+            flags |= InstructionNode::kZeroFlag;
+        if (result & signBit)
+            flags |= InstructionNode::kSignFlag;
+    }
+
+    node.constantFlags = flags;
+    m_knownFlags = flags;
+}
+
+// Conditional jumps that never happen are removed, the ones that always do become unconditional.
+void VmDataState::foldConditionalJump(InstructionNode& node)
+{
+    if (!m_knownFlags)
+        return;
+
+    if (auto taken = evaluateCondition(node.instruction->type(), *m_knownFlags)) {
+        if (*taken)
+            node.alwaysTaken = true;
+        else
+            node.deleted = true;
+    }
+}
+
+std::optional<bool> VmDataState::evaluateCondition(Token::Type type, int flags)
+{
+    bool carry = (flags & InstructionNode::kCarryFlag) != 0;
+    bool zero = (flags & InstructionNode::kZeroFlag) != 0;
+    bool sign = (flags & InstructionNode::kSignFlag) != 0;
+    bool overflow = (flags & InstructionNode::kOverflowFlag) != 0;
+
+    switch (type) {
+    case Token::T_JZ: return zero;
+    case Token::T_JNZ: return !zero;
+    case Token::T_JB: return carry;
+    case Token::T_JNB: return !carry;
+    case Token::T_JA: return !carry && !zero;
+    case Token::T_JBE: return carry || zero;
+    case Token::T_JG: return !zero && sign == overflow;
+    case Token::T_JGE: return sign == overflow;
+    case Token::T_JL: return sign != overflow;
+    case Token::T_JLE: return zero || sign != overflow;
+    case Token::T_JS: return sign;
+    case Token::T_JNS: return !sign;
+    case Token::T_JO: return overflow;
+    case Token::T_JNO: return !overflow;
+    default: return {};
+    }
+}
+
+bool VmDataState::preservesFlags(const Instruction *instruction)
+{
+    switch (instruction->type()) {
+    case Token::T_NOP:
+    case Token::T_MOV:
+    case Token::T_MOVSX:
+    case Token::T_MOVZX:
+    case Token::T_MOVSB:
+    case Token::T_MOVSW:
+    case Token::T_MOVSD:
+    case Token::T_LODSB:
+    case Token::T_LODSW:
+    case Token::T_LODS:
+    case Token::T_STOSB:
+    case Token::T_STOSW:
+    case Token::T_STOSD:
+    case Token::T_PUSH:
+    case Token::T_POP:
+    case Token::T_PUSHF:
+    case Token::T_PUSHA:
+    case Token::T_POPA:
+    case Token::T_CBW:
+    case Token::T_CWD:
+    case Token::T_CWDE:
+    case Token::T_CDQ:
+    case Token::T_XCHG:
+    case Token::T_NOT:
+    case Token::T_SETZ:
+    case Token::T_CLD:
+    case Token::T_STI:
+    case Token::T_CLI:
+        return true;
+    default:
+        return evaluateCondition(instruction->type(), 0).has_value();
+    }
+}
+
 void VmDataState::handleBranching(const InstructionNode& node)
 {
     auto target = node.instruction->getBranchTarget();
@@ -346,8 +514,10 @@ void VmDataState::handleBlockInstructions(const InstructionNode& node)
         } else {
             if (!isStos)
                 trashRegister(kEsi);
-            if (!isLods)
+            if (!isLods) {
                 trashRegister(kEdi);
+                dynamicMemoryWrite();
+            }
             if (isLods)
                 trashRegister(kEax);
             assignConstantToRegister(kEcx, 0);
@@ -1298,7 +1468,14 @@ void VmDataState::trashMemory(size_t address, size_t size)
     m_color++;
 }
 
+// Write to an address we don't know, so it might've hit any of the memory we're tracking. Give all of it a fresh
+// color so it's no longer equal to anything, including the registers that were loaded from it.
 void VmDataState::dynamicMemoryWrite()
 {
-    // do nothing for now, test destroying register/memory state
+    for (auto& [address, val] : m_mem) {
+        val = ByteValue();
+        val.resetAsMem(address, m_color);
+    }
+
+    m_color++;
 }
@@ -15,6 +15,11 @@ public:
     void processLabel(InstructionNode& node);
 
 private:
+    void propagateConstantSource(InstructionNode& node);
+    void handleCompare(InstructionNode& node);
+    void foldConditionalJump(InstructionNode& node);
+    static std::optional<bool> evaluateCondition(Token::Type type, int flags);
+    static bool preservesFlags(const Instruction *instruction);
     void handleBranching(const InstructionNode& node);
     void handleMov(InstructionNode& node);
     void handleXchg(InstructionNode& node);
@@ -250,4 +255,7 @@ private:
     std::unordered_map<String, Stack> m_stacks;
     std::unordered_set<String> m_ignoredLabels;
     Stack *m_stack = nullptr;
+
+    // flags left by the last cmp/test on known values, as InstructionNode::FlagBits
+    std::optional<int> m_knownFlags;
 };
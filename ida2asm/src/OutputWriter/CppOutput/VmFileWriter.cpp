@@ -49,6 +49,7 @@ void VmFileWriter::outputCppFile()
     outputProcFunctions();
     outputMemoryAccessFunctions();
     outputDebugFunctions();
+    outputProfilingFunctions();
 
     xfputs("}\n");
 
@@ -132,6 +133,7 @@ void VmFileWriter::outputHeaderFile()
 
         "uint32_t readMemory(uint32_t addr, int size);\n"
         "void writeMemory(uint32_t addr, int size, uint32_t value);\n"
+        "void fillMemory(uint32_t addr, uint32_t value, int size, uint32_t count);\n"
         "char *offsetToPtr(uint32_t offset);\n"
         "char *getExtraMemoryArea();\n"
         "SwosDataPointer<char> allocateMemory(size_t size);\n"
@@ -170,6 +172,27 @@ void VmFileWriter::outputHeaderFile()
         "static inline void verifySafeMemoryAreas() {}\n"
         "#endif\n\n"
 
+        "// execution counters, only used by the code converted with --instrument-procs; written out on exit\n"
+        "struct ProfileCounter {\n"
+        "    ProfileCounter(const char *proc, const char *label);\n"
+        "    const char *proc;\n"
+        "    const char *label;\n"
+        "    uint64_t count;\n"
+        "    ProfileCounter *next;\n"
+        "};\n"
+        "void saveProcProfile(const char *path);\n\n"
+
+        "#define SWOS_PROFILE_PROC(proc) { static SwosVM::ProfileCounter counter_(proc, nullptr); counter_.count++; }\n"
+        "#define SWOS_PROFILE_BLOCK(proc, label) { static SwosVM::ProfileCounter counter_(proc, label); counter_.count++; }\n\n"
+
+        "#if defined(__GNUC__) || defined(__clang__)\n"
+        "# define SWOS_HOT_PROC [[gnu::hot]]\n"
+        "# define SWOS_COLD_PROC [[gnu::cold]]\n"
+        "#else\n"
+        "# define SWOS_HOT_PROC\n"
+        "# define SWOS_COLD_PROC\n"
+        "#endif\n\n"
+
         "# define push(a) (stack[--stackTop] = (a))\n"
         "# define pop(a) ((a) = stack[stackTop++])\n\n"
 
@@ -244,6 +267,9 @@ void VmFileWriter::outputHeaderFile()
 
     xfwrite(kVmHeaderContentsPart2, sizeof(kVmHeaderContentsPart2) - 1);
     xfputs("}\n");
+
+    outputProcTableExterns();
+
     xfclose();
 }
 
@@ -411,6 +437,27 @@ void VmFileWriter::outputProcIndices()
     xfputs("};\n");
 }
 
+// Indirect calls through proc tables dispatch to the procs in them directly, and those can live in any of the
+// output files, so declare them all here where every file can see them. Imports are already declared by swos.h.
+void VmFileWriter::outputProcTableExterns()
+{
+    std::vector<String> procs;
+
+    m_dataBank.traverseProcTables([&procs](const auto& table) {
+        procs.insert(procs.end(), table.procs.begin(), table.procs.end());
+    });
+
+    std::sort(procs.begin(), procs.end());
+    procs.erase(std::unique(procs.begin(), procs.end()), procs.end());
+
+    if (!procs.empty())
+        xfputs("\n");
+
+    for (const auto& proc : procs)
+        if (!m_symFileParser.isImport(proc))
+            xfprintf("void %.*s();\n", proc.length(), proc.data());
+}
+
 size_t VmFileWriter::outputPointerVariable(const DataBank::Var& var, size_t byteSkip)
 {
     const auto& decl = var.exportedDecl;
@@ -479,7 +526,7 @@ size_t VmFileWriter::outputPointerVariable(const DataBank::Var& var, size_t byte
 
 void VmFileWriter::outputMemoryArray()
 {
-    assert(m_f && memArraySize() % 4 == 0);
+    assert(m_filename && memArraySize() % 4 == 0);
 
     const auto& length = Util::formatDelimitedNumber(m_dataBank.memoryByteSize(), '\'');
     const auto& lengthRounded = Util::formatDelimitedNumber(memArraySize(), '\'');
@@ -563,7 +610,7 @@ void VmFileWriter::outputProcExterns()
 
 void VmFileWriter::outputProcVector()
 {
-    xfprintf("static void (*kProcs[%u])() = {", m_dataBank.numProcPointers());
+    xfprintf("static void (* const kProcs[%u])() = {", m_dataBank.numProcPointers());
 
     m_dataBank.traverseProcs([this](const auto& procName, bool imported, int) {
         xfprintf("\n    %s%.*s,", imported ? "SWOS::" : "", procName.length(), procName.data());
@@ -589,10 +636,14 @@ void VmFileWriter::outputProcFunctions()
         "    return index >= kNumProcs ? m_userProcs[index - kNumProcs] : kProcs[index];\n"
         "}\n"
         "\n"
+        "// converted procs take the short way, null pointers and registered procs go through fetchProc()\n"
         "void invokeProc(int index)\n"
         "{\n"
-        "    auto proc = fetchProc(index);\n"
-        "    if (proc)\n"
+        "    auto procIndex = static_cast<unsigned>(-2 - index);\n"
+        "\n"
+        "    if (procIndex < kNumProcs)\n"
+        "        kProcs[procIndex]();\n"
+        "    else if (auto proc = fetchProc(index))\n"
         "        proc();\n"
         "}\n"
         "\n"
@@ -903,6 +954,45 @@ void VmFileWriter::outputMemoryAccessFunctions()
         );
     }
     xfputs("}\n");
+
+    outputFillMemoryFunction();
+}
+
+// Backs rep stosw/stosd: the whole range is checked once, then filled in one go instead of element by element.
+void VmFileWriter::outputFillMemoryFunction()
+{
+    xfputs(
+        "\n"
+        "void fillMemory(uint32_t addr, uint32_t value, int size, uint32_t count)\n"
+        "{\n"
+        "    assert(size == 2 || size == 4);\n"
+        "    assert(addr >= kMemStartOfs && addr + size * count <= kMemSize);\n"
+        "\n"
+        "    if (size == 2)\n"
+        "        value = (value & 0xffff) | (value << 16);\n"
+        "\n"
+        "    if (value == (value & 0xff) * 0x01010101u)\n"
+        "        memset(&g_memByte[addr], value & 0xff, size * count);\n"
+    );
+    if (m_disableAlignmentChecks) {
+        xfputs(
+            "    else if (size == 2)\n"
+            "        std::fill_n(reinterpret_cast<uint16_t *>(&g_memByte[addr]), count, static_cast<uint16_t>(value));\n"
+            "    else\n"
+            "        std::fill_n(reinterpret_cast<uint32_t *>(&g_memByte[addr]), count, value);\n"
+        );
+    } else {
+        xfputs(
+            "    else if (size == 2 && addr % 2 == 0)\n"
+            "        std::fill_n(&g_memWord[addr / 2], count, static_cast<uint16_t>(value));\n"
+            "    else if (size == 4 && addr % 4 == 0)\n"
+            "        std::fill_n(&g_memDword[addr / 4], count, value);\n"
+            "    else\n"
+            "        for (auto p = &g_memByte[addr]; count--; p += size)\n"
+            "            memcpy(p, &value, size);\n"
+        );
+    }
+    xfputs("}\n");
 }
 
 void VmFileWriter::outputDebugFunctions()
@@ -958,6 +1048,38 @@ void VmFileWriter::outputDebugFunctions()
     xfputs(kFunctions);
 }
 
+void VmFileWriter::outputProfilingFunctions()
+{
+    const char kFunctions[] =
+        "static ProfileCounter *m_profileCounters;\n"
+        "\n"
+        "// counters register themselves on first execution, so anything that never ran doesn't show up\n"
+        "ProfileCounter::ProfileCounter(const char *proc, const char *label)\n"
+        "    : proc(proc), label(label), count(0), next(m_profileCounters)\n"
+        "{\n"
+        "    if (!m_profileCounters) {\n"
+        "        std::atexit([]() {\n"
+        "            auto path = std::getenv(\"SWOS_PROC_PROFILE\");\n"
+        "            saveProcProfile(path ? path : \"swos-proc-profile.txt\");\n"
+        "        });\n"
+        "    }\n"
+        "\n"
+        "    m_profileCounters = this;\n"
+        "}\n"
+        "\n"
+        "void saveProcProfile(const char *path)\n"
+        "{\n"
+        "    if (auto f = fopen(path, \"w\")) {\n"
+        "        for (auto counter = m_profileCounters; counter; counter = counter->next)\n"
+        "            fprintf(f, \"%s %s %llu\\n\", counter->proc, counter->label ? counter->label : \"-\",\n"
+        "                static_cast<unsigned long long>(counter->count));\n"
+        "        fclose(f);\n"
+        "    }\n"
+        "}\n\n";
+
+    xfputs(kFunctions);
+}
+
 size_t VmFileWriter::memArraySize() const
 {
     auto size = m_dataBank.memoryByteSize();
@@ -998,7 +1120,7 @@ void VmFileWriter::outputZeroMemoryRegion()
     for (size_t i = 4; i < DataBank::zeroRegionSize(); i++)
         outputChar(std::array<char, 3>{ 'z', 'k', 'z' }[i % 3]);
 
-    fseek(m_f, -1, SEEK_CUR);
+    m_contents.pop_back();
 }
 
 void VmFileWriter::outputComment(const String& comment, bool skipInitialCommentMark /* = false */)
@@ -1200,49 +1322,42 @@ void VmFileWriter::addNewLine()
     xfputs("\n    ", true);
 }
 
+// Contents are collected in memory, and the file gets written only if they've changed, since these files are
+// included by everything.
 void VmFileWriter::xfopen(const char *filename)
 {
     m_filename = filename;
-
-    const auto& filePath = Util::joinPaths(m_baseDir, filename);
-    m_f = fopen(filePath.c_str(), "w");
-
-    if (!m_f)
-        fileError();
+    m_contents.clear();
 }
 
 void VmFileWriter::xfclose()
 {
-    assert(m_f);
+    assert(m_filename);
 
-    if (m_f)
-        fclose(m_f);
+    const auto& filePath = Util::joinPaths(m_baseDir, m_filename);
+    if (Util::writeFileIfChanged(filePath.c_str(), m_contents.data(), m_contents.size(), true) == Util::kWriteFailed)
+        fileError();
 }
 
 void VmFileWriter::xfwrite(const void *buf, size_t size)
 {
-    assert(m_f);
-
-    if (fwrite(buf, size, 1, m_f) != 1)
-        fileError();
+    assert(m_filename);
+    m_contents.append(reinterpret_cast<const char *>(buf), size);
 }
 
 void VmFileWriter::xfputs(const String& str)
 {
-    assert(m_f && !str.contains('\n'));
-
-    if (!str.writeToFile(m_f))
-        fileError();
+    assert(m_filename && !str.contains('\n'));
 
+    m_contents.append(str.data(), str.length());
     m_pos += str.length();
 }
 
 void VmFileWriter::xfputs(const char *str, bool updatePos /* = false */)
 {
-    assert(m_f);
+    assert(m_filename);
 
-    if (fputs(str, m_f) < 0)
-        fileError();
+    m_contents += str;
 
     if (updatePos)
         updatePosition(str);
@@ -1250,10 +1365,9 @@ void VmFileWriter::xfputs(const char *str, bool updatePos /* = false */)
 
 void VmFileWriter::xfputc(int c, bool updatePos /* = true */)
 {
-    assert(m_f);
+    assert(m_filename);
 
-    if (fputc(c, m_f) == EOF)
-        fileError();
+    m_contents += static_cast<char>(c);
 
     if (updatePos)
         updatePosition(c);
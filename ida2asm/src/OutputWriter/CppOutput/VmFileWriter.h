@@ -24,13 +24,16 @@ private:
     static size_t getElementSize(const String& type);
     void outputVariablesEnum();
     void outputProcIndices();
+    void outputProcTableExterns();
     size_t outputPointerVariable(const DataBank::Var& var, size_t byteSkip);
     void outputMemoryArray();
     void outputProcExterns();
     void outputProcVector();
     void outputProcFunctions();
     void outputMemoryAccessFunctions();
+    void outputFillMemoryFunction();
     void outputDebugFunctions();
+    void outputProfilingFunctions();
     size_t memArraySize() const;
     FILE *outputFile(const char *filename, const char *contents, size_t size);
     void outputZeroMemoryRegion();
@@ -63,7 +66,7 @@ private:
     const DataBank& m_dataBank;
     const StructStream& m_structs;
 
-    FILE *m_f = nullptr;
+    std::string m_contents;
     int m_pos = 0;
     const char *m_filename = nullptr;
 };
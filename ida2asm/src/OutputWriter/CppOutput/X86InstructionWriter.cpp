@@ -345,10 +345,9 @@ void X86InstructionWriter::outputStos(const InstructionNode& node)
             out("writeMemory(edi, ", size, ", ", reg, ");", kNewLine, kIndent);
             out("edi += ", size);
         } else {
-            out("assert(edi >= kMemStartOfs && edi + ", size, " * ecx <= kMemSize);", kNewLine, kIndent);
-            out("for (; ecx; ecx--)", kNewLine, kIndent);
-            out(kIndent, "for (int i = 0; i < ", size, "; i++)", kNewLine, kIndent);
-            out(kIndent, kIndent, "g_memByte[edi++] = ", reg, " >> (i * 8)");
+            out("fillMemory(edi, ", reg, ", ", size, ", ecx);", kNewLine, kIndent);
+            out("edi += ", size, " * ecx;", kNewLine, kIndent);
+            out("ecx = 0");
         }
     }
 }
@@ -391,7 +390,7 @@ void X86InstructionWriter::outputCall(const InstructionNode& node)
 
     if (!text.startsWith('$')) {
         assert(target->next() == operand.end());
-        outputFunctionInvoke(text);
+        outputFunctionInvoke(text, node.procTable);
     }
 }
 
@@ -406,7 +405,15 @@ void X86InstructionWriter::outputPushPop(const InstructionNode& node)
 
     const auto& dst = node.opInfo[0];
 
-    if (instruction->type() == Token::T_POP && (dst.size() == 2 || dst.needsMemoryFetch())) {
+    if (node.stackSlot >= 0) {
+        if (instruction->type() == Token::T_PUSH) {
+            out(CppOutput::kStackSlotPrefix, node.stackSlot, " = ");
+            op.outputDest(OpWriter::kRvalue);
+        } else {
+            op.outputDest(OpWriter::kRvalue);
+            out(" = ", CppOutput::kStackSlotPrefix, node.stackSlot);
+        }
+    } else if (instruction->type() == Token::T_POP && (dst.size() == 2 || dst.needsMemoryFetch())) {
         out('{');
         op.startNewLine(false, +1);
         out("int32_t val = stack[stackTop++]");
@@ -493,6 +500,9 @@ void X86InstructionWriter::outputCmpSubAdd(const InstructionNode& node, bool com
 {
     assert(node.instruction->numOperands() == 2);
 
+    if (!commitResult && node.constantFlags >= 0)
+        return outputConstantFlags(node);
+
     OpWriter op(node, m_outputWriter, OpWriter::kExtraScope);
     op.fetchDestFromMemoryIfNeeded();
 
@@ -562,6 +572,9 @@ void X86InstructionWriter::outputAndTest(const InstructionNode& node, bool commi
 {
     assert(node.instruction->numOperands() == 2);
 
+    if (!commitResult && node.constantFlags >= 0)
+        return outputConstantFlags(node);
+
     OpWriter op(node, m_outputWriter, OpWriter::kExtraScope);
     op.fetchDestFromMemoryIfNeeded();
 
@@ -583,6 +596,21 @@ void X86InstructionWriter::outputAndTest(const InstructionNode& node, bool commi
     op.setZeroFlag("res == 0");
 }
 
+// cmp or test on values known during conversion, only the outcome is needed
+void X86InstructionWriter::outputConstantFlags(const InstructionNode& node)
+{
+    OpWriter op(node, m_outputWriter);
+
+    auto flagValue = [&](int flag) {
+        return [&, flag] { out((node.constantFlags & flag) ? "true" : "false"); };
+    };
+
+    op.setOverflowFlag(flagValue(InstructionNode::kOverflowFlag));
+    op.setCarryFlag(flagValue(InstructionNode::kCarryFlag));
+    op.setSignFlag(flagValue(InstructionNode::kSignFlag));
+    op.setZeroFlag(flagValue(InstructionNode::kZeroFlag));
+}
+
 void X86InstructionWriter::outputXchg(const InstructionNode& node)
 {
     assert(node.instruction->numOperands() == 2);
@@ -1151,6 +1179,9 @@ void X86InstructionWriter::outputConditionalJump(const InstructionNode& node, co
 
     assert(instruction && instruction->isBranch() && instruction->numOperands() == 1);
 
+    if (node.alwaysTaken)
+        condition = nullptr;
+
     auto target = instruction->operands()[0].begin();
 
     if (target->type() == Token::T_SHORT)
@@ -1176,10 +1207,10 @@ void X86InstructionWriter::outputConditionalJump(const InstructionNode& node, co
             }
         } else {
             if (isRetnNext(node)) {
-                outputFunctionInvoke(label);
+                outputFunctionInvoke(label, node.procTable);
             } else {
                 out("{ ");
-                outputFunctionInvoke(label);
+                outputFunctionInvoke(label, node.procTable);
                 out("; return; }");
             }
         }
@@ -1261,7 +1292,7 @@ void X86InstructionWriter::outputJno(const InstructionNode& node)
     outputConditionalJump(node, "!flags.overflow");
 }
 
-void X86InstructionWriter::outputFunctionInvoke(const String& target)
+void X86InstructionWriter::outputFunctionInvoke(const String& target, int procTable /* = -1 */)
 {
     auto isCallReg = [&]() {
         static const char *kRegs[] = { "ax", "bx", "cx", "dx", "si", "di", "bp" };
@@ -1277,19 +1308,32 @@ void X86InstructionWriter::outputFunctionInvoke(const String& target)
     auto regIndex = amigaRegisterToIndex(target);
     auto isVar = m_dataBank.isVariable(target);
     if (target.startsWith('-') || regIndex >= 0 || isCallReg() || isVar) {
-        out("invokeProc(");
-        if (isVar) {
-            auto offset = m_dataBank.getVarOffset(target);
-            out("g_memDword[", offset / 4, ']');
-        } else {
-            out(target);
-        }
-        out(')');
+        auto procIndex = isVar ? "g_memDword[" + std::to_string(m_dataBank.getVarOffset(target) / 4) + ']' : target.string();
+
+        if (auto table = procTable >= 0 ? m_dataBank.procTableAt(procTable) : nullptr)
+            outputProcTableDispatch(procIndex.c_str(), *table);
+        else
+            out("invokeProc(", procIndex.c_str(), ')');
     } else {
         outputFunctionCall(target);
     }
 }
 
+// Target was loaded from a proc table, so call whatever it holds directly. The table is in memory and might have
+// been overwritten since, so anything unknown still goes through invokeProc().
+void X86InstructionWriter::outputProcTableDispatch(const char *procIndex, const DataBank::ProcTable& procTable)
+{
+    out("switch (static_cast<int>(", procIndex, ")) {", kNewLine);
+
+    for (const auto& proc : procTable.procs) {
+        out(kIndent, "case ", m_dataBank.getProcOffset(proc), ": ");
+        outputFunctionCall(proc);
+        out("; break;", kNewLine);
+    }
+
+    out(kIndent, "default: invokeProc(", procIndex, ");", kNewLine, kIndent, '}');
+}
+
 bool X86InstructionWriter::isRetnNext(const InstructionNode& node)
 {
     auto next = node.next;
@@ -28,6 +28,7 @@ private:
     void outputCmpSubAdd(const InstructionNode& node, bool commitResult, bool add);
     void outputIncDec(const InstructionNode& node, bool increment);
     void outputAndTest(const InstructionNode& node, bool commitResult);
+    void outputConstantFlags(const InstructionNode& node);
     void outputXchg(const InstructionNode& node);
     void outputMul(const InstructionNode& node);
     void outputImul(const InstructionNode& node);
@@ -64,7 +65,8 @@ private:
     void outputJo(const InstructionNode& node);
     void outputJno(const InstructionNode& node);
 
-    void outputFunctionInvoke(const String& target);
+    void outputFunctionInvoke(const String& target, int procTable = -1);
+    void outputProcTableDispatch(const char *procIndex, const DataBank::ProcTable& procTable);
     void outputLabel(const String& label);
     static bool isRetnNext(const InstructionNode& node);
 
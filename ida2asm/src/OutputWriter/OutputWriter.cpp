@@ -44,10 +44,13 @@ std::string OutputWriter::getOutputBaseDir()
 
 void OutputWriter::closeOutputFile()
 {
-    if (m_file) {
-        fclose(m_file);
-        m_file = nullptr;
-    }
+    m_outputFilePath.clear();
+}
+
+// Returns true if the last save actually had to write the file (its contents were different or it didn't exist).
+bool OutputWriter::outputFileChanged() const
+{
+    return m_outputFileChanged;
 }
 
 int OutputWriter::outputTab(int column)
@@ -84,11 +87,16 @@ int OutputWriter::outputComment(const String& comment, int column /* = 0 */)
     return column;
 }
 
+// Output is kept in memory until here, and written only if it differs from what's already in the file, so that the
+// files that didn't change don't get recompiled.
 bool OutputWriter::save()
 {
-    if (m_file) {
-        auto size = m_outPtr - m_outBuffer.get();
-        return fwrite(m_outBuffer.get(), size, 1, m_file) == 1;
+    if (!m_outputFilePath.empty()) {
+        auto result = Util::writeFileIfChanged(m_outputFilePath.c_str(), m_outBuffer.get(), outputLength());
+        m_outputFileChanged = result == Util::kFileWritten;
+
+        if (result != Util::kWriteFailed)
+            return true;
     }
 
     if (!m_error.empty())
@@ -132,17 +140,18 @@ void OutputWriter::removeOutputChar(size_t numChars /* = 1 */)
 
 bool OutputWriter::openOutputFile(const char *path, size_t requiredSize)
 {
-    if (m_file = fopen(path, "wb")) {
-        std::setbuf(m_file, nullptr);
+    if (!path || !*path) {
+        m_error = "output file not open";
+        return false;
+    }
 
-        m_outBufferSize = requiredSize;
-        m_outBuffer.reset(new char[m_outBufferSize]);
+    m_outputFilePath = path;
+    m_outputFileChanged = false;
 
-        m_outPtr = m_outBuffer.get();
+    m_outBufferSize = requiredSize;
+    m_outBuffer.reset(new char[m_outBufferSize]);
 
-        return true;
-    }
+    m_outPtr = m_outBuffer.get();
 
-    m_error = "output file not open";
-    return false;
+    return true;
 }
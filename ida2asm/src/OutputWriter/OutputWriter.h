@@ -9,6 +9,9 @@
 #include "OutputItem/OutputItem.h"
 
 class StringList;
+class ProcCache;
+class ProcProfile;
+class StackNeutralProcs;
 
 class OutputWriter
 {
@@ -39,6 +42,10 @@ public:
     virtual std::string segmentDirective(const TokenRange& range) const = 0;
     virtual std::string endSegmentDirective(const TokenRange& range) const = 0;
     virtual std::pair<const char *, size_t> getContiguousVariablesStructData() { return {}; }
+    virtual void setProcCache(ProcCache *procCache, Util::hash64_t contextHash) {}
+    virtual void setProcProfile(const ProcProfile *procProfile, bool instrumentProcs) {}
+    virtual void setStackNeutralProcs(const StackNeutralProcs *stackNeutralProcs) {}
+    bool outputFileChanged() const;
 
 protected:
     static constexpr int kTabSize = 4;
@@ -72,7 +79,8 @@ private:
     bool openOutputFile(const char *path, size_t requiredSize);
 
     const char *m_path;
-    FILE *m_file = nullptr;
+    std::string m_outputFilePath;
+    bool m_outputFileChanged = false;
     std::unique_ptr<char[]> m_outBuffer;
     char *m_outPtr = nullptr;
     size_t m_outBufferSize = 0;
@@ -998,13 +998,40 @@ void IdaAsmParser::addReference(CToken *token)
     }
 }
 
+// Builds a token with its text trailing it at the given position, and moves the position past it.
+// General register type is zero too, so instruction type works for registers as well.
+static Token *appendFixedToken(char *& dest, Token::Type type, Token::Category category,
+    Token::InstructionType instructionType, const char *text)
+{
+    auto token = reinterpret_cast<Token *>(dest);
+    *token = { type, category, { instructionType }, static_cast<uint32_t>(strlen(text)) };
+    memcpy(token + 1, text, token->textLength);
+
+    dest = reinterpret_cast<char *>(token->next());
+    return token;
+}
+
+// Builds four instructions with a single register operand, each instruction token followed by its operand token.
+static std::array<CToken *, 4> makeRegisterInstructionTokens(char *dest, Token::Type instruction,
+    const char *instructionText, const std::array<std::pair<Token::Type, const char *>, 4>& registers)
+{
+    std::array<CToken *, 4> tokens;
+
+    for (size_t i = 0; i < tokens.size(); i++) {
+        tokens[i] = appendFixedToken(dest, instruction, Token::kInstruction, Token::kGeneralInstruction, instructionText);
+        appendFixedToken(dest, registers[i].first, Token::kRegister, Token::kGeneralInstruction, registers[i].second);
+    }
+
+    return tokens;
+}
+
 void IdaAsmParser::outputNullProc()
 {
-    static const char tokenBuff[sizeof(Token) + 4] = {
-        (char)Token::T_RETN, 0, Token::kInstruction, Token::kBranchInstruction, 0, 0, 0, 4, 0, 0, 0, 'r', 'e', 't', 'n',
-    };
-    static_assert(sizeof(Token) == 11, "Fix retn token");
-    auto retnToken = reinterpret_cast<CToken *>(tokenBuff);
+    static char tokenBuff[sizeof(Token) + 4];
+    static const auto retnToken = [] {
+        auto p = tokenBuff;
+        return appendFixedToken(p, Token::T_RETN, Token::kInstruction, Token::kBranchInstruction, "retn");
+    }();
 
     m_outputItems.addInstruction({}, {}, {}, retnToken, {}, {}, {});
     m_outputItems.addEndProc({}, {}, m_currentProc);
@@ -1013,24 +1040,10 @@ void IdaAsmParser::outputNullProc()
 
 CToken *IdaAsmParser::outputSaveCppRegistersInstructions(CToken *token)
 {
-    static const char tokenBuff[8 * sizeof(Token) + 4 * 4 + 4 * 3] = {
-        (char)Token::T_PUSH, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 4, 0, 0, 0, 'p', 'u', 's', 'h',
-        (char)Token::T_EBX, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'b', 'x',
-        (char)Token::T_PUSH, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 4, 0, 0, 0, 'p', 'u', 's', 'h',
-        (char)Token::T_ESI, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 's', 'i',
-        (char)Token::T_PUSH, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 4, 0, 0, 0, 'p', 'u', 's', 'h',
-        (char)Token::T_EDI, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'd', 'i',
-        (char)Token::T_PUSH, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 4, 0, 0, 0, 'p', 'u', 's', 'h',
-        (char)Token::T_EBP, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'b', 'p',
-    };
-    static_assert(sizeof(Token) == 11, "Fix save registers tokens");
-
-    CToken *instructionTokens[4] = {
-        reinterpret_cast<CToken *>(tokenBuff),
-        reinterpret_cast<CToken *>(tokenBuff + 2 * sizeof(Token) + 4 + 3),
-        reinterpret_cast<CToken *>(tokenBuff + 4 * sizeof(Token) + 2 * 4 + 2 * 3),
-        reinterpret_cast<CToken *>(tokenBuff + 6 * sizeof(Token) + 3 * 4 + 3 * 3),
-    };
+    static char tokenBuff[8 * sizeof(Token) + 4 * 4 + 4 * 3];
+    static const auto instructionTokens = makeRegisterInstructionTokens(tokenBuff, Token::T_PUSH, "push", {{
+        { Token::T_EBX, "ebx" }, { Token::T_ESI, "esi" }, { Token::T_EDI, "edi" }, { Token::T_EBP, "ebp" },
+    }});
 
     auto result = collectComments(token);
     auto comments = result.second;
@@ -1045,24 +1058,10 @@ CToken *IdaAsmParser::outputSaveCppRegistersInstructions(CToken *token)
 
 void IdaAsmParser::outputRestoreCppRegistersInstructions()
 {
-    static const char tokenBuff[8 * sizeof(Token) + 8 * 3] = {
-        (char)Token::T_POP, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 3, 0, 0, 0, 'p', 'o', 'p',
-        (char)Token::T_EBP, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'b', 'p',
-        (char)Token::T_POP, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 3, 0, 0, 0, 'p', 'o', 'p',
-        (char)Token::T_EDI, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'd', 'i',
-        (char)Token::T_POP, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 3, 0, 0, 0, 'p', 'o', 'p',
-        (char)Token::T_ESI, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 's', 'i',
-        (char)Token::T_POP, 0, Token::kInstruction, Token::kGeneralInstruction, 0, 0, 0, 3, 0, 0, 0, 'p', 'o', 'p',
-        (char)Token::T_EBX, 0, Token::kRegister, Token::kGeneralRegister, 0, 0, 0, 3, 0, 0, 0, 'e', 'b', 'x',
-    };
-    static_assert(sizeof(Token) == 11, "Fix restore registers tokens");
-
-    CToken *instructionTokens[4] = {
-        reinterpret_cast<CToken *>(tokenBuff),
-        reinterpret_cast<CToken *>(tokenBuff + 2 * (sizeof(Token) + 3)),
-        reinterpret_cast<CToken *>(tokenBuff + 4 * (sizeof(Token) + 3)),
-        reinterpret_cast<CToken *>(tokenBuff + 6 * (sizeof(Token) + 3)),
-    };
+    static char tokenBuff[8 * sizeof(Token) + 8 * 3];
+    static const auto instructionTokens = makeRegisterInstructionTokens(tokenBuff, Token::T_POP, "pop", {{
+        { Token::T_EBP, "ebp" }, { Token::T_EDI, "edi" }, { Token::T_ESI, "esi" }, { Token::T_EBX, "ebx" },
+    }});
 
     for (const auto instructionToken : instructionTokens)
         m_outputItems.addInstruction({}, {}, {}, instructionToken, {4}, { Instruction::kRegister },
@@ -1076,14 +1075,14 @@ std::pair<CToken *, CToken *> IdaAsmParser::outputCallInstruction(CToken *token,
 
     constexpr int kProcNameMaxLength = ProcHookList::kProcNameLength;
 
-    static char tokenBuff[2 * sizeof(Token) + 4 + kProcNameMaxLength] = {
-        (char)Token::T_CALL, 0, Token::kInstruction, Token::kBranchInstruction, 0, 0, 0, 4, 0, 0, 0, 'c', 'a', 'l', 'l',
-        (char)Token::T_ID, 1, Token::kId,
-    };
-    static_assert(sizeof(Token) == 11, "Fix on enter hook tokens");
+    // proc name is filled in each time
+    static char tokenBuff[2 * sizeof(Token) + 4 + kProcNameMaxLength];
+
+    auto p = tokenBuff;
+    auto callToken = appendFixedToken(p, Token::T_CALL, Token::kInstruction, Token::kBranchInstruction, "call");
 
-    auto callToken = reinterpret_cast<CToken *>(tokenBuff);
-    auto procNameToken = callToken->next();
+    auto procNameToken = reinterpret_cast<Token *>(p);
+    *procNameToken = { Token::T_ID, Token::kId };
     procNameToken->textLength = kProcNameMaxLength;
 
     fillNameProc(procNameToken);
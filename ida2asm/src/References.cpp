@@ -73,12 +73,6 @@ bool References::hasReference(const String& str) const
     return ref && ref->type != kIgnore && ref->type != kNone;
 }
 
-bool References::hasPublic(const String& str) const
-{
-    auto label = m_labels.get(str);
-    return label && label->pub;
-}
-
 auto References::getType(const String& str) const -> std::pair<ReferenceType, String>
 {
     assert(!str.empty());
@@ -119,34 +113,12 @@ void References::seal()
     m_references.removeDuplicates();
 }
 
+// Externs of other chunks are resolved through SymbolIndex, once all the chunks are parsed.
 void References::resolve()
 {
-    resolve(*this);
-}
-
-void References::resolve(const References& rhs)
-{
-    for (const auto& ref : m_references) {
-        auto& type = ref.cargo->type;
-        if (type == kNone) {
-            auto label = rhs.m_labels.get(ref.text, ref.hash);
-            if (label) {
-                if (&rhs == this) {
-                    type = kIgnore;
-                } else {
-                    assert(label->type != kNone);
-                    type = label->type;
-
-                    if (type == kUser) {
-                        assert(!label->structPtr);
-                        ref.cargo->structPtr = label->structNameLength();
-                    }
-
-                    label->pub = 1;
-                }
-            }
-        }
-    }
+    for (const auto& ref : m_references)
+        if (ref.cargo->type == kNone && m_labels.get(ref.text, ref.hash))
+            ref.cargo->type = kIgnore;
 }
 
 void References::resolveSegments(const SegmentSet& segments)
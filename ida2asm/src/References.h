@@ -25,7 +25,6 @@ public:
     void markImport(const String& str);
     void markExport(const String& str);
     bool hasReference(const String& str) const;
-    bool hasPublic(const String& str) const;
     std::pair<ReferenceType, String> getType(const String& str) const;
 
     void setIgnored(const String& str, Util::hash_t hash);
@@ -33,13 +32,14 @@ public:
     void clear();
     void seal();
     void resolve();
-    void resolve(const References& rhs);
     void resolveSegments(const SegmentSet& segments);
 
     std::vector<String> publics() const;
     std::vector<std::tuple<String, ReferenceType, String, String>> externs() const;
 
 private:
+    friend class SymbolIndex;
+
     static bool isReference(const String& str);
 
     // optimize for the special case, they're extremely heavily used
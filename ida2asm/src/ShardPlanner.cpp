@@ -0,0 +1,298 @@
+#include "ShardPlanner.h"
+
+// Compile time of a function grows faster than its length, so the really big ones (updatePlayers comes to mind)
+// get penalized, in order to leave them alone in their files.
+constexpr int64_t kQuadraticWeightDivisor = 5'000;
+
+ShardPlanner::ShardPlanner(const char *data, int dataLength, int codeStart)
+    : m_data(data), m_dataLength(dataLength), m_codeStart(codeStart)
+{
+    assert(data && codeStart >= 0 && codeStart <= dataLength);
+}
+
+// Procs heavier than the fair share get a file of their own, and the rest are distributed so that each file
+// gets about the same share of the remaining weight. Order of procs is preserved.
+auto ShardPlanner::plan(int numShards) -> std::vector<Shard>
+{
+    assert(numShards > 0);
+
+    scanProcs();
+
+    if (static_cast<int>(m_procs.size()) < numShards || !m_totalWeight)
+        return equalSizeShards(numShards);
+
+    auto oversized = findOversizedProcs(numShards);
+
+    int64_t remainingWeight = 0;
+    int numOversizedLeft = 0;
+
+    for (size_t i = 0; i < m_procs.size(); i++) {
+        if (oversized[i])
+            numOversizedLeft++;
+        else
+            remainingWeight += m_procs[i].weight;
+    }
+
+    ProcRanges ranges{ { 0, 0 } };
+    int64_t currentWeight = 0;
+
+    auto startNewRange = [&](size_t firstProc) {
+        remainingWeight -= currentWeight;
+        currentWeight = 0;
+        ranges.emplace_back(firstProc, firstProc);
+    };
+
+    for (size_t i = 0; i < m_procs.size(); i++) {
+        bool currentEmpty = ranges.back().first == ranges.back().second;
+
+        if (oversized[i]) {
+            if (!currentEmpty)
+                startNewRange(i);
+
+            ranges.back().second = i + 1;
+            numOversizedLeft--;
+            ranges.emplace_back(i + 1, i + 1);
+            continue;
+        }
+
+        // cut before this proc if it would take the file further from its share than it is now
+        int numShardsLeft = numShards - static_cast<int>(ranges.size()) + 1 - numOversizedLeft;
+        auto fairShare = remainingWeight / std::max(numShardsLeft, 1);
+
+        if (!currentEmpty && numShardsLeft > 1 && currentWeight + m_procs[i].weight / 2 > fairShare)
+            startNewRange(i);
+
+        ranges.back().second = i + 1;
+        currentWeight += m_procs[i].weight;
+    }
+
+    if (ranges.back().first == ranges.back().second)
+        ranges.pop_back();
+
+    fixShardCount(ranges, numShards);
+
+    return rangesToShards(ranges);
+}
+
+void ShardPlanner::showReport(const std::vector<Shard>& shards) const
+{
+    if (m_procs.empty())
+        return;
+
+    std::vector<std::pair<const ProcInfo *, size_t>> procs;
+    size_t shardIndex = 0;
+
+    for (const auto& proc : m_procs) {
+        while (shardIndex + 1 < shards.size() && proc.offset > shards[shardIndex + 1].offset)
+            shardIndex++;
+        procs.emplace_back(&proc, shardIndex + 1);
+    }
+
+    auto numReported = std::min<size_t>(kNumHeaviestProcsReported, procs.size());
+    std::partial_sort(procs.begin(), procs.begin() + numReported, procs.end(), [](const auto& p1, const auto& p2) {
+        return p1.first->weight > p2.first->weight;
+    });
+
+    std::cout << "Heaviest procs:\n";
+    for (size_t i = 0; i < numReported; i++) {
+        const auto& [proc, shard] = procs[i];
+        std::cout << "    " << proc->name.string() << ": " << Util::formatDelimitedNumber(proc->numLines) <<
+            " lines, weight " << Util::formatDelimitedNumber(proc->weight) << ", file " << shard << '\n';
+    }
+
+    auto [lightest, heaviest] = std::minmax_element(shards.begin(), shards.end(), [](const auto& s1, const auto& s2) {
+        return s1.weight < s2.weight;
+    });
+
+    std::cout << "Output file weights (average " << Util::formatDelimitedNumber(m_totalWeight / shards.size()) <<
+        ", lightest " << Util::formatDelimitedNumber(lightest->weight) << " in file " << lightest - shards.begin() + 1 <<
+        ", heaviest " << Util::formatDelimitedNumber(heaviest->weight) << " in file " << heaviest - shards.begin() + 1 << "):";
+
+    for (const auto& shard : shards)
+        std::cout << ' ' << Util::formatDelimitedNumber(shard.weight);
+
+    std::cout << '\n';
+}
+
+// Quick line based scan, looking only for "<name> proc" and "<name> endp" lines. Every non-empty, non-comment
+// line inside a proc counts as an instruction.
+void ShardPlanner::scanProcs()
+{
+    m_procs.clear();
+    m_totalWeight = 0;
+
+    ProcInfo *currentProc = nullptr;
+
+    for (auto p = m_data + m_codeStart, end = m_data + m_dataLength; p < end; ) {
+        auto lineStart = p;
+        auto lineEnd = reinterpret_cast<const char *>(memchr(p, '\n', end - p));
+        if (!lineEnd)
+            lineEnd = end;
+
+        p = lineEnd + 1;
+
+        while (lineStart < lineEnd && Util::isSpace(*lineStart))
+            lineStart++;
+
+        if (lineStart == lineEnd || *lineStart == ';')
+            continue;
+
+        auto nameEnd = lineStart;
+        while (nameEnd < lineEnd && !Util::isSpace(*nameEnd))
+            nameEnd++;
+
+        auto keyword = nameEnd;
+        while (keyword < lineEnd && Util::isSpace(*keyword))
+            keyword++;
+
+        if (isKeyword(keyword, lineEnd, "proc")) {
+            m_procs.push_back({ { lineStart, nameEnd }, static_cast<int>(lineStart - m_data), 0, 0 });
+            currentProc = &m_procs.back();
+        } else if (isKeyword(keyword, lineEnd, "endp")) {
+            if (currentProc) {
+                currentProc->weight = procWeight(currentProc->numLines);
+                m_totalWeight += currentProc->weight;
+                currentProc = nullptr;
+            }
+        } else if (currentProc) {
+            currentProc->numLines++;
+        }
+    }
+
+    // procs start where their line starts, leading comments are taken care of when the chunk limits are found
+    for (auto& proc : m_procs) {
+        while (proc.offset > 0 && m_data[proc.offset - 1] != '\n')
+            proc.offset--;
+    }
+}
+
+// Finds procs that are heavier than what each file would get if they were distributed evenly. Repeat after
+// taking them out, since that lowers the share of the others.
+std::vector<bool> ShardPlanner::findOversizedProcs(int numShards) const
+{
+    std::vector<bool> oversized(m_procs.size());
+    int numOversized = 0;
+    auto weight = m_totalWeight;
+
+    for (bool changed = true; changed; ) {
+        changed = false;
+        auto fairShare = weight / (numShards - numOversized);
+
+        for (size_t i = 0; i < m_procs.size() && numOversized < numShards - 1; i++) {
+            if (!oversized[i] && m_procs[i].weight > fairShare) {
+                oversized[i] = true;
+                numOversized++;
+                weight -= m_procs[i].weight;
+                changed = true;
+            }
+        }
+    }
+
+    return oversized;
+}
+
+// Greedy pass might be off by a few files at the end, merge the lightest neighbours or split the heaviest
+// ones until the count is right.
+void ShardPlanner::fixShardCount(ProcRanges& ranges, int numShards) const
+{
+    auto rangeWeight = [this](size_t first, size_t end) {
+        int64_t weight = 0;
+        for (auto i = first; i < end; i++)
+            weight += m_procs[i].weight;
+        return weight;
+    };
+
+    while (static_cast<int>(ranges.size()) > numShards) {
+        size_t lightest = 0;
+        auto lightestWeight = std::numeric_limits<int64_t>::max();
+
+        for (size_t i = 0; i + 1 < ranges.size(); i++) {
+            auto weight = rangeWeight(ranges[i].first, ranges[i + 1].second);
+            if (weight < lightestWeight) {
+                lightest = i;
+                lightestWeight = weight;
+            }
+        }
+
+        ranges[lightest].second = ranges[lightest + 1].second;
+        ranges.erase(ranges.begin() + lightest + 1);
+    }
+
+    while (static_cast<int>(ranges.size()) < numShards) {
+        auto heaviest = ranges.end();
+        int64_t heaviestWeight = -1;
+
+        for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+            auto weight = rangeWeight(it->first, it->second);
+            if (it->second - it->first > 1 && weight > heaviestWeight) {
+                heaviest = it;
+                heaviestWeight = weight;
+            }
+        }
+
+        assert(heaviest != ranges.end());
+
+        auto split = heaviest->first + 1;
+        for (int64_t weight = m_procs[heaviest->first].weight; split + 1 < heaviest->second; split++) {
+            weight += m_procs[split].weight;
+            if (2 * weight > heaviestWeight)
+                break;
+        }
+
+        auto end = heaviest->second;
+        heaviest->second = split;
+        ranges.emplace(heaviest + 1, split, end);
+    }
+}
+
+auto ShardPlanner::rangesToShards(const ProcRanges& ranges) const -> std::vector<Shard>
+{
+    std::vector<Shard> shards;
+
+    for (const auto& [first, end] : ranges) {
+        int offset = first ? m_procs[first].offset - 1 : m_codeStart - static_cast<int>(Util::kNewLine.size());
+        Shard shard{ offset, 0, 0, end - first };
+
+        for (auto i = first; i < end; i++)
+            shard.weight += m_procs[i].weight;
+
+        shards.push_back(shard);
+    }
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        auto end = i + 1 < shards.size() ? shards[i + 1].offset : m_dataLength;
+        shards[i].length = end - shards[i].offset;
+    }
+
+    return shards;
+}
+
+auto ShardPlanner::equalSizeShards(int numShards) const -> std::vector<Shard>
+{
+    std::vector<Shard> shards;
+
+    int remainingLength = m_dataLength - m_codeStart;
+    int blockSize = remainingLength / numShards;
+
+    for (int i = 0; i < numShards; i++) {
+        int offset = m_codeStart - static_cast<int>(Util::kNewLine.size()) + i * blockSize;
+        shards.push_back({ offset, blockSize, 0, 0 });
+    }
+
+    return shards;
+}
+
+int64_t ShardPlanner::procWeight(int numLines)
+{
+    return numLines + static_cast<int64_t>(numLines) * numLines / kQuadraticWeightDivisor;
+}
+
+bool ShardPlanner::isKeyword(const char *p, const char *end, const char *keyword)
+{
+    auto len = strlen(keyword);
+
+    if (end - p < static_cast<ptrdiff_t>(len) || _strnicmp(p, keyword, len))
+        return false;
+
+    return p + len == end || Util::isSpace(p[len]);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Splits code part of the input into chunks (each one becoming a separate output file) with about the same
+// estimated cost of compiling the generated code, as opposed to the same number of bytes. Chunks only ever
+// start at proc boundaries, and keep the order of the input.
+class ShardPlanner
+{
+public:
+    struct Shard {
+        int offset;         // points to the new line before the first line of the chunk
+        int length;
+        int64_t weight;
+        size_t numProcs;
+    };
+
+    ShardPlanner(const char *data, int dataLength, int codeStart);
+    std::vector<Shard> plan(int numShards);
+    void showReport(const std::vector<Shard>& shards) const;
+
+private:
+    struct ProcInfo {
+        String name;
+        int offset;
+        int numLines;
+        int64_t weight;
+    };
+
+    using ProcRanges = std::vector<std::pair<size_t, size_t>>;
+
+    static constexpr int kNumHeaviestProcsReported = 10;
+
+    void scanProcs();
+    std::vector<bool> findOversizedProcs(int numShards) const;
+    void fixShardCount(ProcRanges& ranges, int numShards) const;
+    std::vector<Shard> rangesToShards(const ProcRanges& ranges) const;
+    std::vector<Shard> equalSizeShards(int numShards) const;
+    static int64_t procWeight(int numLines);
+    static bool isKeyword(const char *p, const char *end, const char *keyword);
+
+    const char *m_data;
+    int m_dataLength;
+    int m_codeStart;
+
+    std::vector<ProcInfo> m_procs;
+    int64_t m_totalWeight = 0;
+};
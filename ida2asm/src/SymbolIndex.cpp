@@ -0,0 +1,87 @@
+#include "SymbolIndex.h"
+
+void SymbolIndex::build(const std::vector<References *>& chunkReferences)
+{
+    m_symbols.clear();
+    m_numLabels = 0;
+
+    size_t numEntries = 0;
+    for (const auto references : chunkReferences)
+        numEntries += references->m_labels.count() + references->m_references.count();
+
+    m_symbols.reserve(numEntries);
+
+    for (const auto references : chunkReferences) {
+        for (const auto& label : references->m_labels) {
+            m_symbols[{ label.text, label.hash }].labels.push_back({ label.cargo, references });
+            m_numLabels++;
+        }
+
+        for (const auto& ref : references->m_references)
+            m_symbols[{ ref.text, ref.hash }].references.push_back(ref.cargo);
+    }
+}
+
+// Each extern gets the type of the first label with its name, and the label is marked as public. Runs on multiple
+// chunks in parallel; labels are only ever marked public, so it doesn't matter who gets there first.
+void SymbolIndex::resolve(References& references) const
+{
+    for (const auto& ref : references.m_references) {
+        auto& type = ref.cargo->type;
+
+        if (type != References::kNone)
+            continue;
+
+        if (auto entry = find(ref.text, ref.hash)) {
+            for (const auto& label : entry->labels) {
+                if (label.owner != &references) {
+                    assert(label.holder->type != References::kNone);
+                    type = label.holder->type;
+
+                    if (type == References::kUser) {
+                        assert(!label.holder->structPtr);
+                        ref.cargo->structPtr = label.holder->structNameLength();
+                    }
+
+                    label.holder->pub = 1;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// Symbol is used if any chunk references it (and it resolved to something), or exports it.
+bool SymbolIndex::isUsed(const String& symbol) const
+{
+    auto entry = find(symbol, Util::hash(symbol.data(), symbol.length()));
+
+    if (!entry)
+        return false;
+
+    for (const auto ref : entry->references)
+        if (ref->type != References::kIgnore && ref->type != References::kNone)
+            return true;
+
+    for (const auto& label : entry->labels)
+        if (label.holder->pub)
+            return true;
+
+    return false;
+}
+
+size_t SymbolIndex::numSymbols() const
+{
+    return m_symbols.size();
+}
+
+size_t SymbolIndex::numLabels() const
+{
+    return m_numLabels;
+}
+
+auto SymbolIndex::find(const String& text, Util::hash_t hash) const -> const Entry *
+{
+    auto it = m_symbols.find({ text, hash });
+    return it != m_symbols.end() ? &it->second : nullptr;
+}
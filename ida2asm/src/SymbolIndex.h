@@ -0,0 +1,52 @@
+#pragma once
+
+#include "References.h"
+
+// Labels and references of all the chunks merged into a single hash table, built once every chunk is parsed.
+// Replaces looking symbols up in each chunk's references in turn, which made the cost grow with the number of
+// chunks. Only holds pointers to the chunks' own data, so it sees all the changes made during resolution.
+class SymbolIndex
+{
+public:
+    void build(const std::vector<References *>& chunkReferences);
+
+    // Resolves externs of a chunk against the labels defined in the other chunks.
+    void resolve(References& references) const;
+    bool isUsed(const String& symbol) const;
+
+    size_t numSymbols() const;
+    size_t numLabels() const;
+
+private:
+    using RefHolder = References::RefHolder;
+
+    struct Key {
+        String text;
+        Util::hash_t hash;
+
+        bool operator==(const Key& rhs) const {
+            return hash == rhs.hash && text == rhs.text;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return key.hash;
+        }
+    };
+
+    struct Label {
+        RefHolder *holder;
+        const References *owner;
+    };
+
+    struct Entry {
+        std::vector<Label> labels;      // in chunk order
+        std::vector<RefHolder *> references;
+    };
+
+    const Entry *find(const String& text, Util::hash_t hash) const;
+
+    std::unordered_map<Key, Entry, KeyHash> m_symbols;
+    size_t m_numLabels = 0;
+};
@@ -51,6 +51,7 @@ auto Tokenizer::tokenize(const char *data, long size, long hardSize) -> TokenRan
     // if it's max number of tokens (one letter, one space sequence) => (n / 2) * sizeof(Token) + n / 2
     // ie. (n / 2) * (sizeof(Token) + 1)
     // assuming input size >> sizeof(Token)
+    // (verbatim tokens only keep an offset to their text, so they need even less)
 
     assert(!m_tokenData && data && size);
 
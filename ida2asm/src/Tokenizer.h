@@ -51,7 +51,20 @@ struct Token
     };
 
     inline const char *text() const {
-        return (char *)(this + 1);
+        return sourceOffset ? (char *)this + sourceOffset : (char *)(this + 1);
+    }
+    // Points the token to its text in the input. In the unlikely case the text is out of reach of a 32-bit offset
+    // it gets copied after the struct instead, there's always room reserved for it.
+    inline void setSourceText(const char *source, uint32_t length) {
+        auto offset = source - (char *)this;
+        textLength = length;
+
+        if (offset == static_cast<int32_t>(offset)) {
+            sourceOffset = static_cast<int32_t>(offset);
+        } else {
+            sourceOffset = 0;
+            memcpy(this + 1, source, length);
+        }
     }
     inline void copyText(char *buf) const {
         memcpy(buf, text(), textLength);
@@ -115,10 +128,11 @@ struct Token
         return std::string(text(), textLength);
     }
     inline Token *next() const {
-        return (Token *)((char *)(this + 1) + textLength);
+        return (Token *)((char *)(this + 1) + (sourceOffset ? 0 : textLength));
     }
     inline bool operator==(const Token& rhs) const {
-        return textLength == rhs.textLength && !memcmp(this, &rhs, sizeof(*this) + textLength);
+        return textLength == rhs.textLength && !memcmp(this, &rhs, offsetof(Token, sourceOffset)) &&
+            !memcmp(text(), rhs.text(), textLength);
     }
     inline bool operator==(char c) const {
         return textLength == 1 && text()[0] == c;
@@ -158,7 +172,10 @@ struct Token
         NoBreakStatus noBreakStatus;
         Util::hash_t hash;
     };
-    uint32_t textLength;  // length of text which is trailing the struct
+    uint32_t textLength;
+    // offset of the text in the input from the token itself if it was taken verbatim, zero if the text is trailing
+    // the struct
+    int32_t sourceOffset;
 };
 #pragma pack(pop)
 
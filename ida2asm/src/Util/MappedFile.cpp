@@ -0,0 +1,185 @@
+#include "MappedFile.h"
+#include "Util.h"
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
+
+// sentinel needs room for a terminating zero, and possibly for a new line in front of it
+constexpr size_t kMaxSentinelLength = 3;
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+// Exits if the file can't be opened or read, same as Util::loadFile().
+void MappedFile::open(const char *path, bool forceLastNewLine /* = false */)
+{
+    close();
+
+    if (!map(path, forceLastNewLine)) {
+        auto result = Util::loadFile(path, forceLastNewLine);
+        m_copy.reset(result.first);
+        m_data = result.first;
+        m_size = result.second;
+    }
+}
+
+void MappedFile::close()
+{
+    if (m_view) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_view);
+#else
+        munmap(m_view, m_viewSize);
+#endif
+    }
+
+    m_view = nullptr;
+    m_viewSize = 0;
+    m_copy.reset();
+    m_data = nullptr;
+    m_size = 0;
+}
+
+const char *MappedFile::data() const
+{
+    return m_data;
+}
+
+// Size of the file itself, excluding the sentinel.
+long MappedFile::size() const
+{
+    return m_size;
+}
+
+bool MappedFile::isMapped() const
+{
+    return m_view != nullptr;
+}
+
+bool MappedFile::map(const char *path, bool forceLastNewLine)
+{
+    size_t size;
+    if (!mapView(path, size))
+        return false;
+
+    // pages past the end of file are already zeroed, only touch them if the new line is missing
+    auto data = static_cast<char *>(m_view);
+
+    if (forceLastNewLine && data[size - 1] != '\n') {
+        data[size] = '\r';
+        data[size + 1] = '\n';
+        data[size + 2] = '\0';
+    }
+
+    m_data = data;
+    m_size = static_cast<long>(size);
+
+    return true;
+}
+
+#ifdef _WIN32
+// There's no reserving extra pages past the view here, so the sentinel must fit into the zero-filled remainder of
+// the last page. When the file size is page aligned we give up and let the caller load it instead.
+bool MappedFile::mapView(const char *path, size_t& size)
+{
+    auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        Util::exit("Could not open file: %s\n", 1, path);
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+        Util::exit("Could not get size of file: %s\n", 1, path);
+
+    size = static_cast<size_t>(fileSize.QuadPart);
+    auto tail = size % pageSize();
+
+    if (!size || !tail || pageSize() - tail < kMaxSentinelLength ||
+        size > static_cast<size_t>(std::numeric_limits<long>::max())) {
+        CloseHandle(file);
+        return false;
+    }
+
+    auto mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (!mapping)
+        return false;
+
+    // the view keeps its own reference to the mapping object
+    m_view = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (!m_view)
+        return false;
+
+    m_viewSize = size + pageSize() - tail;
+
+    return true;
+}
+#else
+// Reserves one extra page past the end of the file, and maps the file over the start of the reservation, so the
+// sentinel always has a zero-filled page to go into.
+bool MappedFile::mapView(const char *path, size_t& size)
+{
+    auto fd = ::open(path, O_RDONLY);
+    if (fd < 0)
+        Util::exit("Could not open file: %s\n", 1, path);
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo))
+        Util::exit("Could not get size of file: %s\n", 1, path);
+
+    size = static_cast<size_t>(fileInfo.st_size);
+
+    if (!size || size > static_cast<size_t>(std::numeric_limits<long>::max())) {
+        ::close(fd);
+        return false;
+    }
+
+    auto viewSize = (size + pageSize() - 1) / pageSize() * pageSize() + pageSize();
+
+    auto view = mmap(nullptr, viewSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    auto fileView = mmap(view, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    ::close(fd);
+
+    if (fileView == MAP_FAILED) {
+        munmap(view, viewSize);
+        return false;
+    }
+
+    m_view = view;
+    m_viewSize = viewSize;
+
+    return true;
+}
+#endif
+
+size_t MappedFile::pageSize()
+{
+    static const size_t s_pageSize = []() {
+#ifdef _WIN32
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return static_cast<size_t>(info.dwPageSize);
+#else
+        return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    }();
+
+    return s_pageSize;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+// Read-only view of an input file, mapped copy-on-write straight into memory instead of being read into a heap buffer.
+// Data is always followed by a zero byte, and optionally by a forced final new line, written into the sentinel area
+// past the end of the file. Falls back to loading the file the usual way if there's no room for that.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    void open(const char *path, bool forceLastNewLine = false);
+    void close();
+
+    const char *data() const;
+    long size() const;
+    bool isMapped() const;
+
+private:
+    bool map(const char *path, bool forceLastNewLine);
+    bool mapView(const char *path, size_t& size);
+    static size_t pageSize();
+
+    const char *m_data = nullptr;
+    long m_size = 0;
+
+    void *m_view = nullptr;
+    size_t m_viewSize = 0;
+
+    std::unique_ptr<const char[]> m_copy;
+};
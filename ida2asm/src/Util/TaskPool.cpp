@@ -0,0 +1,45 @@
+#include "TaskPool.h"
+
+// Default is to use all the cores.
+TaskPool::TaskPool(int numThreads /* = 0 */)
+{
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    m_numThreads = numThreads;
+}
+
+int TaskPool::numThreads() const
+{
+    return m_numThreads;
+}
+
+void TaskPool::run(size_t numTasks, std::function<void(size_t index)> task)
+{
+    std::vector<size_t> order(numTasks);
+    std::iota(order.begin(), order.end(), 0);
+
+    run(order, task);
+}
+
+// Give the biggest tasks first place in the order, and the small ones will fill in the gaps at the end.
+void TaskPool::run(const std::vector<size_t>& order, std::function<void(size_t index)> task)
+{
+    std::atomic<size_t> nextTask{ 0 };
+
+    auto processTasks = [&]() {
+        for (size_t i; (i = nextTask++) < order.size(); )
+            task(order[i]);
+    };
+
+    auto numThreads = std::min<size_t>(m_numThreads, order.size());
+    std::vector<std::future<void>> futures;
+
+    for (size_t i = 1; i < numThreads; i++)
+        futures.push_back(std::async(std::launch::async, processTasks));
+
+    processTasks();
+
+    for (auto& future : futures)
+        future.get();
+}
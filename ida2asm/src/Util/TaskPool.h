@@ -0,0 +1,18 @@
+#pragma once
+
+// Runs batches of independent tasks on a fixed number of threads, regardless of how many tasks there are.
+// Tasks are handed out one at a time, so a thread that's done with a quick task just takes the next one instead
+// of waiting on a thread stuck with a big one. Calling thread takes part too.
+class TaskPool
+{
+public:
+    TaskPool(int numThreads = 0);
+    int numThreads() const;
+
+    // Runs task(i) for i in [0, numTasks), in the given order of priority, and waits for all of them to finish.
+    void run(size_t numTasks, std::function<void(size_t index)> task);
+    void run(const std::vector<size_t>& order, std::function<void(size_t index)> task);
+
+private:
+    int m_numThreads;
+};
@@ -90,6 +90,31 @@ std::pair<const char *, long> Util::loadFile(const char *path, bool forceLastNew
     return std::make_pair(data, size);
 }
 
+// Leaves the file alone (and its timestamp intact) if it already holds exactly the given contents, so that the
+// build system doesn't recompile anything that depends on it. Text mode files are compared after conversion.
+auto Util::writeFileIfChanged(const char *path, const char *data, size_t size, bool textMode /* = false */) -> WriteFileResult
+{
+    if (auto f = fopen(path, textMode ? "r" : "rb")) {
+        std::unique_ptr<char[]> buf(new char[size + 1]);
+        auto sizeRead = fread(buf.get(), 1, size + 1, f);
+        fclose(f);
+
+        if (sizeRead == size && !memcmp(buf.get(), data, size))
+            return kFileUnchanged;
+    }
+
+    auto f = fopen(path, textMode ? "w" : "wb");
+    if (!f)
+        return kWriteFailed;
+
+    std::setbuf(f, nullptr);
+
+    bool ok = !size || fwrite(data, size, 1, f) == 1;
+    ok = !fclose(f) && ok;
+
+    return ok ? kFileWritten : kWriteFailed;
+}
+
 bool Util::endsWith(const std::string& base, const std::string& suffix)
 {
     return base.size() >= suffix.size() && !base.compare(base.size() - suffix.size(), suffix.size(), suffix);
@@ -29,6 +29,29 @@ namespace Util {
 
         return hash;
     }
+    // 64-bit FNV-1a, for fingerprints that have to stay unique across many thousands of items
+    using hash64_t = uint64_t;
+    constexpr hash64_t kInitialHash64Value = 0xcbf29ce484222325;
+
+    static inline hash64_t hash64(const void *data, size_t length, hash64_t hash = kInitialHash64Value)
+    {
+        auto p = reinterpret_cast<const uint8_t *>(data);
+
+        for (size_t i = 0; i < length; i++) {
+            hash ^= p[i];
+            hash *= 0x100000001b3;
+        }
+
+        return hash;
+    }
+
+    template <typename T>
+    inline hash64_t hash64Value(const T& value, hash64_t hash)
+    {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "only plain values please");
+        return hash64(&value, sizeof(value), hash);
+    }
+
     template <size_t N>
     inline constexpr hash_t constHash(const char(&p)[N])
     {
@@ -71,6 +94,9 @@ namespace Util {
     std::string joinPaths(const std::string& dest, const char *additionalComponent);
     std::pair<const char *, long> loadFile(const char *path, bool forceLastNewLine = false);
 
+    enum WriteFileResult { kWriteFailed, kFileUnchanged, kFileWritten };
+    WriteFileResult writeFileIfChanged(const char *path, const char *data, size_t size, bool textMode = false);
+
     bool endsWith(const std::string& base, const std::string& suffix);
     template <size_t N>
     bool endsWith(const std::string& base, const std::array<char, N>& arr)
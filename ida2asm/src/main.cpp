@@ -15,18 +15,23 @@ struct CommandLineParameters {
     const char *swosHeaderPath;
     const char *format;
     int numOutputFiles;
+    int numThreads;
     int extraMemorySize;
     bool disableOptimizations;
     bool disableAlignmentChecks;
+    bool disableProcCache;
+    bool instrumentProcs;
+    const char *procProfilePath;
 };
 
-constexpr int kMaxOutputFiles = 20;
+constexpr int kMaxOutputFiles = 64;
 
 static CommandLineParameters getCommandLineParameters(int argc, char **argv)
 {
     if (argc < 2 || !strcmp(argv[1], "-h") || !strcmp(argv[1], "--help"))
         Util::exit("usage: %s <input IDA asm file path> <output asm files path> <input symbols file> <SWOS header path>\n"
-            "       <format> <number of output files> [--disable-optimizations] [--extra-memory-size=<int>]\n",
+            "       <format> <number of output files> [--disable-optimizations] [--extra-memory-size=<int>]\n"
+            "       [--disable-proc-cache] [--threads=<int>] [--instrument-procs] [--proc-profile=<path>]\n",
             EXIT_SUCCESS, Util::getFilename(argv[0]));
 
     if (argc < 3)
@@ -49,23 +54,38 @@ static CommandLineParameters getCommandLineParameters(int argc, char **argv)
         Util::exit("Too many output files given, it should be at most %d files.", EXIT_FAILURE, kMaxOutputFiles);
 
     int extraMemorySize = 0;
+    int numThreads = 0;
     bool disableOptimizations = false;
     bool disableAlignmentChecks = false;
+    bool disableProcCache = false;
+    bool instrumentProcs = false;
+    const char *procProfilePath = nullptr;
     for (int i = 7; i < argc; i++) {
         if (argv[i][0] == '-' && argv[i][1] == '-') {
             constexpr char kExtraMemorySize[] = "extra-memory-size=";
+            constexpr char kThreads[] = "threads=";
+            constexpr char kProcProfile[] = "proc-profile=";
             if (!strcmp(argv[i] + 2, "disable-optimizations")) {
                 disableOptimizations = true;
             } else if (!strcmp(argv[i] + 2, "disable-alignment-checks")) {
                 disableAlignmentChecks = true;
+            } else if (!strcmp(argv[i] + 2, "disable-proc-cache")) {
+                disableProcCache = true;
+            } else if (!strcmp(argv[i] + 2, "instrument-procs")) {
+                instrumentProcs = true;
             } else if (!strncmp(argv[i] + 2, kExtraMemorySize, sizeof(kExtraMemorySize) - 1)) {
                 auto sizePtr = argv[i] + 2 + sizeof(kExtraMemorySize) - 1;
                 extraMemorySize = atoi(sizePtr);
+            } else if (!strncmp(argv[i] + 2, kThreads, sizeof(kThreads) - 1)) {
+                numThreads = atoi(argv[i] + 2 + sizeof(kThreads) - 1);
+            } else if (!strncmp(argv[i] + 2, kProcProfile, sizeof(kProcProfile) - 1)) {
+                procProfilePath = argv[i] + 2 + sizeof(kProcProfile) - 1;
             }
         }
     }
 
-    return { argv[1], argv[2], argv[3], argv[4], argv[5], numFiles, extraMemorySize, disableOptimizations, disableAlignmentChecks };
+    return { argv[1], argv[2], argv[3], argv[4], argv[5], numFiles, numThreads, extraMemorySize, disableOptimizations, disableAlignmentChecks,
+        disableProcCache, instrumentProcs, procProfilePath };
 }
 
 static auto start = std::chrono::high_resolution_clock::now();
@@ -90,8 +110,8 @@ int main(int argc, char **argv)
 
     SymbolFileParser symFileParser(params.symbolFilePath, params.swosHeaderPath, params.outputPath);
     InputConverter converter(params.inputPath, params.outputPath, params.swosHeaderPath, format,
-        params.numOutputFiles, params.extraMemorySize, params.disableOptimizations,
-        params.disableAlignmentChecks, symFileParser);
+        params.numOutputFiles, params.numThreads, params.extraMemorySize, params.disableOptimizations,
+        params.disableAlignmentChecks, params.disableProcCache, params.instrumentProcs, params.procProfilePath, symFileParser);
     converter.convert();
 
     return EXIT_SUCCESS;
@@ -2,6 +2,7 @@
 #include "file.h"
 #include "hash.h"
 #include "util.h"
+#include "zip.h"
 #include <dirent.h>
 
 SampleTable::SampleTable(const char *dir, int dirLen, uint32_t dirHash)
@@ -13,6 +14,7 @@ SampleTable::SampleTable(const char *dir, int dirLen, uint32_t dirHash)
 void SampleTable::reset()
 {
     m_samples.clear();
+    m_sampleHashes.clear();
     m_lastPlayedIndex = -1;
     m_totalSampleChance = 0;
 }
@@ -51,6 +53,9 @@ Mix_Chunk *SampleTable::getRandomSample(const Mix_Chunk *lastPlayedSample, size_
 
         logWarn("Failed to load comment %d from directory %s", sampleIndex, m_dir);
         m_totalSampleChance -= m_samples[sampleIndex].chanceModifier();
+        auto hashIt = m_sampleHashes.find(m_samples[sampleIndex].contentHash());
+        if (hashIt != m_sampleHashes.end())
+            m_sampleHashes.erase(hashIt);
         m_samples.erase(m_samples.begin() + sampleIndex);
         m_lastPlayedIndex -= m_lastPlayedIndex >= static_cast<int>(sampleIndex);
         sampleIndex -= sampleIndex == m_samples.size();
@@ -75,18 +80,23 @@ void SampleTable::loadSamples(const std::string& baseDir)
     });
 }
 
-void SampleTable::addSample(const char *filename, int filenameLen, char *buf, int bufLen)
+void SampleTable::addSample(const char *filename, int filenameLen, ZipArchive& archive, int entryIndex)
 {
     int chance = parseSampleChanceMultiplier(filename, filenameLen);
-    SoundSample sample(filename, buf, bufLen, chance);
+    SoundSample sample(filename, archive, entryIndex, chance);
     addSample(sample, filename);
 }
 
 void SampleTable::addSample(const SoundSample& sample, const char *path)
 {
     if (sample.hasData()) {
-        if (std::find(m_samples.begin(), m_samples.end(), sample) == m_samples.end()) {
+        // only do the full comparison when the content hash matches, to avoid quadratic comparisons while loading
+        bool isDuplicate = m_sampleHashes.count(sample.contentHash()) &&
+            std::find(m_samples.begin(), m_samples.end(), sample) != m_samples.end();
+
+        if (!isDuplicate) {
             m_samples.push_back(sample);
+            m_sampleHashes.insert(sample.contentHash());
             m_totalSampleChance += sample.chanceModifier();
 #ifndef DEBUG
             logInfo("`%s' loaded OK, chance: %d", path, sample.chanceModifier());
@@ -99,6 +109,57 @@ void SampleTable::addSample(const SoundSample& sample, const char *path)
     }
 }
 
+// Decodes samples into chunks ahead of time. Zipped samples are only decoded while they fit into the given budget,
+// which gets reduced by the memory they take. They get decompressed in parallel, and decoded in table order as they
+// arrive. Returns number of chunks decoded.
+int SampleTable::predecodeSamples(const std::atomic<bool>& stop, size_t& zippedBudget)
+{
+    int numDecoded = 0;
+    std::vector<SoundSample *> zippedSamples;
+    std::vector<ZipArchive::ReadRequest> requests;
+
+    for (auto& sample : m_samples) {
+        if (stop)
+            return numDecoded;
+        if (sample.isChunkLoaded() || !sample.hasData())
+            continue;
+
+        if (sample.isZipped()) {
+            // all the zipped samples come from the commentary archive
+            assert(zippedSamples.empty() || zippedSamples.front()->archive() == sample.archive());
+            zippedSamples.push_back(&sample);
+            requests.push_back({ sample.archiveEntryIndex(), sample.archiveExtraSpace() });
+        } else if (sample.chunk()) {
+            numDecoded++;
+        }
+    }
+
+    if (requests.empty() || !zippedBudget)
+        return numDecoded;
+
+    size_t i = 0;
+    zippedSamples.front()->archive()->readEntries(requests, [&](int, char *buffer, int bufferLength) {
+        auto& sample = *zippedSamples[i++];
+        sample.setArchiveData(buffer, bufferLength);
+
+        if (sample.chunk())
+            numDecoded++;
+
+        zippedBudget -= std::min(zippedBudget, sample.residentSize());
+        return !stop && zippedBudget > 0;
+    });
+
+    return numDecoded;
+}
+
+// Appends zipped samples currently taking up memory to the given list.
+void SampleTable::getResidentZippedSamples(std::vector<SoundSample *>& samples)
+{
+    for (auto& sample : m_samples)
+        if (sample.isZipped() && sample.residentSize())
+            samples.push_back(&sample);
+}
+
 int SampleTable::getRandomSampleIndex() const
 {
     assert(m_totalSampleChance > 0 && m_totalSampleChance >= static_cast<int>(m_samples.size()));
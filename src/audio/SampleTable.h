@@ -13,7 +13,9 @@ public:
     uint32_t dirHash() const;
     Mix_Chunk *getRandomSample(const Mix_Chunk *lastPlayedSample, size_t lastPlayedHash);
     void loadSamples(const std::string& baseDir);
-    void addSample(const char *filename, int filenameLen, char *buf, int bufLen);
+    void addSample(const char *filename, int filenameLen, ZipArchive& archive, int entryIndex);
+    int predecodeSamples(const std::atomic<bool>& stop, size_t& zippedBudget);
+    void getResidentZippedSamples(std::vector<SoundSample *>& samples);
 
 private:
     void addSample(const SoundSample& sample, const char *path);
@@ -26,6 +28,7 @@ private:
     int m_dirLen;
     uint32_t m_dirHash;
     std::vector<SoundSample> m_samples;
+    std::unordered_multiset<uint64_t> m_sampleHashes;
     int m_lastPlayedIndex = -1;
     int m_totalSampleChance = 0;
 };
@@ -1,7 +1,11 @@
 #include "SoundSample.h"
 #include "wavFormat.h"
+#include "audioStats.h"
 #include "hash.h"
 #include "file.h"
+#include "zip.h"
+
+std::atomic<uint64_t> SoundSample::m_useCounter;
 
 const std::array<const char *, 5> SoundSample::kSupportedAudioExtensions = {{
     "raw", "mp3", "wav", "ogg", "flac",
@@ -20,11 +24,30 @@ SoundSample::SoundSample(const char *path, char *buf, int bufSize, int chance /*
     m_chanceModifier = chance;
 }
 
+// Only indexes the sample, data is decompressed from the archive when the sample is first needed.
+SoundSample::SoundSample(const char *path, ZipArchive& archive, int entryIndex, int chance /* = 1 */)
+{
+    const auto& entry = archive.entries()[entryIndex];
+
+    auto ext = getFileExtension(path);
+    m_isRaw = isRawExtension(ext + 1);
+    m_is11Khz = is11KhzSample(path);
+    m_size = entry.size + getAudioFileOffset(m_isRaw);
+    // zip entries already come with a checksum, so there's no need to decompress them just to get a hash
+    m_contentHash = makeContentHash(entry.crc, entry.size);
+    m_archive = &archive;
+    m_entryIndex = entryIndex;
+    m_chanceModifier = chance;
+}
+
 SoundSample::SoundSample(const SoundSample& other)
 {
     assign(other);
-    m_buffer.reset(new char[m_size]);
-    memcpy(m_buffer.get(), other.m_buffer.get(), m_size);
+
+    if (other.m_buffer) {
+        m_buffer.reset(new char[m_size]);
+        memcpy(m_buffer.get(), other.m_buffer.get(), m_size);
+    }
 }
 
 SoundSample::SoundSample(SoundSample&& other) noexcept
@@ -59,7 +82,16 @@ void SoundSample::free()
 {
     Mix_FreeChunk(m_chunk);
     m_chunk = nullptr;
-    m_buffer.release();
+    m_buffer.reset();
+}
+
+// Frees the memory taken by a zipped sample, it will get reloaded from the archive if needed again.
+void SoundSample::unload()
+{
+    assert(isZipped());
+
+    if (isZipped())
+        free();
 }
 
 bool SoundSample::loadFromFile(const char *path)
@@ -72,6 +104,8 @@ Mix_Chunk *SoundSample::chunk()
     if (!m_chunk)
         loadChunk();
 
+    m_lastUsed = ++m_useCounter;
+
     return m_chunk;
 }
 
@@ -82,7 +116,59 @@ bool SoundSample::isChunkLoaded() const
 
 bool SoundSample::hasData() const
 {
-    return m_buffer != nullptr;
+    return m_buffer != nullptr || m_archive;
+}
+
+bool SoundSample::isZipped() const
+{
+    return m_archive != nullptr;
+}
+
+ZipArchive *SoundSample::archive() const
+{
+    return m_archive;
+}
+
+int SoundSample::archiveEntryIndex() const
+{
+    return m_entryIndex;
+}
+
+// Returns how much space to leave in front of the decompressed data of a zipped sample.
+int SoundSample::archiveExtraSpace() const
+{
+    return getAudioFileOffset(m_isRaw);
+}
+
+// Hands over the data of a zipped sample that was decompressed elsewhere (takes ownership of the buffer), so it
+// doesn't have to be decompressed again when the chunk gets loaded.
+void SoundSample::setArchiveData(char *buffer, int size)
+{
+    assert(isZipped() && static_cast<unsigned>(size) == m_size);
+
+    if (m_buffer || m_chunk) {
+        delete[] buffer;
+        return;
+    }
+
+    m_buffer.reset(buffer);
+    m_size = size;
+}
+
+bool SoundSample::ownsChunk(const Mix_Chunk *chunk) const
+{
+    return chunk && chunk == m_chunk;
+}
+
+// Returns the number of bytes this sample is currently taking in memory.
+size_t SoundSample::residentSize() const
+{
+    return (m_buffer ? m_size : 0) + (m_chunk ? m_chunk->alen : 0);
+}
+
+uint64_t SoundSample::lastUsed() const
+{
+    return m_lastUsed;
 }
 
 int SoundSample::chanceModifier() const
@@ -100,12 +186,53 @@ unsigned SoundSample::hash() const
     return m_hash;
 }
 
+// CRC and size of the file data (excluding the space reserved for the wave header), available right after loading,
+// without having to decode the sample. It's the same for a loose file and its zipped copy.
+uint64_t SoundSample::contentHash() const
+{
+    return m_contentHash;
+}
+
 bool SoundSample::operator==(const SoundSample& other) const
 {
-    if (!m_buffer || !other.m_buffer)
+    if (!hasData() || !other.hasData())
         return false;
 
-    return m_hash == other.m_hash && m_size == other.m_size && !memcmp(m_buffer.get(), other.m_buffer.get(), m_size);
+    if (m_contentHash != other.m_contentHash || m_size != other.m_size || m_isRaw != other.m_isRaw)
+        return false;
+
+    // CRC is not enough to tell the samples apart, so confirm by content; zipped samples only get decompressed
+    // when their CRC and size match, which is rare
+    std::unique_ptr<char[]> tempBuffer, otherTempBuffer;
+    auto data = fileData(tempBuffer);
+    auto otherData = other.fileData(otherTempBuffer);
+
+    if (!data || !otherData)
+        return false;
+
+    // skip the header space of raw samples, it's uninitialized until the sample gets converted to wave
+    auto offset = getAudioFileOffset(m_isRaw);
+
+    return !memcmp(data + offset, otherData + offset, m_size - offset);
+}
+
+// Returns the file data of the sample, temporarily decompressing zipped samples which aren't loaded
+// (tempBuffer will own the data in that case).
+const char *SoundSample::fileData(std::unique_ptr<char[]>& tempBuffer) const
+{
+    if (m_buffer)
+        return m_buffer.get();
+
+    assert(m_archive);
+
+    auto data = m_archive->readEntry(m_entryIndex, getAudioFileOffset(m_isRaw));
+    if (!data.first || static_cast<unsigned>(data.second) != m_size) {
+        delete[] data.first;
+        return nullptr;
+    }
+
+    tempBuffer.reset(data.first);
+    return tempBuffer.get();
 }
 
 void SoundSample::assign(const SoundSample& other)
@@ -114,7 +241,11 @@ void SoundSample::assign(const SoundSample& other)
     m_isRaw = other.m_isRaw;
     m_is11Khz = other.m_is11Khz;
     m_hash = other.m_hash;
+    m_contentHash = other.m_contentHash;
     m_chanceModifier = other.m_chanceModifier;
+    m_archive = other.m_archive;
+    m_entryIndex = other.m_entryIndex;
+    m_lastUsed = other.m_lastUsed;
 }
 
 bool SoundSample::load(const char *path, char *buf /* = nullptr */, int bufSize /* = 0 */)
@@ -148,9 +279,17 @@ bool SoundSample::load(const char *path, char *buf /* = nullptr */, int bufSize
     m_isRaw = isRaw;
     m_is11Khz = is11KhzSample(path);
 
+    auto dataOffset = std::min(getAudioFileOffset(isRaw), bufSize);
+    m_contentHash = makeContentHash(zipCrc32(buf + dataOffset, bufSize - dataOffset), bufSize - dataOffset);
+
     return true;
 }
 
+uint64_t SoundSample::makeContentHash(uint32_t crc, int size)
+{
+    return (static_cast<uint64_t>(crc) << 32) | static_cast<uint32_t>(size);
+}
+
 // "Dresses up" raw into wave format since SDL Mix doesn't understand raw files.
 // Internal buffer was allocated with extra space at the beginning for the wave header.
 void SoundSample::convertRawToWav()
@@ -175,6 +314,11 @@ void SoundSample::convertRawToWav()
 
 void SoundSample::loadChunk()
 {
+    auto startTime = SDL_GetPerformanceCounter();
+
+    if (!m_buffer && m_archive && !loadFromArchive())
+        return;
+
     assert(!!m_buffer);
 
     if (m_buffer && !m_chunk) {
@@ -185,11 +329,35 @@ void SoundSample::loadChunk()
 
         if (m_chunk)
             m_hash = ::hash(m_chunk->abuf, m_chunk->alen);
+
+        recordSampleDecodeTime(startTime);
+
+        // the chunk has its own copy of the data, and the file data can always be decompressed again if needed
+        if (m_archive)
+            m_buffer.reset();
     }
 
     assert(m_chunk);
 }
 
+bool SoundSample::loadFromArchive()
+{
+    assert(m_archive && m_entryIndex >= 0);
+
+    auto data = m_archive->readEntry(m_entryIndex, getAudioFileOffset(m_isRaw));
+    if (!data.first) {
+        logWarn("Failed to decompress zipped sample %d", m_entryIndex);
+        return false;
+    }
+
+    assert(static_cast<unsigned>(data.second) == m_size);
+
+    m_buffer.reset(data.first);
+    m_size = data.second;
+
+    return true;
+}
+
 std::tuple<char *, unsigned, bool> SoundSample::loadWithAnyAudioExtension(const char *path, unsigned baseNameLength, const char *ext)
 {
     char buf[kMaxFilenameLength];
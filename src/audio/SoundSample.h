@@ -1,11 +1,14 @@
 #pragma once
 
+class ZipArchive;
+
 class SoundSample
 {
 public:
     SoundSample() = default;
     SoundSample(const char *path, int chance = 1);
     SoundSample(const char *path, char *buf, int bufSize, int chance = 1);
+    SoundSample(const char *path, ZipArchive& archive, int entryIndex, int chance = 1);
     SoundSample(const SoundSample& other);
     SoundSample(SoundSample&& other) noexcept;
     ~SoundSample();
@@ -16,24 +19,37 @@ public:
     static int additionalHeaderSize(const char *path);
 
     void free();
+    void unload();
     bool loadFromFile(const char *path);
 
     Mix_Chunk *chunk();
     bool isChunkLoaded() const;
     bool hasData() const;
+    bool isZipped() const;
+    ZipArchive *archive() const;
+    int archiveEntryIndex() const;
+    int archiveExtraSpace() const;
+    void setArchiveData(char *buffer, int size);
+    bool ownsChunk(const Mix_Chunk *chunk) const;
+    size_t residentSize() const;
+    uint64_t lastUsed() const;
     int chanceModifier() const;
     void setChanceModifier(int chanceModifier);
     unsigned hash() const;
+    uint64_t contentHash() const;
 
     bool operator==(const SoundSample& other) const;
 
 private:
     void assign(const SoundSample& other);
+    const char *fileData(std::unique_ptr<char[]>& tempBuffer) const;
     bool load(const char *path, char *buf = nullptr, int bufSize = 0);
     void convertRawToWav();
     void loadChunk();
+    bool loadFromArchive();
     std::tuple<char *, unsigned, bool> loadWithAnyAudioExtension(const char *path, unsigned baseNameLength, const char *ext);
 
+    static uint64_t makeContentHash(uint32_t crc, int size);
     static int getAudioFileOffset(bool isRaw);
     static bool isRawExtension(const char *ext);
     static bool is11KhzSample(const char *name);
@@ -45,7 +61,15 @@ private:
     bool m_is11Khz = false;
     Mix_Chunk *m_chunk = nullptr;
     unsigned m_hash = 0;
+    uint64_t m_contentHash = 0;
     int m_chanceModifier = 1;
 
+    // zipped samples are decompressed on demand, and can be unloaded since they're always reloadable
+    ZipArchive *m_archive = nullptr;
+    int m_entryIndex = -1;
+    uint64_t m_lastUsed = 0;
+
+    // chunks get requested from the predecoder thread as well
+    static std::atomic<uint64_t> m_useCounter;
     static const std::array<const char *, 5> kSupportedAudioExtensions;
 };
@@ -1,10 +1,15 @@
 #include "audio.h"
+#include "audioBuses.h"
+#include "audioStats.h"
 #include "wavFormat.h"
 #include "sfx.h"
 #include "comments.h"
 #include "chants.h"
 #include "music.h"
 #include "util.h"
+#include "timer.h"
+
+#include <future>
 
 constexpr int kDefaultVolume = 64;
 
@@ -18,20 +23,26 @@ static bool m_commentaryEnabled = true;
 static int m_actualFrequency;
 static int m_actualChannels;
 
+static std::future<void> m_predecoder;
+static std::atomic<bool> m_stopPredecoding;
+
+static std::vector<int> m_chunkSizeSweep;
+
 static void verifySpec(int frequency, int format, int channels);
-static void resetMenuAudio();
+static void openAudioDevice();
 static void channelFinished(int channel);
 static void setMasterVolume(int volume, bool apply);
 static void setMusicVolume(int volume, bool apply);
 
 void initAudio()
 {
-    if (m_soundEnabled)
-        resetMenuAudio();
+    if (m_soundEnabled && !Mix_QuerySpec(nullptr, nullptr, nullptr))
+        openAudioDevice();
 }
 
 void finishAudio()
 {
+    stopSamplePredecoding();
     finishMusic();
     Mix_CloseAudio();
 }
@@ -51,8 +62,11 @@ void initGameAudio()
     if (!m_soundEnabled)
         return;
 
+    stopSamplePredecoding();
     waitForMusicToFadeOut();
-    resetGameAudio();
+    Mix_Volume(-1, m_volume);
+    resetAudioBuses();
+    resetAudioStats();
 
     Mix_ChannelFinished(channelFinished);
 
@@ -61,22 +75,109 @@ void initGameAudio()
     initChantsBeforeTheGame();
 }
 
-void resetGameAudio()
+// Decodes sound effects and commentary into chunks on a worker thread while the pre-match menus are showing,
+// so the first playback of each sample doesn't stall the game. Samples not done by kick-off get decoded lazily.
+void startSamplePredecoding()
 {
-    Mix_CloseAudio();
+    if (!m_soundEnabled || m_predecoder.valid())
+        return;
 
-    if (Mix_OpenAudio(kGameFrequency, MIX_DEFAULT_FORMAT, 1, kGameChunkSize))
-        sdlErrorExit("SDL Mixer failed to initialize for the game");
+    m_stopPredecoding = false;
 
-    Mix_Volume(-1, m_volume);
-    verifySpec(kGameFrequency, MIX_DEFAULT_FORMAT, 1);
+    m_predecoder = std::async(std::launch::async, []() {
+        auto startTime = SDL_GetPerformanceCounter();
+
+        int numDecoded = predecodeSoundEffects(m_stopPredecoding);
+        numDecoded += predecodeCommentary(m_stopPredecoding);
+
+        auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+        logInfo("Pre-decoded %d samples in %.2f ms%s", numDecoded, elapsed * 1'000,
+            m_stopPredecoding ? " (interrupted)" : "");
+    });
+}
+
+// Must be called before sample tables are modified or played from, waits for at most one sample to finish decoding.
+void stopSamplePredecoding()
+{
+    if (m_predecoder.valid()) {
+        m_stopPredecoding = true;
+        m_predecoder.get();
+    }
+}
+
+// Parses a comma separated list of chunk sizes to try out in the audio chunk size sweep.
+bool setAudioChunkSizeSweep(const char *chunkSizes)
+{
+    m_chunkSizeSweep.clear();
+
+    for (auto p = chunkSizes; *p; ) {
+        char *end;
+        auto chunkSize = strtol(p, &end, 10);
+
+        if (end == p || chunkSize <= 0 || chunkSize > 65'536 || (*end && *end != ',')) {
+            m_chunkSizeSweep.clear();
+            return false;
+        }
+
+        m_chunkSizeSweep.push_back(chunkSize);
+        p = *end ? end + 1 : end;
+    }
+
+    return !m_chunkSizeSweep.empty();
+}
+
+bool audioChunkSizeSweepRequested()
+{
+    return !m_chunkSizeSweep.empty();
 }
 
-void ensureMenuAudioFrequency()
+// Batch mode: reopens the audio device with each requested chunk size, and plays crowd noise and a steady stream of
+// sound effects for a while, paced like the game loop. Audio stats are logged for each chunk size.
+bool runAudioChunkSizeSweep()
 {
-    int frequency;
-    if (Mix_QuerySpec(&frequency, nullptr, nullptr) && frequency != kMenuFrequency)
-        resetMenuAudio();
+    assert(audioChunkSizeSweepRequested());
+
+    constexpr Uint32 kSweepStepLength = 5'000;
+    constexpr int kFramesBetweenSfx = 7;
+    constexpr int kFrameLength = 1'000 / kTargetFpsPC;
+
+    static const SfxSampleIndex kSweepSfx[] = { kKick, kBounce, kKick, kWhistle, kKick, kBounce, kFoulWhistle };
+
+    m_soundEnabled = true;
+    loadSoundEffects();
+
+    for (auto chunkSize : m_chunkSizeSweep) {
+        logInfo("Audio chunk size sweep: trying %d", chunkSize);
+
+        if (Mix_QuerySpec(nullptr, nullptr, nullptr))
+            Mix_CloseAudio();
+
+        if (Mix_OpenAudio(kAudioFrequency, MIX_DEFAULT_FORMAT, kAudioChannels, chunkSize)) {
+            logWarn("Failed to open audio device with chunk size %d: %s", chunkSize, Mix_GetError());
+            return false;
+        }
+
+        verifySpec(kAudioFrequency, MIX_DEFAULT_FORMAT, kAudioChannels);
+        initAudioStats(m_actualFrequency, chunkSize);
+        Mix_Volume(-1, m_volume);
+
+        playCrowdNoise();
+
+        auto startTime = SDL_GetTicks();
+        for (int frame = 0; SDL_GetTicks() - startTime < kSweepStepLength; frame++) {
+            if (frame % kFramesBetweenSfx == 0)
+                playSfx(kSweepSfx[frame / kFramesBetweenSfx % std::size(kSweepSfx)], MIX_MAX_VOLUME);
+
+            SDL_Delay(kFrameLength);
+        }
+
+        stopBackgroudCrowdNoise();
+        Mix_HaltChannel(-1);
+
+        logAudioStats(("chunk size " + std::to_string(chunkSize)).c_str());
+    }
+
+    return true;
 }
 
 bool soundEnabled()
@@ -172,16 +273,19 @@ static void verifySpec(int frequency, int format, int channels)
     if (m_actualFrequency != frequency || actualFormat != format || m_actualChannels < channels)
         logWarn("Didn't get the desired audio specification, asked for frequency: %d, format: %d, channels: %d",
             frequency, format, channels);
+
+    initAudioBuses(m_actualFrequency, actualFormat, m_actualChannels);
 }
 
-static void resetMenuAudio()
+// Same spec is used for the menus and the game, so switching between them never touches the device,
+// and chunks (converted to the device format when loaded) stay valid for the whole session.
+static void openAudioDevice()
 {
-    Mix_CloseAudio();
-
-    if (Mix_OpenAudio(kMenuFrequency, MIX_DEFAULT_FORMAT, 2, kMenuChunkSize))
-        sdlErrorExit("SDL Mixer failed to initialize for the menus");
+    if (Mix_OpenAudio(kAudioFrequency, MIX_DEFAULT_FORMAT, kAudioChannels, kAudioChunkSize))
+        sdlErrorExit("SDL Mixer failed to initialize");
 
-    verifySpec(kMenuFrequency, MIX_DEFAULT_FORMAT, 2);
+    verifySpec(kAudioFrequency, MIX_DEFAULT_FORMAT, kAudioChannels);
+    initAudioStats(m_actualFrequency, kAudioChunkSize);
 
     synchronizeMixVolume();
 }
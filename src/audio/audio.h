@@ -3,11 +3,10 @@
 constexpr int kMaxVolume = MIX_MAX_VOLUME;
 constexpr int kMinVolume = 0;
 
-constexpr int kMenuFrequency = 44'100;
-constexpr int kMenuChunkSize = 8'192;
-
-constexpr int kGameFrequency = 22'050;
-constexpr int kGameChunkSize = 4'096;
+// device is opened once with this spec for both menus and the game; samples get converted to it when loaded
+constexpr int kAudioFrequency = 44'100;
+constexpr int kAudioChannels = 2;
+constexpr int kAudioChunkSize = 8'192;
 
 constexpr char kAudioDir[] = "audio";
 
@@ -15,8 +14,12 @@ void initAudio();
 void finishAudio();
 void stopAudio();
 void initGameAudio();
-void resetGameAudio();
-void ensureMenuAudioFrequency();
+void startSamplePredecoding();
+void stopSamplePredecoding();
+
+bool setAudioChunkSizeSweep(const char *chunkSizes);
+bool audioChunkSizeSweepRequested();
+bool runAudioChunkSizeSweep();
 
 bool soundEnabled();
 void initSoundEnabled(bool enabled);
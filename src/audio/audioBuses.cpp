@@ -0,0 +1,195 @@
+#include "audioBuses.h"
+
+constexpr int kNumBuses = static_cast<int>(AudioBus::kNumBuses);
+constexpr int kKeepCurrentVolume = 0xff;
+constexpr int kMaxRampFrames = 0xff'ffff;
+
+// crowd gets pulled down while the commentator is talking
+constexpr int kCommentaryDuckVolume = MIX_MAX_VOLUME * 55 / 100;
+constexpr int kCommentaryDuckAttackMs = 80;
+constexpr int kCommentaryDuckReleaseMs = 450;
+
+// Envelope is posted as a single word so the audio thread always sees a consistent one:
+// bits 0-23 ramp length in frames, 24-31 target volume, 32-39 starting volume (or kKeepCurrentVolume),
+// 40-63 sequence number, so posting the same envelope again restarts it.
+struct Bus {
+    std::atomic<uint64_t> envelope{ 0 };
+
+    // owned by the audio thread
+    uint64_t currentEnvelope = 0;
+    unsigned latchedCallback = ~0u;
+    float gain = 1;
+    float targetGain = 1;
+    float step = 0;
+    int rampFramesLeft = 0;
+};
+
+static std::array<Bus, kNumBuses> m_buses;
+
+static int m_frequency;
+static int m_channels;
+static bool m_enabled;
+
+static unsigned m_mixCallbackCounter;   // audio thread only
+
+static void latchEnvelope(Bus& bus);
+static void applyBusEnvelope(int channel, void *stream, int len, void *udata);
+static void advanceEnvelopes(int channel, void *stream, int len, void *udata);
+static void postEnvelope(AudioBus bus, int fromVolume, int toVolume, int rampMs);
+
+// Called once the audio device is open, with the spec obtained.
+void initAudioBuses(int frequency, Uint16 format, int channels)
+{
+    m_frequency = frequency;
+    m_channels = channels;
+
+    // envelopes are applied directly to the device format
+    m_enabled = format == AUDIO_S16SYS && channels > 0;
+
+    if (!m_enabled) {
+        logWarn("Audio format %#x not supported by the bus mixer, bus volumes disabled", format);
+        return;
+    }
+
+    resetAudioBuses();
+
+    if (!Mix_RegisterEffect(MIX_CHANNEL_POST, advanceEnvelopes, nullptr, nullptr)) {
+        logWarn("Failed to register bus mixer post-mix effect: %s", Mix_GetError());
+        m_enabled = false;
+    }
+}
+
+// Sets all the buses to full volume immediately.
+void resetAudioBuses()
+{
+    for (int i = 0; i < kNumBuses; i++)
+        setBusVolume(static_cast<AudioBus>(i), MIX_MAX_VOLUME);
+}
+
+// Needs to be done each time a chunk starts playing, since SDL_mixer drops channel effects when it finishes.
+void routeChannelToBus(int channel, AudioBus bus)
+{
+    assert(bus >= AudioBus::kSfx && bus < AudioBus::kNumBuses);
+
+    if (m_enabled && channel >= 0)
+        Mix_RegisterEffect(channel, applyBusEnvelope, nullptr, &m_buses[static_cast<int>(bus)]);
+}
+
+// Called when a comment starts playing.
+void duckCrowdForCommentary()
+{
+    setBusVolume(AudioBus::kCrowd, kCommentaryDuckVolume, kCommentaryDuckAttackMs);
+}
+
+// Called when the comment is done, possibly from the audio thread (from the channel finished callback).
+void releaseCommentaryDuck()
+{
+    setBusVolume(AudioBus::kCrowd, MIX_MAX_VOLUME, kCommentaryDuckReleaseMs);
+}
+
+// Ramps bus volume from wherever it currently is to the given volume.
+void setBusVolume(AudioBus bus, int volume, int rampMs /* = 0 */)
+{
+    postEnvelope(bus, kKeepCurrentVolume, volume, rampMs);
+}
+
+void fadeBusVolume(AudioBus bus, int fromVolume, int toVolume, int rampMs)
+{
+    postEnvelope(bus, std::min(std::max(fromVolume, 0), MIX_MAX_VOLUME), toVolume, rampMs);
+}
+
+// Picks up the latest envelope posted by the game thread, at most once per mixing callback, so that all the
+// channels on the bus get the same gain.
+static void latchEnvelope(Bus& bus)
+{
+    if (bus.latchedCallback == m_mixCallbackCounter)
+        return;
+
+    bus.latchedCallback = m_mixCallbackCounter;
+
+    auto envelope = bus.envelope.load(std::memory_order_acquire);
+    if (envelope == bus.currentEnvelope)
+        return;
+
+    bus.currentEnvelope = envelope;
+
+    int rampFrames = envelope & kMaxRampFrames;
+    int toVolume = (envelope >> 24) & 0xff;
+    int fromVolume = (envelope >> 32) & 0xff;
+
+    if (fromVolume != kKeepCurrentVolume)
+        bus.gain = static_cast<float>(fromVolume) / MIX_MAX_VOLUME;
+
+    bus.targetGain = static_cast<float>(toVolume) / MIX_MAX_VOLUME;
+    bus.rampFramesLeft = rampFrames;
+
+    if (rampFrames)
+        bus.step = (bus.targetGain - bus.gain) / rampFrames;
+    else
+        bus.gain = bus.targetGain;
+}
+
+static void applyBusEnvelope(int, void *stream, int len, void *udata)
+{
+    auto& bus = *reinterpret_cast<Bus *>(udata);
+    latchEnvelope(bus);
+
+    if (!bus.rampFramesLeft && bus.gain == 1)
+        return;
+
+    auto samples = reinterpret_cast<int16_t *>(stream);
+    int numFrames = len / (sizeof(int16_t) * m_channels);
+    int rampFrames = std::min(bus.rampFramesLeft, numFrames);
+
+    // ramp part, gain changes with each frame
+    auto gain = bus.gain;
+    for (int i = 0; i < rampFrames; i++, gain += bus.step)
+        for (int j = 0; j < m_channels; j++, samples++)
+            *samples = static_cast<int16_t>(*samples * gain);
+
+    // steady part, kept to a plain loop over samples so the compiler can vectorize it
+    int numSamples = (numFrames - rampFrames) * m_channels;
+    auto targetGain = bus.targetGain;
+
+    for (int i = 0; i < numSamples; i++)
+        samples[i] = static_cast<int16_t>(samples[i] * targetGain);
+}
+
+// Post-mix effect, runs once per mixing callback after all the channels. Moves envelopes forward by the length
+// of the mixed buffer.
+static void advanceEnvelopes(int, void *, int len, void *)
+{
+    int numFrames = len / (sizeof(int16_t) * m_channels);
+
+    for (auto& bus : m_buses) {
+        latchEnvelope(bus);
+
+        if (bus.rampFramesLeft > numFrames) {
+            bus.gain += bus.step * numFrames;
+            bus.rampFramesLeft -= numFrames;
+        } else {
+            bus.gain = bus.targetGain;
+            bus.rampFramesLeft = 0;
+        }
+    }
+
+    m_mixCallbackCounter++;
+}
+
+static void postEnvelope(AudioBus bus, int fromVolume, int toVolume, int rampMs)
+{
+    assert(bus >= AudioBus::kSfx && bus < AudioBus::kNumBuses);
+
+    // envelopes can get posted from the audio thread too
+    static std::atomic<uint64_t> s_sequence;
+
+    toVolume = std::min(std::max(toVolume, 0), MIX_MAX_VOLUME);
+
+    auto rampFrames = static_cast<int64_t>(std::max(rampMs, 0)) * m_frequency / 1'000;
+    rampFrames = std::min<int64_t>(rampFrames, kMaxRampFrames);
+
+    auto envelope = ++s_sequence << 40 | static_cast<uint64_t>(fromVolume) << 32 |
+        static_cast<uint64_t>(toVolume) << 24 | rampFrames;
+
+    m_buses[static_cast<int>(bus)].envelope.store(envelope, std::memory_order_release);
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Channels are routed to buses, and each bus has its own gain envelope which is evaluated per sample frame on the
+// audio thread. Game thread only posts envelope targets, so fades stay smooth regardless of the frame rate.
+enum class AudioBus {
+    kSfx,
+    kCrowd,
+    kChants,
+    kCommentary,
+    kNumBuses,
+};
+
+void initAudioBuses(int frequency, Uint16 format, int channels);
+void resetAudioBuses();
+void routeChannelToBus(int channel, AudioBus bus);
+void setBusVolume(AudioBus bus, int volume, int rampMs = 0);
+void fadeBusVolume(AudioBus bus, int fromVolume, int toVolume, int rampMs);
+void duckCrowdForCommentary();
+void releaseCommentaryDuck();
@@ -0,0 +1,239 @@
+#include "audioStats.h"
+
+constexpr int kNumHistogramBuckets = 21;    // bucket i holds values below 2^(i + 1) microseconds
+constexpr int kMaxTrackedChannels = 64;
+
+// mixing callback arriving this much later than the buffer duration means the device has most likely run dry
+constexpr double kLateCallbackFactor = 1.5;
+
+// Lock-free, gets updated from the audio thread, sample predecoder and the game thread.
+class Histogram
+{
+public:
+    void reset() {
+        for (auto& bucket : m_buckets)
+            bucket = 0;
+
+        m_count = 0;
+        m_total = 0;
+        m_max = 0;
+    }
+
+    void add(Uint64 microseconds) {
+        int bucket = 0;
+        for (auto value = microseconds; value > 1 && bucket < kNumHistogramBuckets - 1; value >>= 1)
+            bucket++;
+
+        m_buckets[bucket]++;
+        m_count++;
+        m_total += microseconds;
+
+        auto max = m_max.load();
+        while (microseconds > max && !m_max.compare_exchange_weak(max, microseconds))
+            ;
+    }
+
+    unsigned count() const {
+        return m_count;
+    }
+
+    double averageMs() const {
+        return m_count ? m_total / 1'000.0 / m_count : 0;
+    }
+
+    double maxMs() const {
+        return m_max / 1'000.0;
+    }
+
+    // Returns upper bound of the bucket that contains the given percentile.
+    double percentileMs(int percentile) const {
+        auto count = m_count.load();
+        if (!count)
+            return 0;
+
+        // nearest rank, so that small samples don't end up in the lowest bucket
+        auto threshold = std::max<Uint64>((static_cast<Uint64>(count) * percentile + 99) / 100, 1);
+        Uint64 sum = 0;
+
+        for (int i = 0; i < kNumHistogramBuckets; i++) {
+            sum += m_buckets[i];
+            if (sum >= threshold)
+                return std::min(static_cast<double>(2ull << i) / 1'000, maxMs());
+        }
+
+        return maxMs();
+    }
+
+    // Returns non-empty buckets as "<upper bound ms>:count" pairs.
+    std::string formatBuckets() const {
+        std::string result;
+        char buf[32];
+
+        for (int i = 0; i < kNumHistogramBuckets; i++) {
+            if (auto count = m_buckets[i].load()) {
+                snprintf(buf, sizeof(buf), "%s<%g:%u", result.empty() ? "" : " ", (2ull << i) / 1'000.0, count);
+                result += buf;
+            }
+        }
+
+        return result;
+    }
+
+private:
+    std::array<std::atomic<unsigned>, kNumHistogramBuckets> m_buckets{};
+    std::atomic<unsigned> m_count{ 0 };
+    std::atomic<Uint64> m_total{ 0 };
+    std::atomic<Uint64> m_max{ 0 };
+};
+
+static Histogram m_callbackIntervals;
+static Histogram m_sfxLatencies;
+static Histogram m_decodeTimes;
+
+static std::atomic<unsigned> m_numLateCallbacks;
+static std::atomic<Uint64> m_lastCallbackTime;
+static std::atomic<unsigned> m_numChannelsMixedTotal;
+static std::atomic<int> m_maxChannelsMixed;
+
+static std::array<std::atomic<Uint64>, kMaxTrackedChannels> m_sfxRequestTimes;
+
+static int m_frequency;
+static int m_chunkSize;
+static bool m_enabled;
+
+static bool m_showAudioStats;
+
+static Uint64 toMicroseconds(Uint64 ticks);
+static void measureMixCallback(int channel, void *stream, int len, void *udata);
+static void probeSfxStart(int channel, void *stream, int len, void *udata);
+
+// Called each time the audio device is opened.
+void initAudioStats(int frequency, int chunkSize)
+{
+    m_frequency = frequency;
+    m_chunkSize = chunkSize;
+
+    resetAudioStats();
+
+    m_enabled = Mix_RegisterEffect(MIX_CHANNEL_POST, measureMixCallback, nullptr, nullptr) != 0;
+    if (!m_enabled)
+        logWarn("Failed to register audio stats post-mix effect: %s", Mix_GetError());
+}
+
+void resetAudioStats()
+{
+    m_callbackIntervals.reset();
+    m_sfxLatencies.reset();
+    m_decodeTimes.reset();
+
+    m_numLateCallbacks = 0;
+    m_lastCallbackTime = 0;
+    m_numChannelsMixedTotal = 0;
+    m_maxChannelsMixed = 0;
+
+    for (auto& requestTime : m_sfxRequestTimes)
+        requestTime = 0;
+}
+
+// Starts tracking latency of a sound effect requested at the given time, until it first gets mixed.
+// Needs to be called after the chunk starts playing, since SDL_mixer drops channel effects when it finishes.
+void markSfxPlayRequest(int channel, Uint64 requestTime)
+{
+    if (m_enabled && channel >= 0 && channel < kMaxTrackedChannels) {
+        m_sfxRequestTimes[channel] = requestTime;
+        Mix_RegisterEffect(channel, probeSfxStart, nullptr, nullptr);
+    }
+}
+
+void recordSampleDecodeTime(Uint64 startTime)
+{
+    m_decodeTimes.add(toMicroseconds(SDL_GetPerformanceCounter() - startTime));
+}
+
+std::vector<std::string> getAudioStatsSummary(bool detailed /* = false */)
+{
+    std::vector<std::string> lines;
+    char buf[128];
+
+    auto bufferMs = m_frequency ? m_chunkSize * 1'000.0 / m_frequency : 0;
+    snprintf(buf, sizeof(buf), "Chunk: %d (%.1f ms)", m_chunkSize, bufferMs);
+    lines.push_back(buf);
+
+    snprintf(buf, sizeof(buf), "Callback: avg %.1f max %.1f ms, late %u/%u", m_callbackIntervals.averageMs(),
+        m_callbackIntervals.maxMs(), m_numLateCallbacks.load(), m_callbackIntervals.count());
+    lines.push_back(buf);
+
+    auto numCallbacks = std::max(m_callbackIntervals.count(), 1u);
+    snprintf(buf, sizeof(buf), "Channels: avg %.1f max %d",
+        static_cast<double>(m_numChannelsMixedTotal) / numCallbacks, m_maxChannelsMixed.load());
+    lines.push_back(buf);
+
+    snprintf(buf, sizeof(buf), "Sfx start: avg %.1f p95 %.1f max %.1f ms", m_sfxLatencies.averageMs(),
+        m_sfxLatencies.percentileMs(95), m_sfxLatencies.maxMs());
+    lines.push_back(buf);
+
+    snprintf(buf, sizeof(buf), "Decode: avg %.2f max %.2f ms (%u)", m_decodeTimes.averageMs(),
+        m_decodeTimes.maxMs(), m_decodeTimes.count());
+    lines.push_back(buf);
+
+    if (detailed) {
+        lines.push_back("Callback interval histogram (ms): " + m_callbackIntervals.formatBuckets());
+        lines.push_back("Sfx start latency histogram (ms): " + m_sfxLatencies.formatBuckets());
+        lines.push_back("Decode time histogram (ms): " + m_decodeTimes.formatBuckets());
+    }
+
+    return lines;
+}
+
+void logAudioStats(const char *title)
+{
+    logInfo("Audio stats (%s), sfx start latency excludes the device buffer:", title);
+
+    for (const auto& line : getAudioStatsSummary(true))
+        logInfo("    %s", line.c_str());
+}
+
+bool getShowAudioStats()
+{
+    return m_showAudioStats;
+}
+
+void setShowAudioStats(bool showAudioStats)
+{
+    m_showAudioStats = showAudioStats;
+}
+
+static Uint64 toMicroseconds(Uint64 ticks)
+{
+    return ticks * 1'000'000 / SDL_GetPerformanceFrequency();
+}
+
+// Post-mix effect, runs once for each buffer handed to the device.
+static void measureMixCallback(int, void *, int, void *)
+{
+    auto now = SDL_GetPerformanceCounter();
+    auto lastCallbackTime = m_lastCallbackTime.exchange(now);
+
+    if (lastCallbackTime) {
+        auto interval = toMicroseconds(now - lastCallbackTime);
+        m_callbackIntervals.add(interval);
+
+        auto expectedInterval = m_frequency ? 1'000'000.0 * m_chunkSize / m_frequency : 0;
+        if (interval > expectedInterval * kLateCallbackFactor)
+            m_numLateCallbacks++;
+    }
+
+    int numChannels = Mix_Playing(-1);
+    m_numChannelsMixedTotal += numChannels;
+    if (numChannels > m_maxChannelsMixed)
+        m_maxChannelsMixed = numChannels;
+}
+
+// Channel effect, records the time from the play request until the channel is mixed for the first time.
+static void probeSfxStart(int channel, void *, int, void *)
+{
+    assert(channel >= 0 && channel < kMaxTrackedChannels);
+
+    if (auto requestTime = m_sfxRequestTimes[channel].exchange(0))
+        m_sfxLatencies.add(toMicroseconds(SDL_GetPerformanceCounter() - requestTime));
+}
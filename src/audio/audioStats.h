@@ -0,0 +1,15 @@
+#pragma once
+
+// Audio timing instrumentation: mixing callback intervals, late callbacks (likely underruns), number of channels
+// being mixed, latency from sfx play request until it gets mixed, and sample decode times.
+
+void initAudioStats(int frequency, int chunkSize);
+void resetAudioStats();
+void markSfxPlayRequest(int channel, Uint64 requestTime);
+void recordSampleDecodeTime(Uint64 startTime);
+
+std::vector<std::string> getAudioStatsSummary(bool detailed = false);
+void logAudioStats(const char *title);
+
+bool getShowAudioStats();
+void setShowAudioStats(bool showAudioStats);
@@ -1,12 +1,16 @@
 #include "chants.h"
 #include "audio.h"
+#include "audioBuses.h"
 #include "sfx.h"
 #include "game.h"
 #include "file.h"
 #include "util.h"
+#include "timer.h"
 #include "SoundSample.h"
 
 constexpr int kChantsVolume = 55;
+// chants started by the crowd chant logic are faded in and out with this as the full volume
+constexpr int kFadedChantsVolume = MIX_MAX_VOLUME / 2;
 
 static SoundSample m_introChantSample;
 static SoundSample m_resultSample;
@@ -14,6 +18,7 @@ static SoundSample m_resultSample;
 static int m_fadeInChantTimer;
 static int m_fadeOutChantTimer;
 static int m_nextChantTimer;
+static bool m_fadingOutChants;
 
 static bool m_crowdChantsEnabled = true;
 
@@ -32,7 +37,8 @@ static int m_chantsChannel = -1;
 
 static void playChant(SfxSampleIndex index);
 static void stopChants();
-static void setVolumeOrStopChants(int volume);
+static void fadeInChants();
+static void fadeOutChants(int numTicks);
 static int getChantSampleIndex();
 static void loadChantSample(int sampleIndex);
 static void fadeOutChantsIfGameTurnedBoring(bool wasInteresting);
@@ -104,6 +110,7 @@ void initChantsBeforeTheGame()
     m_fadeInChantTimer = 0;
     m_fadeOutChantTimer = 0;
     m_nextChantTimer = 0;
+    m_fadingOutChants = false;
 
     m_playCrowdChantsFunction = nullptr;
 }
@@ -124,17 +131,16 @@ void playCrowdChants()
     if (!soundEnabled() || !m_crowdChantsEnabled || swos.g_trainingGame)
         return;
 
+    // volume itself is ramped by the chants bus envelope, timers only keep track of the phases
     if (m_fadeInChantTimer) {
         m_fadeInChantTimer--;
-        int volume = (MIX_MAX_VOLUME - m_fadeInChantTimer) / 2;
-        if (volume)
-            setVolumeOrStopChants(volume);
     } else if (m_nextChantTimer) {
         m_nextChantTimer--;
     } else if (m_fadeOutChantTimer) {
-        m_fadeOutChantTimer--;
-        int volume = m_fadeOutChantTimer / 2;
-        setVolumeOrStopChants(volume);
+        if (!m_fadingOutChants)
+            fadeOutChants(m_fadeOutChantTimer);
+        if (!--m_fadeOutChantTimer)
+            stopChants();
     } else if (getRandomInRange(0, 255) >= 128) {
         int pause = getRandomInRange(0, 255) * 2;
         m_nextChantTimer = pause;
@@ -155,6 +161,7 @@ void playCrowdChants()
 
         m_fadeInChantTimer = MIX_MAX_VOLUME;
         m_fadeOutChantTimer = MIX_MAX_VOLUME;
+        fadeInChants();
 
         m_nextChantTimer = getRandomInRange(0, 255) * 2 + 500;  // next chant: after 500-1012 ticks
     }
@@ -183,6 +190,7 @@ void setCrowdChantsEnabled(bool crowdChantsEnabled)
             m_fadeInChantTimer = 0;
             m_fadeOutChantTimer = 0;
             m_nextChantTimer = 0;
+            m_fadingOutChants = false;
 
             if (isMatchRunning())
                 playCrowdNoise();
@@ -215,6 +223,10 @@ static void playChant(Mix_Chunk *chunk)
         Mix_VolumeChunk(chunk, kChantsVolume);
         m_chantsChannel = Mix_PlayChannel(-1, chunk, -1);
         m_chantsSample = chunk;
+
+        m_fadingOutChants = false;
+        setBusVolume(AudioBus::kChants, MIX_MAX_VOLUME);
+        routeChannelToBus(m_chantsChannel, AudioBus::kChants);
     }
 }
 
@@ -268,19 +280,29 @@ static void stopChants()
     }
 }
 
-static void setVolumeOrStopChants(int volume)
+static int ticksToMs(int numTicks)
 {
-    if (m_chantsChannel != -1) {
-        volume &= 0xff;
-        if (volume) {
-            assert(m_chantsSample);
-            Mix_VolumeChunk(m_chantsSample, volume);
-        } else {
-            stopChants();
-        }
+    return numTicks * 1'000 / std::max(targetFps(), 1);
+}
+
+// Posts the whole fade to the chants bus at once, it gets ramped smoothly on the audio thread.
+static void fadeInChants()
+{
+    if (m_chantsChannel >= 0) {
+        assert(m_chantsSample);
+        Mix_VolumeChunk(m_chantsSample, kFadedChantsVolume);
+        fadeBusVolume(AudioBus::kChants, 0, MIX_MAX_VOLUME, ticksToMs(m_fadeInChantTimer));
     }
 }
 
+static void fadeOutChants(int numTicks)
+{
+    if (m_chantsChannel >= 0)
+        setBusVolume(AudioBus::kChants, 0, ticksToMs(numTicks));
+
+    m_fadingOutChants = true;
+}
+
 static int getChantSampleIndex()
 {
     int sampleIndex = -1;
@@ -345,6 +367,7 @@ static void fadeOutChantsIfGameTurnedBoring(bool wasInteresting)
     if (wasInteresting && !m_interestingGame && m_chantsChannel >= 0 && Mix_Playing(m_chantsChannel)) {
         m_fadeOutChantTimer = m_fadeInChantTimer ? m_fadeInChantTimer : MIX_MAX_VOLUME;
         m_fadeInChantTimer = 0;
+        fadeOutChants(m_fadeOutChantTimer);
     }
 }
 
@@ -1,5 +1,6 @@
 #include "comments.h"
 #include "audio.h"
+#include "audioBuses.h"
 #include "chants.h"
 #include "comments.h"
 #include "file.h"
@@ -11,6 +12,11 @@
 constexpr int kEnqueuedSampleDelay = 70;
 constexpr int kEnqueuedLongerSampleDelay = 100;
 
+// how much memory decompressed zipped comments are allowed to take at any one time
+constexpr size_t kZippedCommentaryMemoryBudget = 24 * 1024 * 1024;
+
+static ZipArchive m_commentaryZip;
+static size_t m_zippedCommentaryBudget = kZippedCommentaryMemoryBudget;
 
 static SoundSample m_endGameCrowdSample;
 
@@ -34,6 +40,8 @@ static int m_playingRedCardTimer = -1;
 
 static void loadZipComments();
 static bool sampleTablesEmpty();
+static size_t getResidentZippedComments(std::vector<SoundSample *>& samples);
+static void trimZippedComments(const Mix_Chunk *keepChunk);
 static void playGoodPassComment();
 static void playYellowCardSample();
 static void playRedCardSample();
@@ -100,13 +108,42 @@ void loadCommentary()
     logInfo("Loading commentary...");
 
     if (sampleTablesEmpty() || !m_commentaryLoaded) {
+        auto startTime = SDL_GetPerformanceCounter();
+
         loadCustomCommentary();
         m_commentaryLoaded = true;
+
+        auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+        logInfo("Commentary loaded in %.2f ms", elapsed * 1'000);
     }
 
     m_muteCommentary = !commentaryEnabled();
 }
 
+// Decodes comments ahead of time, starting with categories heard most often during the game, since zipped comments
+// only get prefetched while they fit into the memory budget. The rest are decompressed on demand.
+int predecodeCommentary(const std::atomic<bool>& stop)
+{
+    static const std::array<CommentarySampleTableIndex, 10> kLikelyCategories = {{
+        kFoul, kGoodPass, kGoodTackle, kThrowIn, kCorner, kNearMiss, kKeeperSaved, kKeeperClaimed, kHeader, kGoal,
+    }};
+
+    std::vector<SoundSample *> residentSamples;
+    auto residentSize = getResidentZippedComments(residentSamples);
+    auto budget = m_zippedCommentaryBudget - std::min(m_zippedCommentaryBudget, residentSize);
+
+    int numDecoded = 0;
+
+    for (auto index : kLikelyCategories)
+        numDecoded += m_sampleTables[index].predecodeSamples(stop, budget);
+
+    // already decoded samples get skipped
+    for (auto& table : m_sampleTables)
+        numDecoded += table.predecodeSamples(stop, budget);
+
+    return numDecoded;
+}
+
 void playEndGameCrowdSampleAndComment()
 {
     if (!soundEnabled() || !commentaryEnabled())
@@ -214,6 +251,7 @@ bool commenteryOnChannelFinished(int channel)
     if (channel == m_commentaryChannel) {
         logDebug("Commentary finished playing on channel %d", channel);
         m_commentaryChannel = -1;
+        releaseCommentaryDuck();
         return true;
     }
 
@@ -271,33 +309,40 @@ static void loadZipComments()
     assert(m_sampleTables.size() == 26);
     assert(m_sampleTables[18].dirHash() % kModValue == 5 && m_sampleTables[17].dirHash() % kModValue == 96);
 
-    SampleTable *table{};
-    auto filterCustomComments = [&](const char *path, int pathLength) {
+    auto findTable = [](const char *path, int pathLength) -> SampleTable * {
         auto hash = initialHash();
         for (int i = 0; i < pathLength && path[i] && path[i] != '/' && path[i] != '\\'; i++)
             hash = updateHash(hash, path[i], i);
         int index = kHashToIndex[hash % kModValue] - 1;
         if (index >= 0) {
-            table = &m_sampleTables[index];
+            auto table = &m_sampleTables[index];
             if (table->dirHash() == hash && !_strnicmp(table->dir(), path, table->dirLen()))
-                return SoundSample::additionalHeaderSize(path);
+                return table;
         }
-        return -1;
-    };
-
-    auto processCommentData = [&](const char *path, int pathLength, char *buffer, int bufferLength) {
-        assert(table);
-        table->addSample(path, pathLength, buffer, bufferLength);
+        return nullptr;
     };
 
     const auto& relativePath = joinPaths("audio", "commentary.zip");
     const auto& zipPath = pathInRootDir(relativePath.c_str());
 
-    logInfo("Loading zipped commentaries...");
-    if (traverseZipFile(zipPath.c_str(), filterCustomComments, processCommentData))
-        logInfo("Zipped commentaries loaded successfully");
-    else
+    logInfo("Indexing zipped commentaries...");
+
+    // samples only keep the index of their entry, and get decompressed when needed
+    if (!m_commentaryZip.open(zipPath.c_str())) {
         logWarn("Couldn't open commentary zip file");
+        return;
+    }
+
+    const auto& entries = m_commentaryZip.entries();
+
+    for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+        const auto& path = entries[i].name;
+        auto pathLength = static_cast<int>(path.size());
+        if (auto table = findTable(path.c_str(), pathLength))
+            table->addSample(path.c_str(), pathLength, m_commentaryZip, i);
+    }
+
+    logInfo("Zipped commentaries indexed successfully");
 }
 
 static bool sampleTablesEmpty()
@@ -307,6 +352,49 @@ static bool sampleTablesEmpty()
     });
 }
 
+// Fills the list with zipped comments currently taking up memory, and returns how much memory they take in total.
+static size_t getResidentZippedComments(std::vector<SoundSample *>& samples)
+{
+    for (auto& table : m_sampleTables)
+        table.getResidentZippedSamples(samples);
+
+    size_t residentSize = 0;
+    for (const auto sample : samples)
+        residentSize += sample->residentSize();
+
+    return residentSize;
+}
+
+// Unloads least recently used zipped comments until they fit into the memory budget. The given chunk and the last
+// played comment are spared since they might still be playing.
+static void trimZippedComments(const Mix_Chunk *keepChunk)
+{
+    std::vector<SoundSample *> samples;
+    auto residentSize = getResidentZippedComments(samples);
+
+    if (residentSize <= m_zippedCommentaryBudget)
+        return;
+
+    std::sort(samples.begin(), samples.end(), [](const auto sample1, const auto sample2) {
+        return sample1->lastUsed() < sample2->lastUsed();
+    });
+
+    int numUnloaded = 0;
+
+    for (auto sample : samples) {
+        if (residentSize <= m_zippedCommentaryBudget)
+            break;
+
+        if (!sample->ownsChunk(keepChunk) && !sample->ownsChunk(m_lastPlayedComment)) {
+            residentSize -= sample->residentSize();
+            sample->unload();
+            numUnloaded++;
+        }
+    }
+
+    logDebug("Unloaded %d zipped comments, %d KB still resident", numUnloaded, static_cast<int>(residentSize / 1024));
+}
+
 static bool commentPlaying()
 {
     return m_commentaryChannel >= 0 && Mix_Playing(m_commentaryChannel);
@@ -328,6 +416,10 @@ static void playComment(Mix_Chunk *chunk, bool interrupt = true)
 
     Mix_VolumeChunk(chunk, MIX_MAX_VOLUME);
     m_commentaryChannel = Mix_PlayChannel(-1, chunk, 0);
+    routeChannelToBus(m_commentaryChannel, AudioBus::kCommentary);
+
+    if (m_commentaryChannel >= 0)
+        duckCrowdForCommentary();
 
     m_lastPlayedComment = chunk;
     m_lastPlayedCommentHash = hash(chunk->abuf, chunk->alen);
@@ -344,6 +436,7 @@ static void playComment(CommentarySampleTableIndex tableIndex, bool interrupt /*
         if (auto chunk = table.getRandomSample(m_lastPlayedComment, m_lastPlayedCommentHash)) {
             playComment(chunk, interrupt);
             m_lastPlayedCategory = tableIndex;
+            trimZippedComments(chunk);
         }
     } else {
         logWarn("Comment table %d empty", tableIndex);
@@ -516,7 +609,7 @@ static void loadAndPlayEndGameCrowdSample(int index)
     auto chunk = m_endGameCrowdSample.chunk();
     if (chunk) {
         Mix_VolumeChunk(chunk, MIX_MAX_VOLUME);
-        Mix_PlayChannel(-1, chunk, 0);
+        routeChannelToBus(Mix_PlayChannel(-1, chunk, 0), AudioBus::kCrowd);
     } else {
         logWarn("Failed to load end game sample %s", path.c_str());
     }
@@ -559,4 +652,15 @@ void setEnqueueTimers(const std::vector<int>& values)
     m_substituteSampleTimer = values[5];
     m_tacticsChangedSampleTimer = values[6];
 }
+
+void setZippedCommentaryMemoryBudget(size_t budget)
+{
+    m_zippedCommentaryBudget = budget;
+}
+
+size_t zippedCommentaryResidentSize()
+{
+    std::vector<SoundSample *> samples;
+    return getResidentZippedComments(samples);
+}
 #endif
@@ -1,6 +1,7 @@
 #pragma once
 
 void loadCommentary();
+int predecodeCommentary(const std::atomic<bool>& stop);
 void playEndGameCrowdSampleAndComment();
 void initCommentsBeforeTheGame();
 void enqueueThrowInSample();
@@ -19,4 +20,6 @@ void clearPenaltyFlag();
 #ifdef SWOS_TEST
 void clearCommentsSampleCache();
 void setEnqueueTimers(const std::vector<int>& values);
+void setZippedCommentaryMemoryBudget(size_t budget);
+size_t zippedCommentaryResidentSize();
 #endif
@@ -4,6 +4,7 @@
 #include "log.h"
 #include "util.h"
 #include "options.h"
+#include <future>
 
 enum class State {
     kStart,
@@ -14,16 +15,44 @@ enum class State {
     kPlaybackError,
 } static m_state = State::kStart;
 
-static Mix_Music *m_titleMusic;
-static Mix_Music *m_menuMusic;
+struct SongFile {
+    std::unique_ptr<char[]> data;
+    int size;
+    Mix_MusicType type;
+    std::string filename;
+};
+
+// Song files are read on a background thread, and start playing from updateSongState() once they're ready.
+// SDL_mixer music functions aren't thread safe, so the music itself is only ever touched from the main thread.
+struct Song {
+    const char *basename;
+    bool loop;
+    void (*onFinished)();
+    Mix_Music *music;
+    std::string filename;
+    // music gets streamed from the file data, so it has to stay around for as long as the music does
+    std::unique_ptr<char[]> data;
+    std::future<SongFile> loader;
+    bool missing;
+};
 
 static bool m_titleSongDone;
 
+static Song m_titleSong = { "title", false, [] { m_titleSongDone = true; } };
+static Song m_menuSong = { "menu", true };
+static Song *m_pendingSong;
+
 constexpr int kFadeOutMenuMusicLength = 1'800;
+// OGG does a short pop when music starts playing, ramping up the volume hides it
+constexpr int kFadeInMusicLength = 200;
 
 static bool noMusic();
 static void playMenuSong();
-static bool playTitleSong();
+static void playTitleSong();
+static void startLoadingSong(Song& song);
+static bool songLoaded(Song& song);
+static void playSong(Song& song);
+static void freeSong(Song& song);
 
 void initMusic()
 {
@@ -32,10 +61,15 @@ void initMusic()
 
     static bool s_playedAtStart;
 
-    ensureMenuAudioFrequency();
+    if (!s_playedAtStart) {
+        // get the menu song ready while the title song is playing
+        startLoadingSong(m_menuSong);
 
-    if (!s_playedAtStart && (m_titleSongDone || !playTitleSong()))
-        playMenuSong();
+        if (m_titleSongDone)
+            playMenuSong();
+        else
+            playTitleSong();
+    }
 
     s_playedAtStart = true;
 }
@@ -44,8 +78,8 @@ void finishMusic()
 {
     logInfo("Ending music");
 
-    Mix_FreeMusic(m_menuMusic);
-    m_menuMusic = nullptr;
+    m_pendingSong = nullptr;
+    freeSong(m_menuSong);
 }
 
 // Initiates music fade and returns immediately.
@@ -67,6 +101,9 @@ void waitForMusicToFadeOut()
 
     logInfo("Waiting for music to fade out...");
 
+    // don't let a song that's still loading start in the middle of the match
+    m_pendingSong = nullptr;
+
     if (Mix_FadingMusic() == MIX_FADING_OUT) {
         while (Mix_PlayingMusic())
             SDL_Delay(20);
@@ -113,6 +150,12 @@ void updateSongState()
     if (noMusic())
         return;
 
+    if (m_pendingSong && songLoaded(*m_pendingSong)) {
+        auto song = m_pendingSong;
+        m_pendingSong = nullptr;
+        playSong(*song);
+    }
+
     if (m_state == State::kTitleSongFadeOut) {
         m_titleSongDone = !Mix_PlayingMusic();
         if (m_titleSongDone) {
@@ -130,6 +173,10 @@ void stopTitleSong()
     constexpr int kTitleSongFadeOutInterval = 1'200;
 
     if (m_state == State::kPlayingTitleSong) {
+        // title song might still be loading, make sure it doesn't start after all
+        if (m_pendingSong == &m_titleSong)
+            m_pendingSong = nullptr;
+
         Mix_FadeOutMusic(kTitleSongFadeOutInterval);
         m_state = State::kTitleSongFadeOut;
     }
@@ -144,8 +191,7 @@ void startMenuSong()
     initMusic();
 
     if (m_state != State::kPlaybackError && m_titleSongDone) {
-        Mix_FreeMusic(m_titleMusic);
-        m_titleMusic = nullptr;
+        freeSong(m_titleSong);
 
         Mix_HookMusicFinished(nullptr);
 
@@ -169,82 +215,137 @@ static bool noMusic()
     return !soundEnabled() || !musicEnabled();
 }
 
-static std::pair<Mix_Music *, std::string> loadMixMusicFile(const char *name)
+// Runs on a loader thread, so it only reads the file into memory. Extensions are probed quietly, a song that's
+// missing with all of them gets reported once, when it's about to be played.
+static SongFile loadSongFile(const char *name)
 {
+    static const std::array<std::pair<const char *, Mix_MusicType>, 5> kMusicTypes = {{
+        { "mp3", MUS_MP3 }, { "ogg", MUS_OGG }, { "wav", MUS_WAV }, { "flac", MUS_FLAC }, { "mid", MUS_MID },
+    }};
+
     std::string nameStr(name);
     nameStr += '.';
 
-    for (const auto ext : { "mp3", "ogg", "wav", "flac", "mid", }) {
-        auto filename = nameStr + ext;
-        auto path = rootDir() + filename;
+    for (const auto& type : kMusicTypes) {
+        auto filename = nameStr + type.first;
+
+        if (getFileSizeAndModificationTime(filename.c_str()).first < 0)
+            continue;
 
-        auto music = Mix_LoadMUS(path.c_str());
-        if (music)
-            return { music, filename };
+        auto data = loadFile(filename.c_str());
+        if (data.first)
+            return { std::unique_ptr<char[]>(data.first), data.second, type.second, filename };
     }
 
     return {};
 }
 
-static Mix_Music *playMixSong(const char *basename, bool loop, Mix_Music *musicChunk = nullptr, void (onFinished)() = nullptr)
+// Resolves and reads the song file in the background, unless it's already loaded (or known to be missing).
+static void startLoadingSong(Song& song)
 {
-    static std::string filename;
+    if (!song.music && !song.missing && !song.loader.valid())
+        song.loader = std::async(std::launch::async, loadSongFile, song.basename);
+}
 
-    if (!musicChunk)
-        std::tie(musicChunk, filename) = loadMixMusicFile(basename);
+// Opens the music from the song file data that was read in the background. Must run on the main thread.
+static void openSongFile(Song& song, SongFile& file)
+{
+    if (!file.data)
+        return;
 
-    if (musicChunk) {
-        // OGG does a short pop when music starts playing again
-        auto musicType = Mix_GetMusicType(musicChunk);
-        bool isOgg = musicType == MUS_OGG;
+    if (auto rwOps = SDL_RWFromConstMem(file.data.get(), file.size))
+        song.music = Mix_LoadMUSType_RW(rwOps, file.type, 1);
 
-        if (isOgg)
-            Mix_VolumeMusic(0);
+    if (song.music) {
+        song.data = std::move(file.data);
+        song.filename = std::move(file.filename);
+    } else {
+        logWarn("Failed to open music file \"%s\": %s", file.filename.c_str(), Mix_GetError());
+    }
+}
 
-        logInfo("Playing %s music \"%s\"", basename, filename.c_str());
-        Mix_PlayMusic(musicChunk, loop ? -1 : 0);
+// Returns true if the song is done loading (successfully or not), without blocking.
+static bool songLoaded(Song& song)
+{
+    if (song.loader.valid()) {
+        if (song.loader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
 
-        if (!isOgg)
-            Mix_VolumeMusic(getMusicVolume());
+        auto file = song.loader.get();
+        openSongFile(song, file);
+        song.missing = !song.music;
+    }
 
-        synchronizeSystemVolume();
+    return true;
+}
 
-        Mix_HookMusicFinished(onFinished);
+static void freeSong(Song& song)
+{
+    if (m_pendingSong == &song)
+        m_pendingSong = nullptr;
 
-        if (isOgg) {
-            SDL_Delay(200);
-            Mix_VolumeMusic(getMusicVolume());
-        }
-    }
+    if (song.loader.valid())
+        song.loader.wait();
+
+    songLoaded(song);
 
-    return musicChunk;
+    Mix_FreeMusic(song.music);
+    song.music = nullptr;
+    song.data.reset();
+    song.missing = false;
 }
 
-static void playMenuSong()
+static void handleMissingSong(const Song& song)
 {
-    m_menuMusic = playMixSong("menu", true, m_menuMusic);
+    logInfo("Couldn't find a suitable %s music file", song.basename);
 
-    if (!m_menuMusic) {
-        logInfo("Couldn't find a suitable menu music file");
+    if (&song == &m_titleSong) {
+        m_titleSongDone = true;
+        m_state = State::kPlayingMenuSong;
+        playMenuSong();
+    } else {
         m_state = State::kPlaybackError;
     }
 }
 
+static void playSong(Song& song)
+{
+    if (!songLoaded(song)) {
+        m_pendingSong = &song;
+        return;
+    }
+
+    if (!song.music) {
+        handleMissingSong(song);
+        return;
+    }
+
+    logInfo("Playing %s music \"%s\"", song.basename, song.filename.c_str());
+
+    Mix_VolumeMusic(getMusicVolume());
+    Mix_FadeInMusic(song.music, song.loop ? -1 : 0, kFadeInMusicLength);
+
+    synchronizeSystemVolume();
+
+    Mix_HookMusicFinished(song.onFinished);
+}
+
+static void playMenuSong()
+{
+    startLoadingSong(m_menuSong);
+    playSong(m_menuSong);
+}
+
 // called each time when coming back from the match
 void SWOS::TryMidiPlay()
 {
     playMenuSong();
 }
 
-static bool playTitleSong()
+static void playTitleSong()
 {
-    m_titleMusic = playMixSong("title", false, m_titleMusic, [] { m_titleSongDone = true; });
     m_state = State::kPlayingTitleSong;
 
-    if (m_titleMusic) {
-        return true;
-    } else {
-        logInfo("Couldn't find a suitable title music file");
-        return false;
-    }
+    startLoadingSong(m_titleSong);
+    playSong(m_titleSong);
 }
@@ -1,5 +1,7 @@
 #include "sfx.h"
 #include "audio.h"
+#include "audioBuses.h"
+#include "audioStats.h"
 #include "chants.h"
 #include "file.h"
 #include "replays.h"
@@ -30,6 +32,20 @@ void loadSoundEffects()
     assert(i == m_sfxSamples.size());
 }
 
+int predecodeSoundEffects(const std::atomic<bool>& stop)
+{
+    int numDecoded = 0;
+
+    for (auto& sample : m_sfxSamples) {
+        if (stop)
+            break;
+        if (!sample.isChunkLoaded() && sample.hasData() && sample.chunk())
+            numDecoded++;
+    }
+
+    return numDecoded;
+}
+
 void clearSfxSamplesCache()
 {
     for (auto& sample : m_sfxSamples)
@@ -62,10 +78,15 @@ static int playSfx(SfxSampleIndex index, int volume = MIX_MAX_VOLUME, int loopCo
     if (saveForHighlights)
         saveSfxForHighlights(index, volume);
 
+    auto requestTime = SDL_GetPerformanceCounter();
+
     auto chunk = m_sfxSamples[index].chunk();
     if (chunk) {
         Mix_VolumeChunk(chunk, volume);
-        return Mix_PlayChannel(-1, chunk, loopCount);
+        int channel = Mix_PlayChannel(-1, chunk, loopCount);
+        routeChannelToBus(channel, index == kBackgroundCrowd ? AudioBus::kCrowd : AudioBus::kSfx);
+        markSfxPlayRequest(channel, requestTime);
+        return channel;
     } else {
         logWarn("Failed to load sound effect %d", index);
         return -1;
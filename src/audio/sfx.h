@@ -11,6 +11,7 @@ enum SfxSampleIndex {
 using SfxSamplesArray = std::array<SoundSample, kNumSoundEffects>;
 
 void loadSoundEffects();
+int predecodeSoundEffects(const std::atomic<bool>& stop);
 void clearSfxSamplesCache();
 void initSfxBeforeTheGame();
 SfxSamplesArray& sfxSamples();
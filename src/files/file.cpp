@@ -9,7 +9,6 @@
 
 static std::string m_rootDir;
 
-static bool isAbsolutePath(const char *path);
 static void traverseDirectory(DIR *dir, const char *extension, std::function<bool(const char *, int, const char *)> f);
 static bool isAnyExtensionAllowed(const char *ext, const char **allowedExtensions, int numAllowedExtensions);
 
@@ -276,6 +275,28 @@ bool fileExists(const char *path)
     return stat(path, &statBuffer) == 0;
 }
 
+// Returns size and last modification time (in seconds) of a file relative to the root directory,
+// or a pair of -1's if the file can't be accessed.
+std::pair<int64_t, int64_t> getFileSizeAndModificationTime(const char *path)
+{
+    auto fullPath = isAbsolutePath(path) ? path : m_rootDir + path;
+#ifdef __ANDROID__
+    if (fullPath[0] != '/')
+        fullPath = std::string(SDL_AndroidGetInternalStoragePath()) + '/' + fullPath;
+#endif
+#ifndef _WIN32
+    std::transform(fullPath.begin(), fullPath.end(), fullPath.begin(), [](unsigned char c) {
+        return c == '\\' ? '/' : std::tolower(c);
+    });
+#endif
+
+    struct stat statBuffer;
+    if (stat(fullPath.c_str(), &statBuffer) != 0)
+        return { -1, -1 };
+
+    return { statBuffer.st_size, statBuffer.st_mtime };
+}
+
 bool dirExists(const char *path)
 {
 #ifdef _WIN32
@@ -370,7 +391,7 @@ void traverseDirectory(const char *directory, const char *extension,
         traverseDirectory(dir, extension, f);
 }
 
-static bool isAbsolutePath(const char *path)
+bool isAbsolutePath(const char *path)
 {
 #ifdef _WIN32
     return isalpha(path[0]) && path[1] == ':' && path[2] == getDirSeparator();
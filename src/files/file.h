@@ -12,6 +12,7 @@ bool renameFile(const char *oldPath, const char *newPath);
 void setRootDir(const char *dir);
 std::string rootDir();
 std::string pathInRootDir(const char *filename);
+bool isAbsolutePath(const char *path);
 
 #ifdef _WIN32
 # define DIR_SEPARATOR "\\"
@@ -42,6 +43,7 @@ int pathNCompare(const char *path1, const char *path2, int count);
 
 std::string joinPaths(const char *path1, const char *path2);
 bool fileExists(const char *path);
+std::pair<int64_t, int64_t> getFileSizeAndModificationTime(const char *path);
 bool dirExists(const char *path);
 bool createDir(const char *path);
 
@@ -51,6 +53,7 @@ const char *getBasename(const char *path);
 struct FoundFile {
     std::string name;
     int extensionOffset;
+    std::string description;    // optional, shown in the title of select files menu when the file is selected
     FoundFile(const std::string& name, int extensionOffset) : name(name), extensionOffset(extensionOffset) {}
 };
 using FoundFileList = std::vector<FoundFile>;
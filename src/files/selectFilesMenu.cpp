@@ -30,6 +30,7 @@ static std::string m_selectedFilename;
 static const char *m_saveExtension;
 static char *m_saveFilenameBuffer;
 static char *m_filenameBuffer;
+static char *m_summaryTitleBuffer;
 
 static const char *kReplays;
 
@@ -504,12 +505,13 @@ static void selectFilesOnInit()
     selectInitialEntry();
     sortFilenames();
 
-    selectFilesOnReturn();
-
     using namespace SwosVM;
 
     kReplays = allocateString("REPLAY");
     m_filenameBuffer = allocateMemory(kMaxPath);
+    m_summaryTitleBuffer = allocateMemory(kMenuStringLength);
+
+    selectFilesOnReturn();
 }
 
 static SwosDataPointer<const char> getFileTypeFromExtension(const char *ext)
@@ -566,6 +568,27 @@ static void drawDescription()
     }
 }
 
+// Shows the description of the currently selected file (if it has one) in place of the menu title.
+static void drawTitle()
+{
+    auto titleString = const_cast<char *>(m_menuTitle);
+
+    auto ordinal = getCurrentEntryOrdinal();
+    if (ordinal >= kFirstFileEntry && ordinal < kFirstFileEntry + kNumFilenameItems) {
+        auto fileIndex = m_entryToFilename[ordinal - kFirstFileEntry];
+        if (fileIndex >= 0 && fileIndex < static_cast<int>(m_filenames.size())) {
+            const auto& description = m_filenames[fileIndex].description;
+            if (!description.empty()) {
+                strncpy(m_summaryTitleBuffer, description.c_str(), kMenuStringLength - 1);
+                m_summaryTitleBuffer[kMenuStringLength - 1] = '\0';
+                titleString = m_summaryTitleBuffer;
+            }
+        }
+    }
+
+    getMenuEntry(title)->setString(titleString);
+}
+
 static void selectFile()
 {
     const auto entry = A5.as<MenuEntry *>();
@@ -3,6 +3,7 @@
 #include "windowManager.h"
 #include "render.h"
 #include "audio.h"
+#include "audioStats.h"
 #include "music.h"
 #include "chants.h"
 #include "comments.h"
@@ -58,6 +59,8 @@ static void startingMatch();
 // Initializes everything except the sprite graphics, which are needed for the stadium menu.
 void initMatch(TeamGame *topTeam, TeamGame *bottomTeam, bool saveOrRestoreTeams)
 {
+    stopSamplePredecoding();
+
     saveOrRestoreTeams ? saveTeams() : restoreTeams();
 
     initMatchSprites(topTeam, bottomTeam);
@@ -100,6 +103,7 @@ void initMatch(TeamGame *topTeam, TeamGame *bottomTeam, bool saveOrRestoreTeams)
 
     loadSoundEffects();
     loadIntroChant();
+    startSamplePredecoding();
 
     m_blockZoom = false;
     m_zoomFrames = 0;
@@ -202,6 +206,7 @@ void initializeIngameTeams(int minSubs, int maxSubs, TeamFile *team1, TeamFile *
 void matchEnded()
 {
     finishCurrentReplay();
+    logAudioStats("match");
 }
 
 void startMainGameLoop()
@@ -3,6 +3,9 @@
 #include "music.h"
 #include "options.h"
 #include "replays.h"
+#include "replayExport.h"
+#include "legacyReplayConversion.h"
+#include "replayDataExtractor.h"
 #include "sprites.h"
 #include "pitch.h"
 #include "controls.h"
@@ -72,6 +75,36 @@ void startMainMenuLoop()
 #endif
 }
 
+#ifndef SWOS_TEST
+// Batch mode: initializes the game without showing any menus and renders the requested replay offscreen.
+int startReplayExport()
+{
+    init();
+    return exportReplay() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Batch mode: converts a directory of replay files into columnar data files for offline analysis.
+int startReplayExtraction()
+{
+    init();
+    return extractReplayData() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Batch mode: converts legacy highlights files in a directory, caching the results next to them.
+int startLegacyReplayConversion()
+{
+    init();
+    return convertLegacyReplays() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Batch mode: plays sound effects with each requested audio chunk size and logs audio timing stats for each.
+int startAudioChunkSweep()
+{
+    init();
+    return runAudioChunkSizeSweep() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
+
 #ifdef DEBUG
 static void verifyBlock(const char *array, size_t size)
 {
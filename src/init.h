@@ -1,6 +1,10 @@
 #pragma once
 
 void startMainMenuLoop();
+int startReplayExport();
+int startReplayExtraction();
+int startLegacyReplayConversion();
+int startAudioChunkSweep();
 #ifdef DEBUG
 void checkMemory();
 #endif
@@ -8,6 +8,9 @@
 #include "file.h"
 #include "crash.h"
 #include "joypads.h"
+#include "replayExport.h"
+#include "replayDataExtractor.h"
+#include "legacyReplayConversion.h"
 
 static void turnOnDebugHeap()
 {
@@ -33,6 +36,8 @@ int main(int argc, char **argv)
 
     auto commandLineWarnings = parseCommandLine(argc, argv);
 
+    setupReplayExportLog();
+
     atexit(finishLog);          // dispose log last
     initLog();
 
@@ -64,6 +69,15 @@ int main(int argc, char **argv)
 
     SDL_StopTextInput();
 
+    if (replayExportRequested())
+        return startReplayExport();
+    if (replayExtractionRequested())
+        return startReplayExtraction();
+    if (legacyReplayConversionRequested())
+        return startLegacyReplayConversion();
+    if (audioChunkSizeSweepRequested())
+        return startAudioChunkSweep();
+
     startMainMenuLoop();
 
     return EXIT_SUCCESS;
@@ -4,6 +4,7 @@
 #include "keyboard.h"
 #include "joypads.h"
 #include "audio.h"
+#include "audioStats.h"
 #include "music.h"
 #include "chants.h"
 #include "windowManager.h"
@@ -13,6 +14,9 @@
 #include "pitch.h"
 #include "spinningLogo.h"
 #include "replays.h"
+#include "replayExport.h"
+#include "replayDataExtractor.h"
+#include "legacyReplayConversion.h"
 #include "render.h"
 #include "overlay.h"
 #include "OptionVariable.h"
@@ -51,6 +55,7 @@ static const char kGameplaySection[] = "gameplay";
 // video
 static const char kFlashMenuCursorKey[] = "flashMenuCursor";
 static const char kShowFpsKey[] = "showFps";
+static const char kShowAudioStatsKey[] = "showAudioStats";
 static const char kUseLinearFilteringKey[] = "useLinearFiltering";
 static const char kClearScreenKey[] = "clearScreen";
 static const char kSpinningLogoKey[] = "showSpinningLogo";
@@ -78,13 +83,14 @@ static const std::array<OptionVariable<int16_t>, 5> kStandardOptions = {
     "pitchType", &swos.g_pitchType, -2, 6, 4,
 };
 
-static const std::array<OptionAccessor<bool>, 13> kBoolOptions = {
+static const std::array<OptionAccessor<bool>, 14> kBoolOptions = {
     soundEnabled, initSoundEnabled, kAudioSection, kSoundEnabledKey, true,
     musicEnabled, initMusicEnabled, kAudioSection, kMusicEnabledKey, true,
     commentaryEnabled, setCommentaryEnabled, kAudioSection, kCommentaryEnabledKey, true,
     areCrowdChantsEnabled, initCrowdChantsEnabled, kAudioSection, kCrowdChantsEnabledKey, true,
     cursorFlashingEnabled, setFlashMenuCursor, kVideoSection, kFlashMenuCursorKey, true,
     getShowFps, setShowFps, kVideoSection, kShowFpsKey, false,
+    getShowAudioStats, setShowAudioStats, kVideoSection, kShowAudioStatsKey, false,
     getLinearFiltering, setLinearFiltering, kVideoSection, kUseLinearFilteringKey, true,
     getClearScreen, setClearScreen, kVideoSection, kClearScreenKey, true,
     spinningLogoEnabled, enableSpinningLogo, kVideoSection, kSpinningLogoKey, true,
@@ -318,6 +324,14 @@ std::vector<LogItem> parseCommandLine(int argc, char **argv)
     const char kPl2Controls[] = "--pl2controls=";
     const char kPl1Joypad[] = "--pl1joypad=";
     const char kPl2Joypad[] = "--pl2joypad=";
+    const char kExportReplay[] = "--export-replay=";
+    const char kExportFormat[] = "--export-format=";
+    const char kExportOutput[] = "--export-output=";
+    const char kExportSfx[] = "--export-sfx=";
+    const char kExtractReplays[] = "--extract-replays=";
+    const char kExtractOutput[] = "--extract-output=";
+    const char kConvertReplays[] = "--convert-legacy-replays=";
+    const char kAudioChunkSweep[] = "--audio-chunk-sweep=";
 
     auto log = [&commandLineWarnings](const std::string& str, LogCategory category = kWarning) {
         commandLineWarnings.emplace_back(category, str);
@@ -353,6 +367,26 @@ std::vector<LogItem> parseCommandLine(int argc, char **argv)
                 joypad.first = true;
                 joypad.second = joypadStr;
             }
+        } else if (strstr(argv[i], kExportReplay) == argv[i]) {
+            setReplayExportFile(argv[i] + sizeof(kExportReplay) - 1);
+        } else if (strstr(argv[i], kExportFormat) == argv[i]) {
+            auto format = argv[i] + sizeof(kExportFormat) - 1;
+            if (!setReplayExportFormat(format))
+                log("Unknown export format: "s + format + " (rgba or y4m accepted)");
+        } else if (strstr(argv[i], kExportOutput) == argv[i]) {
+            setReplayExportOutput(argv[i] + sizeof(kExportOutput) - 1);
+        } else if (strstr(argv[i], kExportSfx) == argv[i]) {
+            setReplayExportSfxOutput(argv[i] + sizeof(kExportSfx) - 1);
+        } else if (strstr(argv[i], kExtractReplays) == argv[i]) {
+            setReplayExtractionDir(argv[i] + sizeof(kExtractReplays) - 1);
+        } else if (strstr(argv[i], kExtractOutput) == argv[i]) {
+            setReplayExtractionOutputDir(argv[i] + sizeof(kExtractOutput) - 1);
+        } else if (strstr(argv[i], kConvertReplays) == argv[i]) {
+            setLegacyReplayConversionDir(argv[i] + sizeof(kConvertReplays) - 1);
+        } else if (strstr(argv[i], kAudioChunkSweep) == argv[i]) {
+            auto chunkSizes = argv[i] + sizeof(kAudioChunkSweep) - 1;
+            if (!setAudioChunkSizeSweep(chunkSizes))
+                log("Invalid audio chunk sizes: "s + chunkSizes + " (comma separated list of sizes expected)");
         } else {
             log("Unknown option ignored: "s + argv[i]);
         }
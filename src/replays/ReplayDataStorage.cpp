@@ -3,10 +3,12 @@
 #include "hilFile.h"
 #include "stats.h"
 #include "file.h"
+#include "hash.h"
 #include "util.h"
+#include "sprites.h"
 
 constexpr int kVersionMajor = 2;
-constexpr int kVersionMinor = 0;
+constexpr int kVersionMinor = 1;
 
 // make it bigger than the original, since we'll use 3 dwords to store the sprite data (vs. just 1)
 // but also more data is being recorded (all the sprites, not just visible @320x200) so count that too
@@ -49,6 +51,12 @@ bool ReplayDataStorage::isLegacyFormat() const
     return m_legacyFormat;
 }
 
+// True if the last loaded file was a legacy one, converted now or earlier.
+bool ReplayDataStorage::convertedFromLegacy() const
+{
+    return m_convertedFromLegacy;
+}
+
 void ReplayDataStorage::startRecordingNewReplay(bool legacyFormat /* = false */)
 {
     m_replayData.clear();
@@ -277,10 +285,12 @@ void ReplayDataStorage::skipFrames(int offset)
 
 auto ReplayDataStorage::load(const char *filename, const char *dir, HilV2Header& header, bool isReplay) -> FileStatus
 {
-    auto path = joinPaths(dir, filename);
+    auto path = dir ? joinPaths(dir, filename) : std::string(filename);
 
     logInfo("Loading replay file %s", path.c_str());
 
+    m_convertedFromLegacy = false;
+
     auto f = openFile(path.c_str());
     if (!f)
         return FileStatus::kIoError;
@@ -309,13 +319,9 @@ auto ReplayDataStorage::load(const char *filename, const char *dir, HilV2Header&
                 if (remainingSize > 0) {
                     int numElements = (remainingSize + sizeof(m_replayData[0]) - 1) / sizeof(m_replayData[0]);
                     if (m_legacyFormat) {
-                        decltype(m_replayData) legacyData;
-                        legacyData.resize(numElements);
-                        if (SDL_RWread(f, legacyData.data(), remainingSize, 1) != 1)
-                            result = FileStatus::kIoError;
-                        else
-                            convertLegacyData(legacyData, isReplay);
+                        result = loadLegacyData(f, path.c_str(), header, isReplay);
                     } else {
+                        m_legacyFormat = (header.flags & kHilV2LegacySpriteCoordinates) != 0;
                         m_replayData.resize(numElements);
                         if (SDL_RWread(f, m_replayData.data(), remainingSize, 1) != 1)
                             result = FileStatus::kIoError;
@@ -334,6 +340,137 @@ auto ReplayDataStorage::load(const char *filename, const char *dir, HilV2Header&
     return result;
 }
 
+// Converting legacy data is slow, so the result is saved next to the original file in the current format,
+// under a name derived from the hash and size of the original contents. Subsequent loads of the same legacy
+// file just read the converted one. Sprite center offsets are applied during conversion, so converted data
+// renders like any other v2 file; requires sprites to be loaded.
+auto ReplayDataStorage::loadLegacyData(SDL_RWops *f, const char *path, HilV2Header& header, bool isReplay) -> FileStatus
+{
+    assert(m_legacyFormat);
+
+    std::vector<char> contents(static_cast<size_t>(SDL_RWsize(f)));
+    if (contents.size() <= header.dataBufferOffset || SDL_RWseek(f, 0, RW_SEEK_SET) < 0 ||
+        SDL_RWread(f, contents.data(), contents.size(), 1) != 1)
+        return FileStatus::kIoError;
+
+    const auto& convertedPath = convertedFilePath(path, contents);
+
+    if (getFileSizeAndModificationTime(convertedPath.c_str()).first > 0) {
+        HilV2Header convertedHeader;
+        if (load(convertedPath.c_str(), nullptr, convertedHeader, isReplay) == FileStatus::kOk && !m_legacyFormat) {
+            logInfo("Using previously converted file %s", convertedPath.c_str());
+            header = convertedHeader;
+            m_convertedFromLegacy = true;
+            return FileStatus::kOk;
+        }
+        logWarn("Converted file %s unusable, converting again", convertedPath.c_str());
+    }
+
+    int dataSize = contents.size() - header.dataBufferOffset;
+    DataStore legacyData((dataSize + sizeof(legacyData[0]) - 1) / sizeof(legacyData[0]));
+    memcpy(legacyData.data(), contents.data() + header.dataBufferOffset, dataSize);
+
+    convertLegacyData(legacyData, isReplay);
+    applyLegacySpriteCenters();
+
+    auto convertedHeader = header;
+    if (save(convertedPath.c_str(), convertedHeader, isReplay, true))
+        removeStaleConvertedFiles(path, convertedPath);
+
+    m_convertedFromLegacy = true;
+    return FileStatus::kOk;
+}
+
+std::string ReplayDataStorage::convertedFilePath(const char *path, const std::vector<char>& contents)
+{
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%016llx-%zu.v2",
+        static_cast<unsigned long long>(hash64(contents.data(), contents.size())), contents.size());
+    return path + std::string(suffix);
+}
+
+// Files converted from previous versions of the legacy file, or by previous versions of the converter, are
+// never going to be used again.
+void ReplayDataStorage::removeStaleConvertedFiles(const char *path, const std::string& convertedPath)
+{
+    auto basename = getBasename(path);
+    std::string dir(path, basename - path);
+    if (!isAbsolutePath(dir.c_str()))
+        dir = pathInRootDir(dir.c_str());
+    if (dir.empty())
+        dir = ".";
+
+    const auto& prefix = std::string(basename) + '.';
+    auto convertedName = getBasename(convertedPath.c_str());
+    std::vector<std::string> staleFiles;
+
+    // only <file>.<hash>.v2, so that converted files of other legacy files with the same prefix are left alone
+    traverseDirectory(dir.c_str(), ".v2", [&](const char *filename, int length, const char *dot) {
+        if (length > static_cast<int>(prefix.size()) && !pathNCompare(filename, prefix.c_str(), prefix.size()) &&
+            strchr(filename + prefix.size(), '.') == dot && pathCompare(filename, convertedName))
+            staleFiles.push_back(joinPaths(dir.c_str(), filename));
+        return true;
+    });
+
+    for (const auto& file : staleFiles) {
+        logInfo("Removing stale converted file %s", file.c_str());
+        remove(file.c_str());
+    }
+}
+
+// Legacy data stores sprite coordinates without center offsets; bake them in once, instead of having every
+// replayed frame add them.
+void ReplayDataStorage::applyLegacySpriteCenters()
+{
+    assert(m_legacyFormat);
+
+    for (size_t frame = 0; frame + kFrameNumElements <= m_replayData.size(); ) {
+        size_t nextFrame = m_replayData[frame + kNextFrameOffset];
+        if (nextFrame <= frame || nextFrame > m_replayData.size())
+            break;
+
+        for (auto i = frame + kFrameNumElements; i < nextFrame; ) {
+            switch (m_replayData[i] & kObjectTypeMask) {
+            case kStatsMask:
+                i += kStatsNumElements;
+                break;
+
+            case kSfxMask:
+                i += kSfxNumElements;
+                break;
+
+            default:
+                if (i + kSpriteNumElements <= nextFrame) {
+                    const auto& sprite = getSprite(m_replayData[i] & ~kObjectTypeMask);
+                    m_replayData[i + 1] += static_cast<int>(std::lround((sprite.centerXF + sprite.xOffsetF) * 0x10000));
+                    m_replayData[i + 2] += static_cast<int>(std::lround((sprite.centerYF + sprite.yOffsetF) * 0x10000));
+                }
+                i += kSpriteNumElements;
+                break;
+            }
+        }
+
+        frame = nextFrame;
+    }
+
+    m_legacyFormat = false;
+}
+
+// Reads only the header of a replay or highlights file, converting it to the current format if needed.
+// Doesn't touch any instance state so it's safe to call from multiple threads.
+auto ReplayDataStorage::loadFileHeader(const char *path, HilV2Header& header) -> FileStatus
+{
+    auto f = openFile(path);
+    if (!f)
+        return FileStatus::kIoError;
+
+    bool legacyFormat;
+    auto result = readHeader(f, header, legacyFormat);
+
+    SDL_RWclose(f);
+    return result;
+}
+
 bool ReplayDataStorage::save(const char *filename, HilV2Header& header, bool isReplay, bool overwrite)
 {
     logInfo("Saving replay file %s", filename);
@@ -349,6 +486,7 @@ bool ReplayDataStorage::save(const char *filename, HilV2Header& header, bool isR
     header.minor = kVersionMinor;
     header.numScenes = static_cast<word>(m_sceneOffsets.size());
     header.dataBufferOffset = sizeof(header) + sceneOffsetTableSize();
+    header.flags = m_legacyFormat ? kHilV2LegacySpriteCoordinates : 0;
 
     bool result = SDL_RWwrite(f, &header, sizeof(header), 1) == 1 &&
         saveSceneTable(f, isReplay) && saveData(f, isReplay);
@@ -401,6 +539,13 @@ void ReplayDataStorage::updateSceneOffsets(int numElements, bool newFrame /* = f
 }
 
 auto ReplayDataStorage::loadHeader(SDL_RWops *f, HilV2Header& header, int& headerSize) -> FileStatus
+{
+    auto result = readHeader(f, header, m_legacyFormat);
+    headerSize = m_legacyFormat ? sizeof(HilV1Header) : sizeof(HilV2Header);
+    return result;
+}
+
+auto ReplayDataStorage::readHeader(SDL_RWops *f, HilV2Header& header, bool& legacyFormat) -> FileStatus
 {
     assert(f);
 
@@ -415,15 +560,13 @@ auto ReplayDataStorage::loadHeader(SDL_RWops *f, HilV2Header& header, int& heade
         result = FileStatus::kIoError;
     } else {
         if (v1Header.magic1 == kHilV1Magic1 && v1Header.magic2 == kHilV1Magic2) {
-            m_legacyFormat = true;
-            headerSize = sizeof(HilV1Header);
+            legacyFormat = true;
             if (SDL_RWread(f, &v1Header.team1, sizeof(HilV1Header) - 8, 1) != 1)
                 result = FileStatus::kIoError;
             else
                 LegacyReplayConverter::convertLegacyHeader(v1Header, header);
         } else if (!memcmp(v2Header.magic, kHilV2Magic, sizeof(kHilV2Magic))) {
-            m_legacyFormat = false;
-            headerSize = sizeof(HilV2Header);
+            legacyFormat = false;
             if (v2Header.major > kVersionMajor) {
                 result = FileStatus::kUnsupportedVersion;
             } else {
@@ -484,50 +627,88 @@ bool ReplayDataStorage::saveData(SDL_RWops *f, bool isReplay) const
     if (isReplay) {
         return SDL_RWwrite(f, m_replayData.data(), m_replayData.size() * sizeof(m_replayData[0]), 1) == 1;
     } else {
-        if (highlightsNeedFixup()) {
-            const auto& data = highlightsData();
-            return SDL_RWwrite(f, data.data(), data.size() * sizeof(m_replayData[0]), 1) == 1;
-        } else {
+        if (highlightsNeedFixup())
+            return saveHighlightsData(f);
+        else
             return SDL_RWwrite(f, m_replayData.data(), m_sceneOffsets.back().back() * sizeof(m_replayData[0]), 1) == 1;
-        }
     }
 }
 
-auto ReplayDataStorage::highlightsData() const -> DataStore
+// Writes highlight scenes packed one after another, straight from the replay data. Frame links are adjusted
+// on the fly while passing through a small fixed buffer, so memory use doesn't depend on the size of highlights.
+// Each scene is written whole and nothing past it; a broken frame link is clamped to the end of its scene.
+bool ReplayDataStorage::saveHighlightsData(SDL_RWops *f) const
 {
-    auto size = std::accumulate(m_sceneOffsets.begin(), m_sceneOffsets.end(), 0, [](int sum, const auto& sceneOffset) {
-        return sum + sceneSize(sceneOffset);
-    });
+    constexpr int kChunkNumElements = 4'096;
+    static_assert(kChunkNumElements >= kFrameNumElements, "Chunk must be able to hold a frame header");
+
+    std::array<RawInt32, kChunkNumElements> chunk;
+    int chunkLength = 0;
+
+    auto flush = [&]() {
+        bool ok = !chunkLength || SDL_RWwrite(f, chunk.data(), chunkLength * sizeof(chunk[0]), 1) == 1;
+        chunkLength = 0;
+        return ok;
+    };
+
+    auto copy = [&](int start, int end) {
+        while (start < end) {
+            if (chunkLength == kChunkNumElements && !flush())
+                return false;
 
-    DataStore data(size);
+            int count = std::min(end - start, kChunkNumElements - chunkLength);
+            std::copy_n(&m_replayData[start], count, &chunk[chunkLength]);
+
+            chunkLength += count;
+            start += count;
+        }
+
+        return true;
+    };
 
     int dataOffset = 0;
     int prevFrameOffset = -1;
 
     for (const auto& sceneOffset : m_sceneOffsets) {
+        int base = sceneOffset.front();
         int len = sceneSize(sceneOffset);
 
-        memcpy(&data[dataOffset], &m_replayData[sceneOffset.front()], len * sizeof(sceneOffset[0]));
+        for (int i = 0; i < len; ) {
+            if (len - i < kFrameNumElements) {
+                logWarn("Highlights scene at %d ends with an incomplete frame", base);
+                if (!copy(base + i, base + len))
+                    return false;
+                break;
+            }
 
-        int base = sceneOffset.front();
-        int diff = base - dataOffset;
+            int frameEnd = m_replayData[base + i + kNextFrameOffset] - base;
+            if (frameEnd < i + kFrameNumElements || frameEnd > len) {
+                logWarn("Invalid frame link in highlights scene at %d, clamping it to the end of the scene", base);
+                frameEnd = len;
+            }
 
-        for (int i = 0; i < len; ) {
-            auto& nextFrameOffset = data[dataOffset + i + kNextFrameOffset];
-            nextFrameOffset -= diff;
+            if (chunkLength + kFrameNumElements > kChunkNumElements && !flush())
+                return false;
 
-            data[dataOffset + i + kPrevFrameOffset] = prevFrameOffset;
-            prevFrameOffset = nextFrameOffset;
+            auto frame = &chunk[chunkLength];
+            std::copy_n(&m_replayData[base + i], kFrameNumElements, frame);
 
-            i = m_replayData[sceneOffset.front() + i + kNextFrameOffset] - sceneOffset.front();
+            frame[kNextFrameOffset] = dataOffset + frameEnd;
+            frame[kPrevFrameOffset] = prevFrameOffset;
+            prevFrameOffset = frame[kNextFrameOffset];
+
+            chunkLength += kFrameNumElements;
+
+            if (!copy(base + i + kFrameNumElements, base + frameEnd))
+                return false;
+
+            i = frameEnd;
         }
 
         dataOffset += len;
     }
 
-    assert(dataOffset == size);
-
-    return data;
+    return flush();
 }
 
 bool ReplayDataStorage::highlightsNeedFixup() const
@@ -59,6 +59,7 @@ public:
     int numScenes() const;
     bool empty() const;
     bool isLegacyFormat() const;
+    bool convertedFromLegacy() const;
 
     void startRecordingNewReplay(bool legacyFormat = false);
     void recordFrame(const FrameData& data);
@@ -83,6 +84,7 @@ public:
     void skipFrames(int offset);
 
     FileStatus load(const char *filename, const char *dir, HilV2Header& header, bool isReplay);
+    static FileStatus loadFileHeader(const char *path, HilV2Header& header);
     bool save(const char *filename, HilV2Header& header, bool isReplay, bool overwrite);
 
 private:
@@ -119,18 +121,23 @@ struct RawInt32 {
     void updateSceneOffsets(int numElements, bool newFrame = false);
 
     FileStatus loadHeader(SDL_RWops *f, HilV2Header& header, int& headerSize);
+    static FileStatus readHeader(SDL_RWops *f, HilV2Header& header, bool& legacyFormat);
+    FileStatus loadLegacyData(SDL_RWops *f, const char *path, HilV2Header& header, bool isReplay);
+    static std::string convertedFilePath(const char *path, const std::vector<char>& contents);
+    static void removeStaleConvertedFiles(const char *path, const std::string& convertedPath);
+    void applyLegacySpriteCenters();
     bool loadSceneTable(SDL_RWops *f, int numScenes);
     bool saveSceneTable(SDL_RWops *f, bool isReplay);
     bool saveData(SDL_RWops *f, bool isReplay) const;
-    DataStore highlightsData() const;
+    bool saveHighlightsData(SDL_RWops *f) const;
     bool highlightsNeedFixup() const;
-    void fixupScene() const;
     size_t sceneOffsetTableSize() const;
 
     void convertLegacyData(const DataStore& legacyData, bool isReplay);
 
     DataStore m_replayData;
     bool m_legacyFormat = false;
+    bool m_convertedFromLegacy = false;
 
     using SceneOffset = std::array<uint32_t, 2>;
     using SceneOffsetTable = std::vector<SceneOffset>;
@@ -40,7 +40,7 @@ struct HilV2Header
     byte pitchType;
     byte pitchNumber;
     word numMaxSubstitutes;
-    word padding;
+    word flags;
 };
 #pragma pack(pop)
 
@@ -50,3 +50,6 @@ constexpr int kHilV1Magic1 = 8;
 constexpr int kHilV1Magic2 = 193'626;
 
 constexpr char kHilV2Magic[4] = { 'H', 'I', 'L', '2' };
+
+// sprite coordinates are stored the way SWOS did it, without sprite center offsets (data converted from v1)
+constexpr word kHilV2LegacySpriteCoordinates = 1;
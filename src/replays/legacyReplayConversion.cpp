@@ -0,0 +1,71 @@
+// Batch conversion of legacy SWOS highlights files. Loading a legacy file converts it and caches the result
+// next to it (see ReplayDataStorage::loadLegacyData()), so this just loads every file in the directory,
+// spreading them over all available cores.
+
+#include "legacyReplayConversion.h"
+#include "ReplayDataStorage.h"
+#include "hilFile.h"
+#include "file.h"
+
+#include <future>
+
+static std::string m_conversionDir;
+
+void setLegacyReplayConversionDir(const char *dir)
+{
+    m_conversionDir = dir;
+}
+
+bool legacyReplayConversionRequested()
+{
+    return !m_conversionDir.empty();
+}
+
+// Returns true if all the files in the directory loaded successfully. Sprites must be loaded, conversion needs
+// their center offsets.
+bool convertLegacyReplays()
+{
+    assert(legacyReplayConversionRequested());
+
+    auto files = findFiles(".hil", m_conversionDir.c_str());
+    if (files.empty()) {
+        logWarn("No highlights files found in %s", m_conversionDir.c_str());
+        return false;
+    }
+
+    int numWorkers = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), files.size()));
+    logInfo("Converting %zu highlights files using %d threads", files.size(), numWorkers);
+
+    std::atomic<size_t> nextFile{ 0 };
+    std::atomic<int> numLegacy{ 0 };
+    std::atomic<int> numFailed{ 0 };
+    std::vector<std::future<void>> workers;
+
+    auto startTime = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(std::async(std::launch::async, [&]() {
+            ReplayDataStorage storage;
+            HilV2Header header;
+
+            for (size_t fileIndex; (fileIndex = nextFile++) < files.size(); ) {
+                storage.startRecordingNewReplay();
+                const auto& filename = files[fileIndex].name;
+
+                if (storage.load(filename.c_str(), m_conversionDir.c_str(), header, false) != ReplayDataStorage::FileStatus::kOk)
+                    numFailed++;
+                else if (storage.convertedFromLegacy())
+                    numLegacy++;
+            }
+        }));
+    }
+
+    for (auto& worker : workers)
+        worker.get();
+
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+    logInfo("Processed %zu files in %.2f seconds: %d legacy, %d failed", files.size(), elapsed,
+        numLegacy.load(), numFailed.load());
+
+    return !numFailed;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+void setLegacyReplayConversionDir(const char *dir);
+
+bool legacyReplayConversionRequested();
+bool convertLegacyReplays();
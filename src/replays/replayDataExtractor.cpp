@@ -0,0 +1,375 @@
+// Batch extraction of replay data into flat columnar files, meant for offline analysis (heat maps, ball
+// possession, player movement...). Every replay/highlights file in the given directory gets a companion
+// .cols file, and the files are processed in parallel, one ReplayDataStorage per worker.
+//
+// Layout of the .cols file (all little endian):
+//   ColumnarFileHeader
+//   ColumnDescriptor * numColumns
+//   column data, each column a tightly packed array of its type, starting at descriptor's offset
+//
+// Columns are grouped into tables by name prefix (frame., sprite., sfx., stats.); all columns of a table
+// have the same number of rows. Every non-frame table has a .frame column indexing into the frame table.
+
+#include "replayDataExtractor.h"
+#include "ReplayDataStorage.h"
+#include "hilFile.h"
+#include "sprites.h"
+#include "file.h"
+#include "util.h"
+
+#include <future>
+
+enum class ColumnType : uint32_t
+{
+    kInt16,
+    kInt32,
+    kUInt32,
+    kFloat32,
+};
+
+#pragma pack(push, 1)
+struct ColumnarFileHeader
+{
+    char magic[4];
+    word major;
+    word minor;
+    dword numColumns;
+    dword numFrames;
+};
+
+struct ColumnDescriptor
+{
+    char name[24];
+    ColumnType type;
+    dword numRows;
+    uint64_t offset;
+};
+#pragma pack(pop)
+
+constexpr char kColumnarMagic[4] = { 'S', 'W', 'R', 'C' };
+constexpr int kColumnarVersionMajor = 1;
+constexpr int kColumnarVersionMinor = 0;
+
+constexpr char kColumnarExtension[] = ".cols";
+
+static std::string m_inputDir;
+static std::string m_outputDir;
+
+class Column
+{
+public:
+    Column(const char *name, ColumnType type) : m_name(name), m_type(type) {}
+
+    template <typename T>
+    void push(T value) {
+        assert(sizeof(T) == (m_type == ColumnType::kInt16 ? 2 : 4));
+        auto bytes = reinterpret_cast<const uint8_t *>(&value);
+        m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+    }
+
+    const char *name() const { return m_name; }
+    ColumnType type() const { return m_type; }
+    size_t numRows() const { return m_data.size() / (m_type == ColumnType::kInt16 ? 2 : 4); }
+    const std::vector<uint8_t>& data() const { return m_data; }
+
+private:
+    const char *m_name;
+    ColumnType m_type;
+    std::vector<uint8_t> m_data;
+};
+
+struct ReplayColumns
+{
+    Column frameCameraX{ "frame.cameraX", ColumnType::kFloat32 };
+    Column frameCameraY{ "frame.cameraY", ColumnType::kFloat32 };
+    Column frameTeam1Goals{ "frame.team1Goals", ColumnType::kInt16 };
+    Column frameTeam2Goals{ "frame.team2Goals", ColumnType::kInt16 };
+    Column frameGameTime{ "frame.gameTime", ColumnType::kInt32 };
+    Column frameScene{ "frame.scene", ColumnType::kInt16 };
+    Column frameFirstSprite{ "frame.firstSprite", ColumnType::kUInt32 };
+
+    Column spriteFrame{ "sprite.frame", ColumnType::kUInt32 };
+    Column spriteImage{ "sprite.image", ColumnType::kInt16 };
+    Column spriteX{ "sprite.x", ColumnType::kFloat32 };
+    Column spriteY{ "sprite.y", ColumnType::kFloat32 };
+
+    Column sfxFrame{ "sfx.frame", ColumnType::kUInt32 };
+    Column sfxSample{ "sfx.sample", ColumnType::kInt16 };
+    Column sfxVolume{ "sfx.volume", ColumnType::kInt16 };
+
+    Column statsFrame{ "stats.frame", ColumnType::kUInt32 };
+    std::array<Column, 14> stats{{
+        { "stats.t1.possession", ColumnType::kInt16 }, { "stats.t1.cornersWon", ColumnType::kInt16 },
+        { "stats.t1.fouls", ColumnType::kInt16 }, { "stats.t1.bookings", ColumnType::kInt16 },
+        { "stats.t1.sendingsOff", ColumnType::kInt16 }, { "stats.t1.goalAttempts", ColumnType::kInt16 },
+        { "stats.t1.onTarget", ColumnType::kInt16 },
+        { "stats.t2.possession", ColumnType::kInt16 }, { "stats.t2.cornersWon", ColumnType::kInt16 },
+        { "stats.t2.fouls", ColumnType::kInt16 }, { "stats.t2.bookings", ColumnType::kInt16 },
+        { "stats.t2.sendingsOff", ColumnType::kInt16 }, { "stats.t2.goalAttempts", ColumnType::kInt16 },
+        { "stats.t2.onTarget", ColumnType::kInt16 },
+    }};
+
+    std::vector<const Column *> all() const {
+        std::vector<const Column *> result = {
+            &frameCameraX, &frameCameraY, &frameTeam1Goals, &frameTeam2Goals, &frameGameTime, &frameScene,
+            &frameFirstSprite, &spriteFrame, &spriteImage, &spriteX, &spriteY, &sfxFrame, &sfxSample, &sfxVolume,
+            &statsFrame,
+        };
+        for (const auto& column : stats)
+            result.push_back(&column);
+        return result;
+    }
+};
+
+struct ExtractionResult
+{
+    bool ok = false;
+    int numFrames = 0;
+    double seconds = 0;
+};
+
+static std::vector<std::string> findReplayFiles();
+static ExtractionResult extractFile(ReplayDataStorage& storage, const std::string& filename);
+static int fillColumns(ReplayDataStorage& storage, bool isReplay, ReplayColumns& columns);
+static void addStats(const GameStats& stats, ReplayColumns& columns);
+static int unpackGameTime(int gameTime);
+static bool saveColumns(const char *path, const ReplayColumns& columns, int numFrames);
+
+void setReplayExtractionDir(const char *dir)
+{
+    m_inputDir = dir;
+}
+
+void setReplayExtractionOutputDir(const char *dir)
+{
+    m_outputDir = dir;
+}
+
+bool replayExtractionRequested()
+{
+    return !m_inputDir.empty();
+}
+
+// Converts all the replays in the input directory, spreading the files over all available cores.
+// Returns true if every file was converted successfully.
+bool extractReplayData()
+{
+    assert(replayExtractionRequested());
+
+    if (m_outputDir.empty())
+        m_outputDir = m_inputDir;
+
+    const auto& files = findReplayFiles();
+    if (files.empty()) {
+        logWarn("No replay files found in %s", m_inputDir.c_str());
+        return true;
+    }
+
+    int numWorkers = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), files.size()));
+    logInfo("Extracting data from %zu replay files using %d threads", files.size(), numWorkers);
+
+    std::atomic<size_t> nextFile{ 0 };
+    std::vector<ExtractionResult> results(files.size());
+    std::vector<std::future<void>> workers;
+
+    auto startTime = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(std::async(std::launch::async, [&]() {
+            ReplayDataStorage storage;
+            for (size_t fileIndex; (fileIndex = nextFile++) < files.size(); )
+                results[fileIndex] = extractFile(storage, files[fileIndex]);
+        }));
+    }
+
+    for (auto& worker : workers)
+        worker.get();
+
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+
+    int64_t totalFrames = 0;
+    double totalFileTime = 0;
+    int numFailed = 0;
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto& result = results[i];
+        if (result.ok) {
+            totalFrames += result.numFrames;
+            totalFileTime += result.seconds;
+        } else {
+            numFailed++;
+            logWarn("Failed to extract data from %s", files[i].c_str());
+        }
+    }
+
+    auto totalFps = elapsed > 0 ? totalFrames / elapsed : 0;
+    auto perCoreFps = totalFileTime > 0 ? totalFrames / totalFileTime : 0;
+
+    logInfo("Extracted %s frames from %d files in %.2f seconds: %.0f frames/s total, "
+        "%.0f frames/s per core (%d threads), %d failed", formatNumberWithCommas(totalFrames).c_str(),
+        static_cast<int>(files.size()) - numFailed, elapsed, totalFps, perCoreFps, numWorkers, numFailed);
+
+    return numFailed == 0;
+}
+
+static std::vector<std::string> findReplayFiles()
+{
+    std::vector<std::string> result;
+
+    for (auto extension : { ".rpl", ".hil" }) {
+        for (const auto& file : findFiles(extension, m_inputDir.c_str()))
+            result.push_back(file.name);
+    }
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+static ExtractionResult extractFile(ReplayDataStorage& storage, const std::string& filename)
+{
+    ExtractionResult result;
+
+    auto startTime = SDL_GetPerformanceCounter();
+
+    auto isReplay = pathCompare(getFileExtension(filename.c_str()), ".hil") != 0;
+    HilV2Header header;
+
+    storage.startRecordingNewReplay();
+    if (storage.load(filename.c_str(), m_inputDir.c_str(), header, isReplay) != ReplayDataStorage::FileStatus::kOk)
+        return result;
+
+    ReplayColumns columns;
+    result.numFrames = fillColumns(storage, isReplay, columns);
+
+    const auto& outputPath = joinPaths(m_outputDir.c_str(), (filename + kColumnarExtension).c_str());
+    result.ok = saveColumns(outputPath.c_str(), columns, result.numFrames);
+    result.seconds = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+
+    return result;
+}
+
+static int fillColumns(ReplayDataStorage& storage, bool isReplay, ReplayColumns& columns)
+{
+    if (storage.empty())
+        return 0;
+
+    int numFrames = 0;
+    int numScenes = isReplay ? 1 : storage.numScenes();
+
+    for (int scene = 0; scene < numScenes; scene++) {
+        if (isReplay)
+            storage.setupForFullReplay();
+        else
+            storage.setupForStoredSceneReplay(scene);
+
+        ReplayDataStorage::FrameData frameData;
+
+        while (storage.fetchFrameData(frameData)) {
+            columns.frameCameraX.push(frameData.cameraX.asFloat());
+            columns.frameCameraY.push(frameData.cameraY.asFloat());
+            columns.frameTeam1Goals.push(static_cast<int16_t>(frameData.team1Goals));
+            columns.frameTeam2Goals.push(static_cast<int16_t>(frameData.team2Goals));
+            columns.frameGameTime.push(unpackGameTime(frameData.gameTime));
+            columns.frameScene.push(static_cast<int16_t>(scene));
+            columns.frameFirstSprite.push(static_cast<uint32_t>(columns.spriteFrame.numRows()));
+
+            ReplayDataStorage::Object obj;
+
+            while (storage.fetchObject(obj)) {
+                switch (obj.type) {
+                case ReplayDataStorage::ObjectType::kSprite:
+                    if (storage.isLegacyFormat()) {
+                        const auto& sprite = getSprite(obj.imageIndex);
+                        obj.x += sprite.centerXF + sprite.xOffsetF;
+                        obj.y += sprite.centerYF + sprite.yOffsetF;
+                    }
+                    columns.spriteFrame.push(static_cast<uint32_t>(numFrames));
+                    columns.spriteImage.push(static_cast<int16_t>(obj.imageIndex));
+                    columns.spriteX.push(obj.x);
+                    columns.spriteY.push(obj.y);
+                    break;
+
+                case ReplayDataStorage::ObjectType::kStats:
+                    columns.statsFrame.push(static_cast<uint32_t>(numFrames));
+                    addStats(obj.stats, columns);
+                    break;
+
+                case ReplayDataStorage::ObjectType::kSfx:
+                    columns.sfxFrame.push(static_cast<uint32_t>(numFrames));
+                    columns.sfxSample.push(static_cast<int16_t>(obj.sampleIndex));
+                    columns.sfxVolume.push(static_cast<int16_t>(obj.volume));
+                    break;
+
+                case ReplayDataStorage::ObjectType::kUnknown:
+                    assert(false);
+                    break;
+                }
+            }
+
+            numFrames++;
+        }
+    }
+
+    return numFrames;
+}
+
+static void addStats(const GameStats& stats, ReplayColumns& columns)
+{
+    auto column = columns.stats.begin();
+
+    for (const auto teamStats : { &stats.team1, &stats.team2 }) {
+        for (auto value : { teamStats->ballPossession, teamStats->cornersWon, teamStats->foulsConceded,
+            teamStats->bookings, teamStats->sendingsOff, teamStats->goalAttempts, teamStats->onTarget })
+            (column++)->push(static_cast<int16_t>(value));
+    }
+
+    assert(column == columns.stats.end());
+}
+
+// Game time is recorded as 3 packed BCD digits, convert it to minutes (-1 if time wasn't showing).
+static int unpackGameTime(int gameTime)
+{
+    if (gameTime < 0)
+        return -1;
+
+    return ((gameTime >> 16) & 0xff) * 100 + ((gameTime >> 8) & 0xff) * 10 + (gameTime & 0xff);
+}
+
+static bool saveColumns(const char *path, const ReplayColumns& columns, int numFrames)
+{
+    const auto& columnList = columns.all();
+
+    ColumnarFileHeader header;
+    memcpy(header.magic, kColumnarMagic, sizeof(kColumnarMagic));
+    header.major = kColumnarVersionMajor;
+    header.minor = kColumnarVersionMinor;
+    header.numColumns = columnList.size();
+    header.numFrames = numFrames;
+
+    std::vector<ColumnDescriptor> descriptors(columnList.size());
+    uint64_t offset = sizeof(header) + vectorByteSize(descriptors);
+
+    for (size_t i = 0; i < columnList.size(); i++) {
+        auto& descriptor = descriptors[i];
+        strncpy(descriptor.name, columnList[i]->name(), sizeof(descriptor.name));
+        descriptor.type = columnList[i]->type();
+        descriptor.numRows = columnList[i]->numRows();
+        descriptor.offset = offset;
+        offset += columnList[i]->data().size();
+    }
+
+    auto f = openFile(path, "wb");
+    if (!f)
+        return false;
+
+    bool result = SDL_RWwrite(f, &header, sizeof(header), 1) == 1 &&
+        SDL_RWwrite(f, descriptors.data(), vectorByteSize(descriptors), 1) == 1;
+
+    for (size_t i = 0; result && i < columnList.size(); i++) {
+        const auto& data = columnList[i]->data();
+        result = data.empty() || SDL_RWwrite(f, data.data(), data.size(), 1) == 1;
+    }
+
+    SDL_RWclose(f);
+    return result;
+}
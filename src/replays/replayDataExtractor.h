@@ -0,0 +1,7 @@
+#pragma once
+
+void setReplayExtractionDir(const char *dir);
+void setReplayExtractionOutputDir(const char *dir);
+
+bool replayExtractionRequested();
+bool extractReplayData();
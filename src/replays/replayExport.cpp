@@ -0,0 +1,241 @@
+// Headless replay export: renders replay/highlights frames offscreen as fast as possible and streams them out
+// as raw RGBA or YUV4MPEG2 video, with sound effects written to a separate text track.
+
+#include "replayExport.h"
+#include "replays.h"
+#include "render.h"
+#include "timer.h"
+#include "windowManager.h"
+#include "file.h"
+#include "util.h"
+
+#ifdef _WIN32
+# include <io.h>
+# include <fcntl.h>
+#endif
+
+enum class ExportFormat
+{
+    kRgba,
+    kY4m,
+};
+
+static std::string m_replayPath;
+static std::string m_outputPath;
+static std::string m_sfxOutputPath;
+static ExportFormat m_format = ExportFormat::kY4m;
+
+static bool doExportReplay();
+static FILE *openOutput();
+static void closeOutput(FILE *f);
+static void deleteOutputFiles(const std::string& sfxPath);
+static std::string sfxOutputPath();
+static bool writeFrame(FILE *f, const std::vector<uint8_t>& rgba, int width, int height, std::vector<uint8_t>& yuv);
+static void convertToYuv444(const std::vector<uint8_t>& rgba, int numPixels, std::vector<uint8_t>& yuv);
+
+void setReplayExportFile(const char *path)
+{
+    m_replayPath = path;
+}
+
+bool setReplayExportFormat(const char *format)
+{
+    if (!_stricmp(format, "rgba"))
+        m_format = ExportFormat::kRgba;
+    else if (!_stricmp(format, "y4m"))
+        m_format = ExportFormat::kY4m;
+    else
+        return false;
+
+    return true;
+}
+
+// "-" or empty path means standard output.
+void setReplayExportOutput(const char *path)
+{
+    m_outputPath = path;
+}
+
+void setReplayExportSfxOutput(const char *path)
+{
+    m_sfxOutputPath = path;
+}
+
+bool replayExportRequested()
+{
+    return !m_replayPath.empty();
+}
+
+bool replayExportToStdout()
+{
+    return m_outputPath.empty() || m_outputPath == "-";
+}
+
+// The stream must contain nothing but the video, so when it goes to the standard output the log echo is
+// diverted to stderr. Must be called before the log is initialized, so nothing slips through.
+void setupReplayExportLog()
+{
+    if (replayExportRequested() && replayExportToStdout())
+        setLogConsoleStream(&std::cerr);
+}
+
+// Renders the requested replay file frame by frame and writes the frames out. Returns success status.
+bool exportReplay()
+{
+    assert(replayExportRequested());
+
+    return doExportReplay();
+}
+
+// Nothing is written until the replay is loaded and known to contain some frames, so a missing or broken file
+// doesn't leave behind a valid looking empty stream.
+static bool doExportReplay()
+{
+    int width, height;
+    std::tie(width, height) = getWindowSize();
+
+    if (!setOffscreenRenderTarget(width, height))
+        return false;
+
+    auto isReplay = pathCompare(getFileExtension(m_replayPath.c_str()), ".hil") != 0;
+    logInfo("Exporting %s %s, %dx%d, format: %s", isReplay ? "replay" : "highlights", m_replayPath.c_str(),
+        width, height, m_format == ExportFormat::kY4m ? "Y4M" : "raw RGBA");
+
+    if (loadReplayForRendering(m_replayPath.c_str(), isReplay) != FileStatus::kOk) {
+        logWarn("Failed to export %s", m_replayPath.c_str());
+        return false;
+    }
+
+    if (isReplay ? !gotReplay() : !gotHighlights()) {
+        logWarn("Nothing to export, %s contains no frames", m_replayPath.c_str());
+        return false;
+    }
+
+    auto out = openOutput();
+    if (!out)
+        return false;
+
+    const auto& sfxPath = sfxOutputPath();
+    auto sfxOut = fopen(sfxPath.c_str(), "w");
+    if (!sfxOut) {
+        logWarn("Failed to open sfx track file %s", sfxPath.c_str());
+        closeOutput(out);
+        deleteOutputFiles(sfxPath);
+        return false;
+    }
+
+    fprintf(sfxOut, "# frame,sample,volume @ %d fps\n", targetFps());
+
+    if (m_format == ExportFormat::kY4m)
+        fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, targetFps());
+
+    std::vector<uint8_t> rgba(width * height * 4);
+    std::vector<uint8_t> yuv;
+    int frameNo = 0;
+
+    auto startTime = SDL_GetPerformanceCounter();
+
+    auto numFrames = renderAllReplayFrames(isReplay, [&]() {
+        if (!readOffscreenFrame(rgba.data(), width * 4) || !writeFrame(out, rgba, width, height, yuv))
+            return false;
+
+        frameNo++;
+        return true;
+    }, [&](int sampleIndex, int volume) {
+        fprintf(sfxOut, "%d,%d,%d\n", frameNo, sampleIndex, volume);
+    });
+
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+
+    fclose(sfxOut);
+    closeOutput(out);
+
+    if (numFrames < 0) {
+        logWarn("Failed to export %s", m_replayPath.c_str());
+        deleteOutputFiles(sfxPath);
+        return false;
+    }
+
+    auto fps = elapsed > 0 ? numFrames / elapsed : 0;
+    logInfo("Exported %d frames in %.2f seconds (%.1f fps, %.2fx real time)", numFrames, elapsed, fps, fps / targetFps());
+
+    return true;
+}
+
+static FILE *openOutput()
+{
+    if (replayExportToStdout()) {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        return stdout;
+    }
+
+    auto f = fopen(m_outputPath.c_str(), "wb");
+    if (!f)
+        logWarn("Failed to open export output file %s", m_outputPath.c_str());
+
+    return f;
+}
+
+static void closeOutput(FILE *f)
+{
+    if (f == stdout)
+        fflush(f);
+    else
+        fclose(f);
+}
+
+// Removes whatever got written of a failed export; the standard output can't be taken back.
+static void deleteOutputFiles(const std::string& sfxPath)
+{
+    if (!replayExportToStdout())
+        remove(m_outputPath.c_str());
+
+    remove(sfxPath.c_str());
+}
+
+// If not explicitly given, the sfx track goes next to the output file (or the replay itself when piping).
+static std::string sfxOutputPath()
+{
+    if (!m_sfxOutputPath.empty())
+        return m_sfxOutputPath;
+
+    if (replayExportToStdout())
+        return m_replayPath + ".sfx";
+
+    return m_outputPath + ".sfx";
+}
+
+static bool writeFrame(FILE *f, const std::vector<uint8_t>& rgba, int width, int height, std::vector<uint8_t>& yuv)
+{
+    int numPixels = width * height;
+
+    if (m_format == ExportFormat::kRgba)
+        return fwrite(rgba.data(), rgba.size(), 1, f) == 1;
+
+    convertToYuv444(rgba, numPixels, yuv);
+
+    return fputs("FRAME\n", f) >= 0 && fwrite(yuv.data(), yuv.size(), 1, f) == 1;
+}
+
+// Converts to planar full-resolution Y'CbCr using fixed point BT.601 coefficients.
+static void convertToYuv444(const std::vector<uint8_t>& rgba, int numPixels, std::vector<uint8_t>& yuv)
+{
+    yuv.resize(3 * numPixels);
+
+    auto y = yuv.data();
+    auto u = y + numPixels;
+    auto v = u + numPixels;
+    auto src = rgba.data();
+
+    for (int i = 0; i < numPixels; i++, src += 4) {
+        int r = src[0];
+        int g = src[1];
+        int b = src[2];
+
+        y[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        u[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        v[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+}
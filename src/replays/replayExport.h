@@ -0,0 +1,11 @@
+#pragma once
+
+void setReplayExportFile(const char *path);
+bool setReplayExportFormat(const char *format);
+void setReplayExportOutput(const char *path);
+void setReplayExportSfxOutput(const char *path);
+
+bool replayExportRequested();
+bool replayExportToStdout();
+void setupReplayExportLog();
+bool exportReplay();
@@ -0,0 +1,222 @@
+// Keeps an index of replay/highlights file header summaries in each directory, so the file browser can show
+// teams and the score for every file without opening them all each time. Only files whose size or modification
+// time changed since the index was written get their headers read again, and that's done in parallel.
+
+#include "replayFileIndex.h"
+#include "ReplayDataStorage.h"
+#include "hilFile.h"
+#include "util.h"
+
+#include <future>
+#include <unordered_set>
+
+constexpr char kIndexFilename[] = "replays.idx";
+constexpr char kIndexMagic[4] = { 'R', 'I', 'D', 'X' };
+constexpr dword kIndexVersion = 1;
+
+#pragma pack(push, 1)
+struct IndexHeader
+{
+    char magic[4];
+    dword version;
+    dword numEntries;
+};
+
+struct IndexEntry
+{
+    char filename[kMaxFilenameLength];
+    int64_t size;
+    int64_t modificationTime;
+    byte valid;
+    char team1Name[sizeof(TeamGame::teamName)];
+    char team2Name[sizeof(TeamGame::teamName)];
+    word team1Goals;
+    word team2Goals;
+    char gameRound[sizeof(HilV2Header::gameRound)];
+};
+#pragma pack(pop)
+
+using IndexMap = std::unordered_map<std::string, IndexEntry>;
+
+static size_t m_numHeadersRead;
+
+static IndexMap loadIndex(const std::string& indexPath);
+static void saveIndex(const std::string& indexPath, const IndexMap& index);
+static void readSummaries(const char *dir, std::vector<IndexEntry>& entries, const std::vector<size_t>& staleEntries);
+static std::string formatSummary(const IndexEntry& entry);
+
+// Returns replay files with the given extension from the given directory, with match summaries filled in as
+// descriptions. Refreshes the directory index if anything changed.
+FoundFileList findReplayFilesWithSummaries(const char *extension, const char *dir)
+{
+    auto files = findFiles(extension, dir);
+
+    const auto& indexPath = joinPaths(dir, kIndexFilename);
+    auto index = loadIndex(indexPath);
+
+    std::vector<IndexEntry> entries(files.size());
+    std::vector<size_t> staleEntries;
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto& path = joinPaths(dir, files[i].name.c_str());
+
+        int64_t size, modificationTime;
+        std::tie(size, modificationTime) = getFileSizeAndModificationTime(path.c_str());
+
+        auto it = index.find(files[i].name);
+        if (it != index.end() && it->second.size == size && it->second.modificationTime == modificationTime) {
+            entries[i] = it->second;
+        } else {
+            auto& entry = entries[i];
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.filename, files[i].name.c_str(), sizeof(entry.filename) - 1);
+            entry.size = size;
+            entry.modificationTime = modificationTime;
+            staleEntries.push_back(i);
+        }
+    }
+
+    readSummaries(dir, entries, staleEntries);
+
+    // drop entries of deleted files (only those with our extension, other file types might share the directory)
+    std::unordered_set<std::string> existingFiles;
+    for (const auto& file : files)
+        existingFiles.insert(file.name);
+
+    bool indexChanged = !staleEntries.empty();
+    for (auto it = index.begin(); it != index.end(); ) {
+        auto ext = getFileExtension(it->first.c_str());
+        if (!pathCompare(ext, extension) && !existingFiles.count(it->first)) {
+            it = index.erase(it);
+            indexChanged = true;
+        } else {
+            ++it;
+        }
+    }
+
+    for (size_t i = 0; i < files.size(); i++) {
+        files[i].description = formatSummary(entries[i]);
+        index[files[i].name] = entries[i];
+    }
+
+    if (indexChanged)
+        saveIndex(indexPath, index);
+
+    m_numHeadersRead = staleEntries.size();
+
+    logInfo("Replay index for %s: %zu files, %zu re-read", dir, files.size(), staleEntries.size());
+
+    return files;
+}
+
+// Number of file headers that had to be read by the last index refresh.
+size_t numReplayHeadersReadOnLastRefresh()
+{
+    return m_numHeadersRead;
+}
+
+static IndexMap loadIndex(const std::string& indexPath)
+{
+    IndexMap index;
+
+    // no index yet is nothing to warn about
+    if (!fileExists(pathInRootDir(indexPath.c_str()).c_str()))
+        return index;
+
+    auto f = openFile(indexPath.c_str());
+    if (!f)
+        return index;
+
+    IndexHeader header;
+    if (SDL_RWread(f, &header, sizeof(header), 1) == 1 && !memcmp(header.magic, kIndexMagic, sizeof(kIndexMagic)) &&
+        header.version == kIndexVersion) {
+        for (dword i = 0; i < header.numEntries; i++) {
+            IndexEntry entry;
+            if (SDL_RWread(f, &entry, sizeof(entry), 1) != 1) {
+                logWarn("Replay index %s truncated", indexPath.c_str());
+                break;
+            }
+            entry.filename[sizeof(entry.filename) - 1] = '\0';
+            index[entry.filename] = entry;
+        }
+    }
+
+    SDL_RWclose(f);
+    return index;
+}
+
+static void saveIndex(const std::string& indexPath, const IndexMap& index)
+{
+    auto f = openFile(indexPath.c_str(), "wb");
+    if (!f)
+        return;
+
+    IndexHeader header;
+    memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.numEntries = index.size();
+
+    bool ok = SDL_RWwrite(f, &header, sizeof(header), 1) == 1;
+    for (auto it = index.begin(); ok && it != index.end(); ++it)
+        ok = SDL_RWwrite(f, &it->second, sizeof(it->second), 1) == 1;
+
+    SDL_RWclose(f);
+
+    if (!ok)
+        logWarn("Failed to write replay index %s", indexPath.c_str());
+}
+
+// Reads headers of new and changed files, spreading them over available cores.
+static void readSummaries(const char *dir, std::vector<IndexEntry>& entries, const std::vector<size_t>& staleEntries)
+{
+    if (staleEntries.empty())
+        return;
+
+    auto readSummary = [dir](IndexEntry& entry) {
+        const auto& path = joinPaths(dir, entry.filename);
+
+        HilV2Header header;
+        entry.valid = ReplayDataStorage::loadFileHeader(path.c_str(), header) == FileStatus::kOk;
+
+        if (entry.valid) {
+            memcpy(entry.team1Name, header.team1.teamName, sizeof(entry.team1Name));
+            memcpy(entry.team2Name, header.team2.teamName, sizeof(entry.team2Name));
+            memcpy(entry.gameRound, header.gameRound, sizeof(entry.gameRound));
+            entry.team1Name[sizeof(entry.team1Name) - 1] = '\0';
+            entry.team2Name[sizeof(entry.team2Name) - 1] = '\0';
+            entry.gameRound[sizeof(entry.gameRound) - 1] = '\0';
+            entry.team1Goals = header.team1Goals;
+            entry.team2Goals = header.team2Goals;
+        }
+    };
+
+    int numWorkers = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), staleEntries.size()));
+
+    std::atomic<size_t> nextEntry{ 0 };
+    std::vector<std::future<void>> workers;
+
+    for (int i = 0; i < numWorkers; i++) {
+        workers.emplace_back(std::async(std::launch::async, [&]() {
+            for (size_t entryIndex; (entryIndex = nextEntry++) < staleEntries.size(); )
+                readSummary(entries[staleEntries[entryIndex]]);
+        }));
+    }
+
+    for (auto& worker : workers)
+        worker.get();
+}
+
+static std::string formatSummary(const IndexEntry& entry)
+{
+    if (!entry.valid)
+        return {};
+
+    char buf[2 * sizeof(entry.team1Name) + sizeof(entry.gameRound) + 16];
+    int len = snprintf(buf, sizeof(buf), "%s %d-%d %s", entry.team1Name, entry.team1Goals, entry.team2Goals,
+        entry.team2Name);
+
+    if (entry.gameRound[0])
+        snprintf(buf + len, sizeof(buf) - len, ", %s", entry.gameRound);
+
+    return buf;
+}
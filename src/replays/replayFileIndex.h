@@ -0,0 +1,6 @@
+#pragma once
+
+#include "file.h"
+
+FoundFileList findReplayFilesWithSummaries(const char *extension, const char *dir);
+size_t numReplayHeadersReadOnLastRefresh();
@@ -63,6 +63,8 @@ static bool m_slowMotion;
 static int m_autoSaveReplays;
 static int m_showReplayPercentage;
 
+static std::function<void(int, int)> m_sfxHandler;
+
 static void runReplay(bool inGame, bool isReplay);
 static Status replayScene(bool inGame, bool isReplay, bool userRequested = false);
 static Status checkReplayControlKeys(bool inGame, bool userRequested);
@@ -240,6 +242,61 @@ FileStatus loadReplayFile(const char *path)
     return status;
 }
 
+// Loads a replay or highlights file given by the full path, to be rendered with renderAllReplayFrames().
+FileStatus loadReplayForRendering(const char *path, bool isReplay)
+{
+    assert(!m_replaying);
+
+    auto status = m_replayData.load(path, nullptr, m_header, isReplay);
+
+    if (status == FileStatus::kOk) {
+        m_gotHighlight = m_replayData.numScenes() > 0;
+        m_gotReplay = isReplay;
+    }
+
+    return status;
+}
+
+// Renders every frame of the loaded replay or highlights back to back, with no pacing, fading or screen updates.
+// Sound effects are not played but passed to sfxHandler. frameRendered is invoked after each frame is drawn,
+// and can abort the rendering by returning false. Returns the number of frames rendered, or -1 on error.
+int renderAllReplayFrames(bool isReplay, std::function<bool()> frameRendered, std::function<void(int, int)> sfxHandler)
+{
+    assert(!m_replaying && frameRendered && sfxHandler);
+
+    if (m_replayData.empty())
+        return 0;
+
+    m_instantReplay = false;
+    m_replaying = true;
+    m_sfxHandler = sfxHandler;
+
+    initMatch(&m_header.team1, &m_header.team2, true);
+
+    int numFrames = 0;
+    int numScenes = isReplay ? 1 : m_replayData.numScenes();
+
+    for (int i = 0; i < numScenes && numFrames >= 0; i++) {
+        if (isReplay)
+            m_replayData.setupForFullReplay();
+        else
+            m_replayData.setupForStoredSceneReplay(i);
+
+        while (fetchAndRenderFrame(isReplay)) {
+            if (!frameRendered()) {
+                numFrames = -1;
+                break;
+            }
+            numFrames++;
+        }
+    }
+
+    m_sfxHandler = nullptr;
+    m_replaying = false;
+
+    return numFrames;
+}
+
 bool saveHighlightsFile(const char *path, bool overwrite /* = true */)
 {
     return m_replayData.save(path, m_header, false, overwrite);
@@ -467,7 +524,9 @@ static bool fetchAndRenderFrame(bool isReplay)
             break;
 
         case ReplayDataStorage::ObjectType::kSfx:
-            if (!m_instantReplay)
+            if (m_sfxHandler)
+                m_sfxHandler(obj.sampleIndex, obj.volume);
+            else if (!m_instantReplay)
                 playSfx(obj.sampleIndex, obj.volume);
             break;
 
@@ -32,6 +32,8 @@ void playFullReplay();
 
 FileStatus loadHighlightsFile(const char *path);
 FileStatus loadReplayFile(const char *path);
+FileStatus loadReplayForRendering(const char *path, bool isReplay);
+int renderAllReplayFrames(bool isReplay, std::function<bool()> frameRendered, std::function<void(int, int)> sfxHandler);
 bool saveHighlightsFile(const char *path, bool overwrite = true);
 bool saveReplayFile(const char *path, bool overwrite = true);
 
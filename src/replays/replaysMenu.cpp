@@ -1,6 +1,7 @@
 #include "replaysMenu.h"
 #include "replays.h"
 #include "ReplayDataStorage.h"
+#include "replayFileIndex.h"
 #include "continueMenu.h"
 #include "menuMouse.h"
 #include "selectFilesMenu.h"
@@ -36,7 +37,7 @@ static void playHighlights()
 
 static void selectHighlightToLoad()
 {
-    auto files = findFiles(".hil", kHighlightsDir);
+    auto files = findReplayFilesWithSummaries(".hil", kHighlightsDir);
     auto menuTitle = "LOAD HIGHLIGHTS";
     auto selectedFilename = showSelectFilesMenu(menuTitle, files);
 
@@ -53,7 +54,7 @@ static void selectHighlightToLoad()
 
 static void selectHighlightToSave()
 {
-    auto files = findFiles(".hil", kHighlightsDir);
+    auto files = findReplayFilesWithSummaries(".hil", kHighlightsDir);
     auto menuTitle = "SAVE HIGHLIGHTS";
 
     char hilFilename[kMaxFilenameLength] = {};
@@ -74,7 +75,7 @@ static void playReplay()
 
 static void selectReplayToLoad()
 {
-    auto files = findFiles(".rpl", kReplaysDir);
+    auto files = findReplayFilesWithSummaries(".rpl", kReplaysDir);
     auto menuTitle = "LOAD REPLAY";
     auto selectedFilename = showSelectFilesMenu(menuTitle, files);
 
@@ -91,7 +92,7 @@ static void selectReplayToLoad()
 
 static void selectReplayToSave()
 {
-    auto files = findFiles(".rpl", kReplaysDir);
+    auto files = findReplayFilesWithSummaries(".rpl", kReplaysDir);
     auto menuTitle = "SAVE REPLAYS";
 
     char rplFilename[kMaxFilenameLength] = {};
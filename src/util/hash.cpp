@@ -35,3 +35,95 @@ uint32_t hash(const void *buffer, size_t length)
 
     return hash;
 }
+
+static inline uint64_t rotateLeft64(uint64_t value, int count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+static inline uint64_t read64(const char *p)
+{
+    uint64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const char *p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// xxHash64 (seed 0). Processes 32 bytes per step in four independent lanes, so it's way faster than the
+// byte-at-a-time hash above; meant for hashing large buffers, e.g. audio sample data.
+uint64_t hash64(const void *buffer, size_t length)
+{
+    constexpr uint64_t kPrime1 = 11'400'714'785'074'694'791ull;
+    constexpr uint64_t kPrime2 = 14'029'467'366'897'019'727ull;
+    constexpr uint64_t kPrime3 = 1'609'587'929'392'839'161ull;
+    constexpr uint64_t kPrime4 = 9'650'029'242'287'828'579ull;
+    constexpr uint64_t kPrime5 = 2'870'177'450'012'600'261ull;
+
+    auto round = [](uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotateLeft64(acc, 31);
+        return acc * kPrime1;
+    };
+    auto mergeRound = [&round](uint64_t acc, uint64_t value) {
+        acc ^= round(0, value);
+        return acc * kPrime1 + kPrime4;
+    };
+
+    auto p = reinterpret_cast<const char *>(buffer);
+    auto end = p + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        uint64_t v1 = kPrime1 + kPrime2;
+        uint64_t v2 = kPrime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - kPrime1;
+
+        for (auto limit = end - 32; p <= limit; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+
+        hash = rotateLeft64(v1, 1) + rotateLeft64(v2, 7) + rotateLeft64(v3, 12) + rotateLeft64(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    } else {
+        hash = kPrime5;
+    }
+
+    hash += length;
+
+    for (; p + 8 <= end; p += 8) {
+        hash ^= round(0, read64(p));
+        hash = rotateLeft64(hash, 27) * kPrime1 + kPrime4;
+    }
+
+    if (p + 4 <= end) {
+        hash ^= read32(p) * kPrime1;
+        hash = rotateLeft64(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+
+    for (; p < end; p++) {
+        hash ^= static_cast<uint8_t>(*p) * kPrime5;
+        hash = rotateLeft64(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
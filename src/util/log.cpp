@@ -2,6 +2,7 @@
 #include "util.h"
 # include "file.h"
 # include <sys/stat.h>
+#include <mutex>
 
 #ifdef __ANDROID__
 constexpr const char * const kLogTag = "swos";
@@ -11,6 +12,8 @@ constexpr char kLogFilename[] = "swos.log";
 constexpr char kOldLogFilename[] = "swos.log.old";
 static SDL_RWops *m_logFile;
 static std::string m_logPath;
+static std::ostream *m_consoleStream = &std::cout;
+static std::mutex m_logMutex;   // replay batch modes log from worker threads
 
 void initLog()
 {
@@ -86,11 +89,14 @@ void logv(LogCategory category, const char *format, va_list args)
         buf[len] = '\0';
     }
 
+    std::lock_guard<std::mutex> lock(m_logMutex);
+
     if (!SDL_RWwrite(m_logFile, buf, len, 1))
         SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Writing to log file failed");
 
 #ifndef __ANDROID__
-    std::cout << buf;
+    if (m_consoleStream)
+        *m_consoleStream << buf;
 #endif
 }
 
@@ -98,3 +104,14 @@ std::string logPath()
 {
     return m_logPath;
 }
+
+// Log lines are echoed to the standard output by default; batch modes that use it for data divert them elsewhere.
+// Null stream turns the echo off. Returns the previous stream.
+std::ostream *setLogConsoleStream(std::ostream *stream)
+{
+    std::lock_guard<std::mutex> lock(m_logMutex);
+
+    auto oldStream = m_consoleStream;
+    m_consoleStream = stream;
+    return oldStream;
+}
@@ -27,3 +27,4 @@ void finishLog();
 void log(LogCategory category, const char *format, ...);
 void logv(LogCategory category, const char *format, va_list args);
 std::string logPath();
+std::ostream *setLogConsoleStream(std::ostream *stream);
@@ -3,77 +3,300 @@
 #include <mz.h>
 #include <mz_zip.h>
 #include <mz_strm.h>
-#include <mz_zip_rw.h>
+#include <mz_strm_mem.h>
+#include <mz_crypt.h>
 
-bool traverseZipFile(const char *path, std::function<int(const char *path, int pathLength)> filterEntryFunc,
-    std::function<void(const char *path, int pathLength, char *buffer, int bufferLength)> processEntryFunc)
+ZipArchive::~ZipArchive()
 {
-    auto data = loadFile(path);
-    auto buf = std::unique_ptr<uint8_t[]>(reinterpret_cast<uint8_t *>(data.first));
-    auto bufLen = data.second;
+    close();
+}
 
-    if (!buf) {
+// Loads the zip file and indexes its central directory, without decompressing anything.
+bool ZipArchive::open(const char *path)
+{
+    close();
+
+    auto data = loadFile(path);
+    if (!data.first) {
 #ifdef SWOS_TEST
         // for tests just pretend to succeed even if the file is missing
         return true;
 #endif
-        logWarn("Zip file \"%s\" not found");
+        logWarn("Zip file \"%s\" not found", path);
         return false;
     }
 
+    m_path = path;
+    m_data.reset(reinterpret_cast<uint8_t *>(data.first));
+    m_dataSize = data.second;
+
+    if (!openReader(m_stream, m_zip) || !indexEntries()) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void ZipArchive::close()
+{
+    closeReader(m_stream, m_zip);
+
+    m_data.reset();
+    m_dataSize = 0;
+    m_entries.clear();
+    m_path.clear();
+}
+
+bool ZipArchive::isOpen() const
+{
+    return m_zip != nullptr;
+}
+
+const std::vector<ZipArchive::Entry>& ZipArchive::entries() const
+{
+    return m_entries;
+}
+
+// Decompresses the entry with the given index into a newly allocated buffer, leaving `extraSpace' bytes free at the
+// beginning. Caller takes ownership of the buffer. Returns null buffer in case of failure. Thread safe.
+std::pair<char *, int> ZipArchive::readEntry(int index, int extraSpace /* = 0 */)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return decompressEntry(m_zip, index, extraSpace);
+}
+
+// Decompresses requested entries on multiple threads, each with its own reader over the shared compressed data.
+// Buffers are handed over to the callback (which takes ownership) on the calling thread, in the order of requests.
+// Number of threads defaults to the number of cores. Stops at the first entry that fails to decompress (returning
+// false), or as soon as the callback asks for it.
+bool ZipArchive::readEntries(const std::vector<ReadRequest>& requests, ProcessEntryFunc processEntryFunc,
+    int numThreads /* = 0 */)
+{
+    if (requests.empty())
+        return true;
+
+    if (numThreads <= 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::min(numThreads, static_cast<int>(requests.size()));
+
+    // limit how far ahead of the callbacks decompression can get, so memory use stays bounded
+    const size_t kMaxPending = 4 * numThreads;
+
+    std::vector<std::pair<char *, int>> results(requests.size());
+    std::vector<bool> done(requests.size());
+    size_t nextRequest = 0;
+    size_t numDelivered = 0;
+    bool abort = false;
+
+    std::mutex mutex;
+    std::condition_variable resultReady;
+    std::condition_variable slotFree;
+
+    auto decompressEntries = [&]() {
+        void *stream = nullptr;
+        void *zip = nullptr;
+
+        if (!openReader(stream, zip)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            abort = true;
+            resultReady.notify_all();
+            return;
+        }
+
+        while (true) {
+            size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                slotFree.wait(lock, [&] { return abort || nextRequest - numDelivered < kMaxPending; });
+
+                if (abort || nextRequest >= requests.size())
+                    break;
+
+                i = nextRequest++;
+            }
+
+            auto result = decompressEntry(zip, requests[i].index, requests[i].extraSpace);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[i] = result;
+            done[i] = true;
+            resultReady.notify_all();
+        }
+
+        closeReader(stream, zip);
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < numThreads; i++)
+        workers.emplace_back(decompressEntries);
+
     bool result = true;
-    void *zipReader = nullptr;
-
-    if (mz_zip_reader_create(&zipReader)) {
-        if (mz_zip_reader_open_buffer(zipReader, buf.get(), bufLen, 0) == MZ_OK) {
-            if (mz_zip_reader_goto_first_entry(zipReader) == MZ_OK) {
-                int i = 0;
-                do {
-                    mz_zip_file *fileInfo{};
-                    if (mz_zip_reader_entry_get_info(zipReader, &fileInfo) != MZ_OK) {
-                        logWarn("Unable to get zip file \"%s\" entry %d info", path, i);
-                        result = false;
-                        break;
-                    }
-                    if (mz_zip_reader_entry_is_dir(zipReader) != MZ_OK) {
-                        int extraSpace = filterEntryFunc(fileInfo->filename, fileInfo->filename_size);
-                        if (extraSpace >= 0) {
-                            if (mz_zip_reader_entry_open(zipReader) == MZ_OK) {
-                                int size = static_cast<int>(fileInfo->uncompressed_size) + extraSpace;
-                                auto buffer = new char[size];
-                                int bytesRead = mz_zip_reader_entry_read(zipReader, buffer + extraSpace, size);
-                                if (bytesRead + extraSpace == size) {
-                                    processEntryFunc(fileInfo->filename, fileInfo->filename_size, buffer, size);
-                                } else {
-                                    logWarn("Unable to read zip file \"%s\" entry %d info data (total %d, read %d)",
-                                        path, i, size, bytesRead);
-                                    delete[] buffer;
-                                    result = false;
-                                    break;
-                                }
-                                mz_zip_reader_entry_close(zipReader);
-                            } else {
-                                logWarn("Unable to open zip file \"%s\" entry %d", path, i);
-                                result = false;
-                                break;
-                            }
-                        }
-                    }
-                    i++;
-                } while (mz_zip_reader_goto_next_entry(zipReader) == MZ_OK);
-            } else {
-                logWarn("Unable to go to the first entry for zip file \"%s\"", path);
+
+    for (size_t i = 0; i < requests.size(); i++) {
+        std::pair<char *, int> data;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            resultReady.wait(lock, [&] { return abort || done[i]; });
+
+            if (!done[i]) {
                 result = false;
+                break;
             }
-        } else {
-            logWarn("Unable to open zip buffer for zip file \"%s\"", path);
+
+            data = results[i];
+            results[i] = {};
+            numDelivered = i + 1;
+            slotFree.notify_all();
+        }
+
+        if (!data.first) {
             result = false;
+            break;
         }
-        mz_zip_reader_delete(&zipReader);
-    } else {
-        logWarn("Unable to create zip reader for zip file \"%s\"", path);
-        result = false;
+
+        if (!processEntryFunc(requests[i].index, data.first, data.second))
+            break;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        abort = true;
+        slotFree.notify_all();
     }
 
+    for (auto& worker : workers)
+        worker.join();
+
+    // free whatever got decompressed after a failure or an early stop
+    for (const auto& data : results)
+        delete[] data.first;
+
     return result;
 }
+
+bool ZipArchive::openReader(void *& stream, void *& zip) const
+{
+    if (!mz_stream_mem_create(&stream) || !mz_zip_create(&zip)) {
+        logWarn("Unable to create zip reader for zip file \"%s\"", m_path.c_str());
+        closeReader(stream, zip);
+        return false;
+    }
+
+    mz_stream_mem_set_buffer(stream, m_data.get(), m_dataSize);
+
+    if (mz_stream_open(stream, nullptr, MZ_OPEN_MODE_READ) != MZ_OK || mz_zip_open(zip, stream, MZ_OPEN_MODE_READ) != MZ_OK) {
+        logWarn("Unable to open zip buffer for zip file \"%s\"", m_path.c_str());
+        closeReader(stream, zip);
+        return false;
+    }
+
+    return true;
+}
+
+void ZipArchive::closeReader(void *& stream, void *& zip)
+{
+    if (zip) {
+        mz_zip_close(zip);
+        mz_zip_delete(&zip);
+    }
+    if (stream)
+        mz_stream_mem_delete(&stream);
+}
+
+std::pair<char *, int> ZipArchive::decompressEntry(void *zip, int index, int extraSpace) const
+{
+    assert(index >= 0 && index < static_cast<int>(m_entries.size()) && extraSpace >= 0);
+
+    const auto& entry = m_entries[index];
+
+    if (mz_zip_goto_entry(zip, entry.directoryPos) != MZ_OK || mz_zip_entry_read_open(zip, 0, nullptr) != MZ_OK) {
+        logWarn("Unable to open zip file \"%s\" entry %d", m_path.c_str(), index);
+        return {};
+    }
+
+    int size = entry.size + extraSpace;
+    std::unique_ptr<char[]> buffer(new char[size]);
+
+    int totalRead = 0;
+    while (totalRead < entry.size) {
+        int bytesRead = mz_zip_entry_read(zip, buffer.get() + extraSpace + totalRead, entry.size - totalRead);
+        if (bytesRead <= 0)
+            break;
+        totalRead += bytesRead;
+    }
+
+    // closing verifies the CRC
+    auto closeResult = mz_zip_entry_close(zip);
+
+    if (totalRead != entry.size || closeResult != MZ_OK) {
+        logWarn("Unable to read zip file \"%s\" entry %d data (total %d, read %d)", m_path.c_str(), index,
+            entry.size, totalRead);
+        return {};
+    }
+
+    return { buffer.release(), size };
+}
+
+bool ZipArchive::indexEntries()
+{
+    auto result = mz_zip_goto_first_entry(m_zip);
+    if (result == MZ_END_OF_LIST)
+        return true;
+
+    if (result != MZ_OK) {
+        logWarn("Unable to go to the first entry for zip file \"%s\"", m_path.c_str());
+        return false;
+    }
+
+    int i = 0;
+    do {
+        mz_zip_file *fileInfo{};
+        if (mz_zip_entry_get_info(m_zip, &fileInfo) != MZ_OK) {
+            logWarn("Unable to get zip file \"%s\" entry %d info", m_path.c_str(), i);
+            return false;
+        }
+
+        if (mz_zip_entry_is_dir(m_zip) != MZ_OK) {
+            std::string name(fileInfo->filename, fileInfo->filename_size);
+            auto size = static_cast<int>(fileInfo->uncompressed_size);
+            m_entries.push_back({ std::move(name), fileInfo->crc, size, mz_zip_get_entry(m_zip) });
+        }
+
+        i++;
+    } while (mz_zip_goto_next_entry(m_zip) == MZ_OK);
+
+    return true;
+}
+
+// Same checksum zip entries carry, so loose files can be matched against zipped ones without decompressing them.
+uint32_t zipCrc32(const char *buffer, int length)
+{
+    return mz_crypt_crc32_update(0, reinterpret_cast<const uint8_t *>(buffer), length);
+}
+
+bool traverseZipFile(const char *path, std::function<int(const char *path, int pathLength)> filterEntryFunc,
+    std::function<void(const char *path, int pathLength, char *buffer, int bufferLength)> processEntryFunc)
+{
+    ZipArchive archive;
+    if (!archive.open(path))
+        return false;
+
+    const auto& entries = archive.entries();
+
+    for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+        const auto& entry = entries[i];
+        auto pathLength = static_cast<int>(entry.name.size());
+
+        int extraSpace = filterEntryFunc(entry.name.c_str(), pathLength);
+        if (extraSpace >= 0) {
+            auto data = archive.readEntry(i, extraSpace);
+            if (!data.first)
+                return false;
+
+            processEntryFunc(entry.name.c_str(), pathLength, data.first, data.second);
+        }
+    }
+
+    return true;
+}
@@ -1,4 +1,53 @@
 #pragma once
 
+#include <mutex>
+
+// Zip file kept in memory in compressed form, with its central directory indexed on opening so that entries can be
+// decompressed individually, on demand.
+class ZipArchive
+{
+public:
+    struct Entry {
+        std::string name;
+        uint32_t crc;
+        int size;
+        int64_t directoryPos;
+    };
+    struct ReadRequest {
+        int index;
+        int extraSpace;
+    };
+    // returning false stops reading any further entries
+    using ProcessEntryFunc = std::function<bool(int index, char *buffer, int bufferLength)>;
+
+    ZipArchive() = default;
+    ZipArchive(const ZipArchive&) = delete;
+    ~ZipArchive();
+
+    bool open(const char *path);
+    void close();
+    bool isOpen() const;
+
+    const std::vector<Entry>& entries() const;
+    std::pair<char *, int> readEntry(int index, int extraSpace = 0);
+    bool readEntries(const std::vector<ReadRequest>& requests, ProcessEntryFunc processEntryFunc, int numThreads = 0);
+
+private:
+    bool indexEntries();
+    bool openReader(void *& stream, void *& zip) const;
+    static void closeReader(void *& stream, void *& zip);
+    std::pair<char *, int> decompressEntry(void *zip, int index, int extraSpace) const;
+
+    std::string m_path;
+    std::unique_ptr<uint8_t[]> m_data;
+    int m_dataSize = 0;
+    void *m_stream = nullptr;
+    void *m_zip = nullptr;
+    std::vector<Entry> m_entries;
+    std::mutex m_mutex;
+};
+
+uint32_t zipCrc32(const char *buffer, int length);
+
 bool traverseZipFile(const char *path, std::function<int(const char *path, int pathLength)> filterEntryFunc,
     std::function<void(const char *path, int pathLength, char *buffer, int bufferLength)> processEntryFunc);
@@ -2,6 +2,7 @@
 #include "windowManager.h"
 #include "render.h"
 #include "game.h"
+#include "audioStats.h"
 #include "pitch.h"
 #include "text.h"
 #include "util.h"
@@ -13,6 +14,9 @@ constexpr int kShowZoomInterval = kShowZoomSolid + kFadeZoom;
 constexpr int kInfoX = 290;
 constexpr int kFpsY = 4;
 
+constexpr int kAudioStatsX = 4;
+constexpr int kAudioStatsY = 4;
+
 constexpr Uint32 kInfoMessageInterval = 1'100;
 
 static bool m_showFps;
@@ -23,12 +27,14 @@ static char m_infoBuffer[1024];
 static void showFps();
 static void showZoomFactor();
 static void showInfoMessage();
+static void showAudioStats();
 
 void showOverlay()
 {
     showFps();
     showZoomFactor();
     showInfoMessage();
+    showAudioStats();
 }
 
 bool getShowFps()
@@ -124,3 +130,15 @@ static void showInfoMessage()
     if (m_infoMessageTimestamp + kInfoMessageInterval >= SDL_GetTicks())
         drawTextCentered(kVgaWidth / 2, kVgaHeight / 2 - kSmallFontHeight / 2, m_infoBuffer);
 }
+
+static void showAudioStats()
+{
+    if (getShowAudioStats()) {
+        int y = kAudioStatsY;
+
+        for (const auto& line : getAudioStatsSummary()) {
+            drawText(kAudioStatsX, y, line.c_str());
+            y += kSmallFontHeight + 1;
+        }
+    }
+}
@@ -12,6 +12,7 @@
 #include "util.h"
 
 static SDL_Renderer *m_renderer;
+static SDL_Texture *m_offscreenTarget;
 static Uint32 m_windowPixelFormat;
 
 static bool m_useLinearFiltering = true;
@@ -65,6 +66,9 @@ void finishRendering()
     finishSpriteColorizer();
     finishSprites();
 
+    if (m_offscreenTarget)
+        SDL_DestroyTexture(m_offscreenTarget);
+
     if (m_renderer)
         SDL_DestroyRenderer(m_renderer);
 
@@ -121,6 +125,54 @@ void updateScreen(bool delay /* = false */)
     }
 }
 
+// Redirects all subsequent rendering into an offscreen texture of the given size, hiding the window.
+// Used in batch mode, where frames are fetched with readOffscreenFrame() and never presented.
+bool setOffscreenRenderTarget(int width, int height)
+{
+    assert(m_renderer && !m_offscreenTarget);
+
+    if (!SDL_RenderTargetSupported(m_renderer)) {
+        logWarn("Renderer does not support render targets");
+        return false;
+    }
+
+    m_offscreenTarget = SDL_CreateTexture(m_renderer, kOffscreenPixelFormat, SDL_TEXTUREACCESS_TARGET, width, height);
+    if (!m_offscreenTarget) {
+        logWarn("Failed to create %dx%d offscreen render target: %s", width, height, SDL_GetError());
+        return false;
+    }
+
+    if (SDL_SetRenderTarget(m_renderer, m_offscreenTarget) < 0) {
+        logWarn("Failed to switch to offscreen render target: %s", SDL_GetError());
+        SDL_DestroyTexture(m_offscreenTarget);
+        m_offscreenTarget = nullptr;
+        return false;
+    }
+
+    if (auto window = SDL_RenderGetWindow(m_renderer))
+        SDL_HideWindow(window);
+
+    return true;
+}
+
+// Copies the frame rendered so far into the given buffer (in kOffscreenPixelFormat) and clears the target,
+// taking place of updateScreen() when running offscreen.
+bool readOffscreenFrame(void *pixels, int pitch)
+{
+    assert(m_offscreenTarget);
+
+    SDL_RenderFlush(m_renderer);
+
+    bool result = SDL_RenderReadPixels(m_renderer, nullptr, kOffscreenPixelFormat, pixels, pitch) == 0;
+    if (!result)
+        logWarn("Failed to read offscreen frame: %s", SDL_GetError());
+
+    SDL_SetRenderDrawColor(m_renderer, 0, 0, 0, 255);
+    SDL_RenderClear(m_renderer);
+
+    return result;
+}
+
 void fadeIn(std::function<void()> render)
 {
     fade(false, render);
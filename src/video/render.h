@@ -4,6 +4,9 @@ constexpr int kVgaWidth = 320;
 constexpr int kVgaHeight = 200;
 constexpr int kVgaScreenSize = kVgaWidth * kVgaHeight;
 
+// R, G, B, A byte order in memory
+constexpr Uint32 kOffscreenPixelFormat = SDL_PIXELFORMAT_RGBA32;
+
 struct Color;
 
 void initRendering();
@@ -11,6 +14,8 @@ void finishRendering();
 SDL_Renderer *getRenderer();
 SDL_Rect getViewport();
 void updateScreen(bool delay = false);
+bool setOffscreenRenderTarget(int width, int height);
+bool readOffscreenFrame(void *pixels, int pitch);
 
 void fadeIn(std::function<void()> render);
 void fadeOut(std::function<void()> render);
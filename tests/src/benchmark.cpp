@@ -0,0 +1,174 @@
+#include "benchmark.h"
+#include "util.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+using Clock = std::chrono::steady_clock;
+
+struct RecordingTimes {
+    RecordingTimes(const std::string& name) : name(name) {}
+    std::string name;
+    std::vector<int64_t> frameTimes;    // in nanoseconds
+};
+
+struct Stats {
+    size_t numFrames = 0;
+    double totalMs = 0;
+    double framesPerSecond = 0;
+    double minUs = 0;
+    double medianUs = 0;
+    double p99Us = 0;
+};
+
+static bool m_enabled;
+static std::string m_outputPath;
+static std::vector<RecordingTimes> m_recordings;
+static Clock::time_point m_frameStartTime;
+static bool m_frameStarted;
+
+void enableBenchmark(const char *outputPath)
+{
+    m_enabled = true;
+    m_outputPath = outputPath ? outputPath : "";
+}
+
+bool benchmarkEnabled()
+{
+    return m_enabled;
+}
+
+void startBenchmarkRecording(const std::string& name)
+{
+    if (m_enabled) {
+        m_recordings.emplace_back(name);
+        m_frameStarted = false;
+    }
+}
+
+void markBenchmarkFrameStart()
+{
+    if (m_enabled) {
+        m_frameStartTime = Clock::now();
+        m_frameStarted = true;
+    }
+}
+
+// Last frame of the game never gets here, the loop breaks out before the end hook.
+void markBenchmarkFrameEnd()
+{
+    if (m_enabled && m_frameStarted) {
+        auto frameTime = Clock::now() - m_frameStartTime;
+        assert(!m_recordings.empty());
+        m_recordings.back().frameTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(frameTime).count());
+        m_frameStarted = false;
+    }
+}
+
+static Stats calculateStats(std::vector<int64_t> frameTimes)
+{
+    Stats stats;
+
+    if (frameTimes.empty())
+        return stats;
+
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    // nearest rank percentile
+    auto percentile = [&frameTimes](int p) {
+        auto rank = (p * frameTimes.size() + 99) / 100;
+        return frameTimes[std::max<size_t>(rank, 1) - 1] / 1'000.0;
+    };
+
+    auto totalNs = std::accumulate(frameTimes.begin(), frameTimes.end(), 0ll);
+
+    stats.numFrames = frameTimes.size();
+    stats.totalMs = totalNs / 1'000'000.0;
+    stats.framesPerSecond = totalNs ? frameTimes.size() * 1e9 / totalNs : 0;
+    stats.minUs = frameTimes.front() / 1'000.0;
+    stats.medianUs = percentile(50);
+    stats.p99Us = percentile(99);
+
+    return stats;
+}
+
+static void outputStats(std::ostream& out, const char *name, const Stats& stats)
+{
+    out << "  " << std::left << std::setw(32) << name << std::right << std::setw(8) << stats.numFrames << " frames" <<
+        std::setw(12) << static_cast<int64_t>(stats.framesPerSecond) << " fps   min " << std::setw(8) << stats.minUs <<
+        "us   median " << std::setw(8) << stats.medianUs << "us   p99 " << std::setw(8) << stats.p99Us << "us\n";
+}
+
+static std::string escapeJsonString(const std::string& str)
+{
+    std::string result;
+
+    for (auto c : str) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+
+    return result;
+}
+
+static void outputJsonStats(std::ostream& out, const Stats& stats)
+{
+    out << "\"frames\": " << stats.numFrames << ", \"totalMs\": " << stats.totalMs << ", \"fps\": " <<
+        stats.framesPerSecond << ", \"minUs\": " << stats.minUs << ", \"medianUs\": " << stats.medianUs <<
+        ", \"p99Us\": " << stats.p99Us;
+}
+
+static void writeJsonReport(const Stats& totalStats, const std::vector<Stats>& recordingStats)
+{
+    std::ofstream out(m_outputPath);
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\n  ";
+    outputJsonStats(out, totalStats);
+    out << ",\n  \"recordings\": [\n";
+
+    for (size_t i = 0; i < m_recordings.size(); i++) {
+        out << "    { \"name\": \"" << escapeJsonString(m_recordings[i].name) << "\", ";
+        outputJsonStats(out, recordingStats[i]);
+        out << " }" << (i + 1 < m_recordings.size() ? "," : "") << '\n';
+    }
+
+    out << "  ]\n}\n";
+
+    if (!out)
+        std::cerr << "Failed to write benchmark results to " << m_outputPath << '\n';
+}
+
+// Frame times are summed instead of taking the wall clock, so reading and verifying the recordings doesn't count.
+void showBenchmarkReport()
+{
+    assert(m_enabled);
+
+    std::vector<int64_t> allFrameTimes;
+    std::vector<Stats> recordingStats;
+
+    for (const auto& recording : m_recordings) {
+        allFrameTimes.insert(allFrameTimes.end(), recording.frameTimes.begin(), recording.frameTimes.end());
+        recordingStats.push_back(calculateStats(recording.frameTimes));
+    }
+
+    auto totalStats = calculateStats(allFrameTimes);
+
+    if (!totalStats.numFrames) {
+        std::cout << "\nNo frames were simulated, nothing to report.\n";
+        return;
+    }
+
+    std::cout << "\nBenchmark results:\n" << std::fixed << std::setprecision(1);
+
+    for (size_t i = 0; i < m_recordings.size(); i++)
+        outputStats(std::cout, m_recordings[i].name.c_str(), recordingStats[i]);
+
+    outputStats(std::cout, "total", totalStats);
+    std::cout << "Simulated " << formatNumberWithCommas(totalStats.numFrames) << " frames in " <<
+        formatNumberWithCommas(static_cast<int64_t>(totalStats.totalMs)) << "ms.\n";
+
+    if (!m_outputPath.empty())
+        writeJsonReport(totalStats, recordingStats);
+}
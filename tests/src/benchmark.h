@@ -0,0 +1,10 @@
+#pragma once
+
+// Timing of recorded games replays (--benchmark). Only the game loop itself is measured, from the moment the
+// recorded input for the frame is in, up to the verification of the results, which is left out.
+void enableBenchmark(const char *outputPath);
+bool benchmarkEnabled();
+void startBenchmarkRecording(const std::string& name);
+void markBenchmarkFrameStart();
+void markBenchmarkFrameEnd();
+void showBenchmarkReport();
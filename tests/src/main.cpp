@@ -2,11 +2,13 @@
 #include "BaseTest.h"
 #include "testEnvironment.h"
 #include "file.h"
+#include "benchmark.h"
 #include <iostream>
 #undef pop
 #include <filesystem>
 
 static const char kSnapshotDir[] = "snapshots";
+static const char kBenchmarkTest[] = "verify-rec-data";
 
 static BaseTest::TestOptions m_testOptions;
 
@@ -15,6 +17,10 @@ const char kCreateSnapshots[] = "create-snapshots";
 const char kPassOnExceptions[] = "pass-on-exceptions";
 const char kExitOnFirstFail[] = "exit-on-first-fail";
 const char kTimeout[] = "timeout=";
+const char kJobs[] = "jobs=";
+const char kBenchmark[] = "benchmark";
+const char kWorker[] = "worker=";
+const char kWorkerResults[] = "worker-results=";
 
 static void printHelpAndExit()
 {
@@ -26,13 +32,34 @@ static void printHelpAndExit()
     std::cout << "--" << kPassOnExceptions << "     - pass on exceptions to the debugger\n";
     std::cout << "--" << kExitOnFirstFail << "     - do not run all tests, exit after first fail\n";
     std::cout << "--" << kTimeout << "<int>          - set maximum allowed time for test to run (default: 5s)\n";
+    std::cout << "--" << kJobs << "<int>             - run tests in that many processes in parallel (0 = one per core)\n";
+    std::cout << "--" << kBenchmark << "[=<file>]     - time recorded games replays, optionally writing JSON results\n";
     std::cout << "\nOnly specified test(s) will be run, in case none are given everything will be tested.\n";
     std::exit(EXIT_SUCCESS);
 }
 
+static void unknownOptionExit(const char *option)
+{
+    std::cerr << "Unknown option: --" << option << "\nUse --help to see the list of supported options.\n";
+    std::exit(EXIT_FAILURE);
+}
+
+// Accepts only "benchmark" and "benchmark=<file>".
+static bool isBenchmarkOption(const char *option)
+{
+    constexpr auto kLength = sizeof(kBenchmark) - 1;
+    return !strncmp(option, kBenchmark, kLength) && (option[kLength] == '\0' || option[kLength] == '=');
+}
+
 static void parseCommandLine(int argc, char **argv)
 {
+    m_testOptions.executablePath = argv[0];
+
     while (argv++, --argc) {
+        // workers get the same command line, minus the job count
+        if (strstr(*argv, "--") != *argv || strstr(*argv + 2, kJobs) != *argv + 2)
+            m_testOptions.workerArgs.push_back(*argv);
+
         if (strstr(*argv, "--") != *argv) {
             if (strstr(*argv, "/?") == *argv)
                 printHelpAndExit();
@@ -51,9 +78,35 @@ static void parseCommandLine(int argc, char **argv)
                 m_testOptions.firstFailExits = true;
             else if (strstr(*argv, kTimeout) == *argv)
                 m_testOptions.timeout = atoi(*argv + sizeof(kTimeout) - 1);
+            else if (strstr(*argv, kJobs) == *argv)
+                m_testOptions.numJobs = atoi(*argv + sizeof(kJobs) - 1);
+            else if (isBenchmarkOption(*argv))
+                enableBenchmark((*argv)[sizeof(kBenchmark) - 1] == '=' ? *argv + sizeof(kBenchmark) : nullptr);
+            else if (strstr(*argv, kWorker) == *argv)
+                sscanf(*argv + sizeof(kWorker) - 1, "%d/%d", &m_testOptions.workerIndex, &m_testOptions.numJobs);
+            else if (strstr(*argv, kWorkerResults) == *argv)
+                m_testOptions.workerResultsPath = *argv + sizeof(kWorkerResults) - 1;
+            else
+                unknownOptionExit(*argv);
         }
     }
 
+    // only the replays are timed, and all in one process so they don't compete for the CPU
+    if (benchmarkEnabled()) {
+        if (m_testOptions.testsToRun.empty())
+            m_testOptions.testsToRun.push_back(kBenchmarkTest);
+        m_testOptions.numJobs = 1;
+    }
+
+    if (m_testOptions.numJobs <= 0)
+        m_testOptions.numJobs = std::max(1u, std::thread::hardware_concurrency());
+
+    if (m_testOptions.workerIndex >= 0 && (!m_testOptions.workerResultsPath ||
+        m_testOptions.workerIndex >= m_testOptions.numJobs)) {
+        std::cerr << "Invalid worker parameters!\n";
+        std::exit(EXIT_FAILURE);
+    }
+
     m_testOptions.snapshotsDir = kSnapshotDir;
 }
 
@@ -84,5 +137,10 @@ int main(int argc, char **argv)
 
     initializeTestEnvironment();
 
-    return BaseTest::runTests(m_testOptions);
+    auto result = BaseTest::runTests(m_testOptions);
+
+    if (benchmarkEnabled())
+        showBenchmarkReport();
+
+    return result;
 }
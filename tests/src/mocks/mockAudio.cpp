@@ -10,8 +10,8 @@ void initAudio() {}
 void stopAudio() {}
 void finishAudio() {}
 void initGameAudio() {}
-void resetGameAudio() {}
-void ensureMenuAudioFrequency() {}
+void startSamplePredecoding() {}
+void stopSamplePredecoding() {}
 
 bool soundEnabled()
 {
@@ -3,19 +3,39 @@
 #include "unitTest.h"
 
 static bool m_strictLogMode = true; // catch-all by default
+static std::ostream *m_consoleStream;   // silent unless a test wants to see what would reach the console
 
 void initLog() {}
 void finishLog() {}
 std::string logPath() { return {}; }
 
-void log(LogCategory category, const char *, ...)
+void log(LogCategory category, const char *format, ...)
 {
     assertTrue(!m_strictLogMode || category == kInfo);
+
+    va_list args;
+
+    va_start(args, format);
+    logv(category, format, args);
+    va_end(args);
 }
 
-void logv(LogCategory category, const char *, va_list)
+void logv(LogCategory category, const char *format, va_list args)
 {
     assertTrue(!m_strictLogMode || category == kInfo);
+
+    if (m_consoleStream) {
+        char buf[1024];
+        vsnprintf(buf, sizeof(buf), format, args);
+        *m_consoleStream << buf << '\n';
+    }
+}
+
+std::ostream *setLogConsoleStream(std::ostream *stream)
+{
+    auto oldStream = m_consoleStream;
+    m_consoleStream = stream;
+    return oldStream;
 }
 
 bool setStrictLogMode(bool active)
@@ -79,6 +79,14 @@ SDL_Rect getViewport()
     return rect;
 }
 
+bool setOffscreenRenderTarget(int, int) { return true; }
+
+bool readOffscreenFrame(void *pixels, int pitch)
+{
+    memset(pixels, 0, pitch * getWindowSize().second);
+    return true;
+}
+
 void skipFrameUpdate() {}
 void gameFrameDelay(double) {}
 void fadeIfNeeded() {}
@@ -69,6 +69,11 @@ int Mix_PlayChannelTimed(int channel, Mix_Chunk *chunk, int loops, int ticks)
     return channel;
 }
 
+int Mix_RegisterEffect(int, Mix_EffectFunc_t, Mix_EffectDone_t, void *)
+{
+    return 1;
+}
+
 int Mix_Playing(int channel)
 {
     if (channel >= 0 && channel < static_cast<int>(m_channels.size())) {
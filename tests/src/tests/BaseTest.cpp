@@ -9,6 +9,8 @@
 #include "mockLog.h"
 #include <iomanip>
 #include <chrono>
+#include <fstream>
+#include <filesystem>
 
 std::vector<BaseTest *> BaseTest::m_tests;
 std::condition_variable BaseTest::m_condition;
@@ -30,11 +32,244 @@ int BaseTest::runTests(const TestOptions& options)
 
     auto startTime = std::chrono::high_resolution_clock::now();
 
-    auto [numTestsRan, failures] = runTestsWithTimeoutCheck(options, testsToRun);
+    if (options.workerIndex >= 0) {
+        auto results = runTestsWithTimeoutCheck(options, testsToRun);
+        writeWorkerResults(options.workerResultsPath, results);
+        return results.second.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // no point in splitting if we're being debugged, the debugger would only see the parent
+    bool useWorkers = options.numJobs > 1 && !options.passOnExceptions && !isDebuggerPresent();
+
+    bool allWorkersFinished = true;
+    auto [numTestsRan, failures] = useWorkers ? runTestsInWorkers(options, allWorkersFinished) :
+        runTestsWithTimeoutCheck(options, testsToRun);
 
     showReport(numTestsRan, failures, startTime);
 
-    return failures.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+    return failures.empty() && allWorkersFinished ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Each worker is a separate instance of this executable, running with the same command line plus its worker
+// index, so it gets its own VM, memory and watchdog, and a crash or timeout takes down only its share of cases.
+// Workers write their results to a temporary file which we merge back in the same order a sequential run would
+// report them. Snapshots need no merging, every case writes to its own file.
+auto BaseTest::runTestsInWorkers(const TestOptions& options, bool& allWorkersFinished) -> TestResults
+{
+    auto tempDir = std::filesystem::temp_directory_path();
+    auto runId = std::to_string(getCurrentTicks());
+
+    std::vector<std::string> resultsPaths;
+    for (int i = 0; i < options.numJobs; i++) {
+        auto filename = "swos-tests-" + runId + '-' + std::to_string(i) + ".txt";
+        resultsPaths.push_back((tempDir / filename).string());
+    }
+
+    std::cout << "Running tests in " << options.numJobs << " worker processes\n";
+
+    std::vector<int> exitCodes(options.numJobs);
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < options.numJobs; i++)
+        workers.emplace_back([&, i] { exitCodes[i] = runWorker(options, i, resultsPaths[i]); });
+
+    for (auto& worker : workers)
+        worker.join();
+
+    TestResults results;
+    results.first = 0;
+
+    for (int i = 0; i < options.numJobs; i++) {
+        if (!readWorkerResults(resultsPaths[i], results)) {
+            std::cerr << "\nWorker " << i << " did not finish (exit code " << exitCodes[i] << ")!\n";
+            allWorkersFinished = false;
+        }
+
+        std::error_code error;
+        std::filesystem::remove(resultsPaths[i], error);
+    }
+
+    sortFailures(results.second);
+
+    return results;
+}
+
+// Quotes a command line argument so that it gets parsed back unchanged by the MSVC runtime: backslashes are only
+// special in front of a quote, where they have to be doubled, and embedded quotes are escaped with a backslash.
+static std::string quoteArgument(const std::string& str)
+{
+    std::string result = "\"";
+    size_t numBackslashes = 0;
+
+    for (auto c : str) {
+        if (c == '\\') {
+            numBackslashes++;
+        } else {
+            if (c == '"')
+                result.append(numBackslashes + 1, '\\');
+            numBackslashes = 0;
+        }
+        result += c;
+    }
+
+    // trailing backslashes would escape the closing quote
+    result.append(numBackslashes, '\\');
+    result += '"';
+
+    return result;
+}
+
+int BaseTest::runWorker(const TestOptions& options, int workerIndex, const std::string& resultsPath)
+{
+    auto command = quoteArgument(options.executablePath);
+
+    for (const auto& arg : options.workerArgs)
+        command += ' ' + quoteArgument(arg);
+
+    command += " --worker=" + std::to_string(workerIndex) + '/' + std::to_string(options.numJobs);
+    command += " --worker-results=" + quoteArgument(resultsPath);
+
+#ifdef _WIN32
+    // cmd.exe strips the outermost quotes if there's more than one pair
+    command = '"' + command + '"';
+#endif
+
+    return std::system(command.c_str());
+}
+
+static std::string escapeResultField(const std::string& str)
+{
+    std::string result;
+
+    for (auto c : str) {
+        switch (c) {
+        case '\\': result += "\\\\"; break;
+        case '\n': result += "\\n"; break;
+        case '\t': result += "\\t"; break;
+        default: result += c;
+        }
+    }
+
+    return result;
+}
+
+static std::string unescapeResultField(const std::string& str)
+{
+    std::string result;
+
+    for (size_t i = 0; i < str.size(); i++) {
+        if (str[i] == '\\' && i + 1 < str.size()) {
+            auto c = str[++i];
+            result += c == 'n' ? '\n' : c == 't' ? '\t' : c;
+        } else {
+            result += str[i];
+        }
+    }
+
+    return result;
+}
+
+// Number of tests ran, followed by a line per failure (test name, data index, case name and error, tab
+// separated), terminated with a line saying "end" so the parent can tell a finished worker from a dead one.
+void BaseTest::writeWorkerResults(const char *path, const TestResults& results)
+{
+    assert(path);
+
+    std::ofstream out(path);
+    out << results.first << '\n';
+
+    for (const auto& testFailures : results.second)
+        for (const auto& failure : testFailures.failures)
+            out << testFailures.test->name() << '\t' << failure.dataIndex << '\t' <<
+                escapeResultField(failure.testCaseName) << '\t' << escapeResultField(failure.error) << '\n';
+
+    out << "end\n";
+
+    if (!out)
+        std::cerr << "Failed to write results to " << path << '\n';
+}
+
+bool BaseTest::readWorkerResults(const std::string& path, TestResults& results)
+{
+    std::ifstream in(path);
+    std::string line;
+
+    if (!std::getline(in, line))
+        return false;
+
+    int numTestsRan = atoi(line.c_str());
+
+    while (std::getline(in, line)) {
+        if (line == "end") {
+            results.first += numTestsRan;
+            return true;
+        }
+
+        auto dataIndexStart = line.find('\t');
+        auto caseNameStart = line.find('\t', dataIndexStart + 1);
+        auto errorStart = line.find('\t', caseNameStart + 1);
+        if (errorStart == std::string::npos)
+            return false;
+
+        auto testName = line.substr(0, dataIndexStart);
+        auto test = std::find_if(m_tests.begin(), m_tests.end(), [&testName](const auto candidate) {
+            return testName == candidate->name();
+        });
+        if (test == m_tests.end())
+            return false;
+
+        size_t dataIndex = atoi(line.c_str() + dataIndexStart + 1);
+        auto caseName = unescapeResultField(line.substr(caseNameStart + 1, errorStart - caseNameStart - 1));
+        auto error = unescapeResultField(line.substr(errorStart + 1));
+
+        results.second.emplace_back(*test, caseName, dataIndex, error);
+    }
+
+    return false;
+}
+
+// Put failures collected from the workers in the order of tests and their cases, grouped by test.
+void BaseTest::sortFailures(FailureList& failures)
+{
+    struct SortedFailure {
+        size_t testIndex;
+        size_t caseIndex;
+        BaseTest *test;
+        const Failure *failure;
+    };
+
+    std::vector<SortedFailure> sortedFailures;
+
+    for (const auto& testFailures : failures) {
+        auto test = testFailures.test;
+        auto testIndex = std::find(m_tests.begin(), m_tests.end(), test) - m_tests.begin();
+        const auto cases = test->getCases();
+
+        for (const auto& failure : testFailures.failures) {
+            auto testCase = std::find_if(cases.begin(), cases.end(), [&failure](const auto& testCase) {
+                return failure.testCaseName == testCase.name;
+            });
+            sortedFailures.push_back({ static_cast<size_t>(testIndex), static_cast<size_t>(testCase - cases.begin()),
+                test, &failure });
+        }
+    }
+
+    std::stable_sort(sortedFailures.begin(), sortedFailures.end(), [](const auto& f1, const auto& f2) {
+        return std::tie(f1.testIndex, f1.caseIndex, f1.failure->dataIndex) <
+            std::tie(f2.testIndex, f2.caseIndex, f2.failure->dataIndex);
+    });
+
+    FailureList result;
+
+    for (const auto& sortedFailure : sortedFailures) {
+        const auto& failure = *sortedFailure.failure;
+        if (!result.empty() && result.back().test == sortedFailure.test)
+            result.back().failures.push_back(failure);
+        else
+            result.emplace_back(sortedFailure.test, failure.testCaseName, failure.dataIndex, failure.error);
+    }
+
+    failures = std::move(result);
 }
 
 auto BaseTest::runTestsWithTimeoutCheck(const TestOptions& options, const TestNamesSet& testList) -> TestResults
@@ -54,25 +289,24 @@ auto BaseTest::runTestsWithTimeoutCheck(const TestOptions& options, const TestNa
     return result;
 }
 
-auto BaseTest::doRunTests(const TestOptions &options, const TestNamesSet& testList) -> std::pair<int, FailureList>
+// Goes through the instances of all the cases selected by the test list (each data index of a case is an instance),
+// numbering them in the order they run. Stops when the callback returns false.
+template <typename F>
+void BaseTest::forEachCaseInstance(const TestNamesSet& testList, F f)
 {
-    FailureList failures;
-    int numTestsRan = 0;
-
     // wait for C++20 ;)
     auto testListContains = [&testList](const char *name) {
         return testList.find(name) != testList.end();
     };
 
+    size_t caseNo = 0;
+
     for (size_t i = 0; i < m_tests.size(); i++) {
         auto test = m_tests[i];
 
         if (!testListContains(test->name()))
             continue;
 
-        std::cout << "Running " << test->displayName() << " tests [" << test->name() << "]\n";
-        test->init();
-
         const auto cases = test->getCases();
         assert(!cases.empty());
 
@@ -81,30 +315,94 @@ auto BaseTest::doRunTests(const TestOptions &options, const TestNamesSet& testLi
             if (!testListContains(testCase.id) && !testListContains(testCase.name))
                 continue;
 
-            for (auto& k = test->m_currentDataIndex = 0; k < testCase.numTests; k++) {
-                auto addFailureMessage = [test, &failures, &testCase, &k](const std::string& errorMessage) {
-                    if (!failures.empty() && failures.back().test == test)
-                        failures.back().failures.emplace_back(testCase.name, k, errorMessage);
-                    else
-                        failures.emplace_back(test, testCase.name, k, errorMessage);
-                };
+            for (size_t k = 0; k < testCase.numTests; k++)
+                if (!f(test, i, testCase, j, k, caseNo++))
+                    return;
+        }
+    }
+}
+
+auto BaseTest::doRunTests(const TestOptions &options, const TestNamesSet& testList) -> std::pair<int, FailureList>
+{
+    FailureList failures;
+    int numTestsRan = 0;
+    BaseTest *currentTest = nullptr;
+
+    auto finishCurrentTest = [&options, &currentTest]() {
+        if (currentTest) {
+            currentTest->finish();
+            if (options.workerIndex < 0)
+                std::cout << '\n';
+            currentTest = nullptr;
+        }
+    };
 
-                packCurrentTest(i, j, k);
-                numTestsRan++;
-                runTestCase(test, testCase, k, options, addFailureMessage);
+    bool stopped = false;
 
-                if (options.firstFailExits && !failures.empty())
-                    return { numTestsRan, failures };
-            }
+    forEachCaseInstance(testList, [&](BaseTest *test, size_t i, const Case& testCase, size_t j, size_t k, size_t caseNo) {
+        if (!isAssignedToThisProcess(options, caseNo))
+            return true;
+
+        // tests only get initialized if some of their cases are assigned to us
+        if (test != currentTest) {
+            finishCurrentTest();
+
+            // workers only show progress, headers from several processes would be all mixed up
+            if (options.workerIndex < 0)
+                std::cout << "Running " << test->displayName() << " tests [" << test->name() << "]\n";
+            test->init();
+            currentTest = test;
         }
 
-        test->finish();
-        std::cout << '\n';
-    }
+        auto addFailureMessage = [test, &failures, &testCase, k](const std::string& errorMessage) {
+            if (!failures.empty() && failures.back().test == test)
+                failures.back().failures.emplace_back(testCase.name, k, errorMessage);
+            else
+                failures.emplace_back(test, testCase.name, k, errorMessage);
+        };
+
+        test->m_currentDataIndex = k;
+        packCurrentTest(i, j, k);
+        numTestsRan++;
+        runTestCase(test, testCase, k, options, addFailureMessage);
+
+        stopped = options.firstFailExits && !failures.empty();
+        return !stopped;
+    });
+
+    if (!stopped)
+        finishCurrentTest();
 
     return { numTestsRan, failures };
 }
 
+// Case instances are dealt out to the workers round-robin, neighbouring ones tend to be of similar weight.
+// Going by instance instead of by case spreads the data of a single heavy case (like the recorded games).
+int BaseTest::getWorkerIndex(const TestOptions& options, size_t caseNo)
+{
+    return static_cast<int>(caseNo % options.numJobs);
+}
+
+bool BaseTest::isAssignedToThisProcess(const TestOptions& options, size_t caseNo)
+{
+    return options.workerIndex < 0 || getWorkerIndex(options, caseNo) == options.workerIndex;
+}
+
+// Returns the index of the worker that would run each instance of the given case.
+std::vector<int> BaseTest::getCaseWorkers(const TestOptions& options, const char *caseId)
+{
+    std::vector<int> workers;
+
+    const auto& testList = validateTestNames(options.testsToRun);
+    forEachCaseInstance(testList, [&](BaseTest *, size_t, const Case& testCase, size_t, size_t, size_t caseNo) {
+        if (!strcmp(testCase.id, caseId))
+            workers.push_back(getWorkerIndex(options, caseNo));
+        return true;
+    });
+
+    return workers;
+}
+
 void BaseTest::timeoutCheck(int timeout)
 {
     constexpr int kTestTimeoutMs = 6'000;
@@ -12,6 +12,11 @@ public:
         bool passOnExceptions = false;
         bool firstFailExits = false;
         int timeout = 5'000;
+        int numJobs = 1;                        // more than one spreads the cases over that many worker processes
+        int workerIndex = -1;                   // set only in worker processes
+        const char *workerResultsPath = nullptr;
+        std::string executablePath;
+        std::vector<std::string> workerArgs;    // command line that gets passed on to the workers
     };
 
     BaseTest();
@@ -35,7 +40,7 @@ protected:
     virtual void defaultCaseInit() = 0;     // use this to initialize the case if it doesn't provide its own function
     virtual const char *name() const = 0;
     virtual const char *displayName() const = 0;
-    virtual CaseList getCases() = 0;
+    virtual CaseList getCases() = 0;        // mustn't depend on init(), workers only initialize the tests they run
 
     template <typename T>
     const CaseProc bind(void (T::*f)())
@@ -43,6 +48,8 @@ protected:
         return std::bind(f, static_cast<T *>(this));
     }
 
+    static std::vector<int> getCaseWorkers(const TestOptions& options, const char *caseId);
+
     size_t m_currentDataIndex = 0;
 
 private:
@@ -65,8 +72,17 @@ private:
     using TestNamesList = std::vector<std::string>;
     using TestResults = std::pair<int, FailureList>;
 
+    static TestResults runTestsInWorkers(const TestOptions& options, bool& allWorkersFinished);
+    static int runWorker(const TestOptions& options, int workerIndex, const std::string& resultsPath);
+    static bool readWorkerResults(const std::string& path, TestResults& results);
+    static void writeWorkerResults(const char *path, const TestResults& results);
+    static void sortFailures(FailureList& failures);
     static TestResults runTestsWithTimeoutCheck(const TestOptions& options, const TestNamesSet& testList);
     static TestResults doRunTests(const TestOptions& options, const TestNamesSet& testList);
+    template <typename F>
+    static void forEachCaseInstance(const TestNamesSet& testList, F f);
+    static int getWorkerIndex(const TestOptions& options, size_t caseNo);
+    static bool isAssignedToThisProcess(const TestOptions& options, size_t caseNo);
     static void timeoutCheck(int timeout);
     static TestNamesSet validateTestNames(const TestNamesList& testNames);
     static TestNamesSet includeAllTests();
@@ -7,6 +7,8 @@
 #include "mockFile.h"
 #include "resData.h"
 #include "wavFormat.h"
+#include "SoundSample.h"
+#include "zip.h"
 #include "mockSdlMixer.h"
 #include "mockUtil.h"
 #include "mockLog.h"
@@ -75,6 +77,15 @@ auto CommentaryTest::getCases() -> CaseList
         { "test zip file comments", "zip-file-comments",
             bind(&CommentaryTest::setupZipFileCommentsTest), bind(&CommentaryTest::testZipFileComments), 1, false,
             bind(&CommentaryTest::finishZipFileCommentsTest) },
+        { "test unloading zipped comments", "zipped-comments-unloading",
+            bind(&CommentaryTest::setupZippedCommentsUnloadingTest), bind(&CommentaryTest::testZippedCommentsUnloading),
+            1, false, bind(&CommentaryTest::finishZippedCommentsUnloadingTest) },
+        { "test prefetching zipped comments", "zipped-comments-prefetching",
+            bind(&CommentaryTest::setupZipFileCommentsTest), bind(&CommentaryTest::testZippedCommentsPrefetching),
+            1, false, bind(&CommentaryTest::finishZippedCommentsUnloadingTest) },
+        { "benchmark loading a large commentary pack", "large-commentary-pack-loading",
+            bind(&CommentaryTest::setupLargeCommentaryPackTest), bind(&CommentaryTest::testLargeCommentaryPackLoading),
+            1, false, bind(&CommentaryTest::finishLargeCommentaryPackTest) },
     };
 }
 
@@ -718,6 +729,7 @@ void CommentaryTest::testZipFileComments()
     }
 
     testRawFileFromZip();
+    testLooseAndZippedSampleEquality();
 }
 
 void CommentaryTest::testRawFileFromZip()
@@ -734,6 +746,100 @@ void CommentaryTest::testRawFileFromZip()
     assertTrue(!memcmp(chunk->abuf + sizeof(kWaveHeader), "Telegraph Road", 14));
 }
 
+void CommentaryTest::testLooseAndZippedSampleEquality()
+{
+    ZipArchive archive;
+    assertTrue(archive.open("audio\\commentary.zip"));
+
+    const auto& entries = archive.entries();
+    auto findEntry = [&entries](const char *name) {
+        auto it = std::find_if(entries.begin(), entries.end(), [name](const auto& entry) { return entry.name == name; });
+        assert(it != entries.end());
+        return static_cast<int>(it - entries.begin());
+    };
+
+    SoundSample zipped("red_card/red_card1.wav", archive, findEntry("red_card/red_card1.wav"));
+    SoundSample zippedOther("red_card/red_card3.wav", archive, findEntry("red_card/red_card3.wav"));
+
+    addFakeFile({ "audio\\commentary\\red_card\\red_card.wav", "red_card", 8 });
+    SoundSample loose("audio\\commentary\\red_card\\red_card.wav");
+
+    // same CRC and size as "red_card", but different content
+    addFakeFile({ "audio\\commentary\\red_card\\blue_card.wav", "blue\xd1\xf7o\xae", 8 });
+    SoundSample forged("audio\\commentary\\red_card\\blue_card.wav");
+
+    // a loose copy of a zipped comment must hash and compare the same, without the zipped one getting decoded
+    assertEqual(loose.contentHash(), zipped.contentHash());
+    assertTrue(loose == zipped);
+    assertTrue(zipped == loose);
+    assertFalse(loose == zippedOther);
+    assertFalse(zipped.isChunkLoaded());
+
+    // matching CRC mustn't be taken for identity
+    assertEqual(forged.contentHash(), zipped.contentHash());
+    assertFalse(forged == zipped);
+    assertFalse(zipped == forged);
+    assertFalse(forged == loose);
+}
+
+void CommentaryTest::setupZippedCommentsUnloadingTest()
+{
+    setupZipFileCommentsTest();
+    setZippedCommentaryMemoryBudget(0);
+}
+
+void CommentaryTest::finishZippedCommentsUnloadingTest()
+{
+    setZippedCommentaryMemoryBudget(24 * 1024 * 1024);
+    finishZipFileCommentsTest();
+}
+
+void CommentaryTest::testZippedCommentsUnloading()
+{
+    // without any budget only the comment that was just played may stay in memory, the rest must get reloaded
+    for (int i = 0; i < 6; i++) {
+        resetMockSdlMixer();
+        triggerRedCardSample();
+
+        assertEqual(numTimesPlayChunkCalled(), 1);
+        const auto chunk = getLastPlayedChunk();
+        assertTrue(chunk);
+
+        bool isRedCard = chunk->alen == 8 && !memcmp(chunk->abuf, "red_card", 8);
+        bool isRedCard3 = chunk->alen == 9 && !memcmp(chunk->abuf, "red_card3", 9);
+        assertTrue(isRedCard || isRedCard3);
+
+        assertTrue(zippedCommentaryResidentSize() <= static_cast<size_t>(chunk->alen));
+    }
+}
+
+void CommentaryTest::testZippedCommentsPrefetching()
+{
+    std::atomic<bool> stop = false;
+
+    // nothing zipped gets decompressed without a budget
+    setZippedCommentaryMemoryBudget(0);
+    predecodeCommentary(stop);
+    assertEqual(zippedCommentaryResidentSize(), 0);
+
+    setZippedCommentaryMemoryBudget(24 * 1024 * 1024);
+    assertTrue(predecodeCommentary(stop) > 0);
+    auto residentSize = zippedCommentaryResidentSize();
+    assertTrue(residentSize > 0);
+
+    // everything fits, so there's nothing left to prefetch
+    assertEqual(predecodeCommentary(stop), 0);
+    assertEqual(zippedCommentaryResidentSize(), residentSize);
+
+    // prefetched comments get played from memory
+    resetMockSdlMixer();
+    triggerRedCardSample();
+    assertEqual(numTimesPlayChunkCalled(), 1);
+    const auto chunk = getLastPlayedChunk();
+    assertTrue(chunk && (chunk->alen == 8 || chunk->alen == 9) && !memcmp(chunk->abuf, "red_card", 8));
+    assertEqual(zippedCommentaryResidentSize(), residentSize);
+}
+
 void CommentaryTest::loadFakeCommentsZipFile()
 {
     int size;
@@ -949,3 +1055,67 @@ static void setupKeeperClaimedComment()
     // make sure no comments are playing
     Mix_HaltChannel(-1);
 }
+
+// Lots of same sized comments sharing a long common prefix (like a wave header followed by silence), with every
+// tenth one being a duplicate. That's the worst case for telling the comments apart by their content.
+void CommentaryTest::setupLargeCommentaryPackTest()
+{
+    constexpr int kNumComments = 1'000;
+    constexpr int kCommentSize = 32 * 1024;
+    constexpr int kCommonPrefixSize = 4 * 1024;
+    constexpr int kDuplicateInterval = 10;
+
+    clearCommentsSampleCache();
+    resetFakeFiles();
+
+    m_largePackData.clear();
+    m_largePackData.reserve(kNumComments);
+
+    uint32_t seed = 0x2545f491;
+
+    for (int i = 0; i < kNumComments; i++) {
+        if (i % kDuplicateInterval == kDuplicateInterval - 1) {
+            m_largePackData.push_back(m_largePackData.back());
+        } else {
+            std::string data(kCommentSize, '\0');
+            for (int j = kCommonPrefixSize; j < kCommentSize; j++) {
+                seed ^= seed << 13;
+                seed ^= seed >> 17;
+                seed ^= seed << 5;
+                data[j] = static_cast<char>(seed);
+            }
+            m_largePackData.push_back(std::move(data));
+        }
+
+        char path[64];
+        snprintf(path, sizeof(path), "audio\\commentary\\corner\\corner%04d.wav", i);
+        addFakeFile({ path, m_largePackData.back().data(), kCommentSize });
+    }
+}
+
+void CommentaryTest::finishLargeCommentaryPackTest()
+{
+    resetFakeFiles();
+    clearCommentsSampleCache();
+    m_largePackData.clear();
+}
+
+void CommentaryTest::testLargeCommentaryPackLoading()
+{
+    auto startTime = SDL_GetPerformanceCounter();
+
+    {
+        SWOS_UnitTest::AssertSilencer assertSilencer;
+        LogSilencer logSilencer;
+        loadCommentary();
+    }
+
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+
+    size_t totalSize = 0;
+    for (const auto& data : m_largePackData)
+        totalSize += data.size();
+
+    logInfo("Loaded %d comments (%.1f MB) in %.2f ms, %.0f comments/s", static_cast<int>(m_largePackData.size()),
+        totalSize / (1024.0 * 1024.0), elapsed * 1'000, m_largePackData.size() / elapsed);
+}
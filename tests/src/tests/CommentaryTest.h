@@ -33,6 +33,14 @@ private:
     void finishZipFileCommentsTest();
     void testZipFileComments();
     void testRawFileFromZip();
+    void testLooseAndZippedSampleEquality();
+    void setupZippedCommentsUnloadingTest();
+    void finishZippedCommentsUnloadingTest();
+    void testZippedCommentsUnloading();
+    void testZippedCommentsPrefetching();
+    void setupLargeCommentaryPackTest();
+    void finishLargeCommentaryPackTest();
+    void testLargeCommentaryPackLoading();
 
     void loadFakeCommentsZipFile();
     void applyEnqueuedSamplesData(const EnqueuedSamplesData& data, const std::vector<int>& values);
@@ -41,4 +49,5 @@ private:
     void testEndGameCrowdSample();
 
     std::unique_ptr<char []> m_commentaryZipData;
+    std::vector<std::string> m_largePackData;
 };
@@ -17,6 +17,7 @@
 #include "random.h"
 #include "windowManager.h"
 #include "unpackMenu.h"
+#include "benchmark.h"
 #include <dirent.h>
 
 #define MAKE_FULL_VERSION(major, minor) (((major) << 8) | (minor))
@@ -75,15 +76,6 @@ static RecordedDataTest t;
 
 void RecordedDataTest::init()
 {
-    m_files = findResFiles(kExtension);
-    auto files = findFiles(kExtension, kDataDir);
-    std::for_each(files.begin(), files.end(), [this](const auto& file) {
-        const auto& path = joinPaths(kDataDir, file.name.c_str());
-        m_files.emplace_back(path);
-    });
-    if (!m_files.empty())
-        m_files.push_back(m_files.front());
-
     disableRendering();
     killSdlDelay();
     takeOverInput();
@@ -123,16 +115,52 @@ const char *RecordedDataTest::displayName() const
     return "recorded game data";
 }
 
+// Done here instead of init(), since the number of recordings must be known before the test is initialized.
+void RecordedDataTest::findDataFiles()
+{
+    m_files = findResFiles(kExtension);
+    auto files = findFiles(kExtension, kDataDir);
+    std::for_each(files.begin(), files.end(), [this](const auto& file) {
+        const auto& path = joinPaths(kDataDir, file.name.c_str());
+        m_files.emplace_back(path);
+    });
+    if (!m_files.empty())
+        m_files.push_back(m_files.front());
+}
+
 auto RecordedDataTest::getCases() -> CaseList
 {
+    if (m_files.empty())
+        findDataFiles();
+
     return {
         { "test calculateDeltaXAndY()", "calculateDeltaXAndY", nullptr,
             bind(&RecordedDataTest::verifyCalculateDeltaXandY), std::size(kCalculateDeltaXAndYTestData), false },
         { "verify recorded game data", "verify-rec-data", bind(&RecordedDataTest::setupRecordedDataVerification),
             bind(&RecordedDataTest::verifyRecordedData), m_files.size(), false },
+        { "test spreading recordings over workers", "rec-data-worker-split", nullptr,
+            bind(&RecordedDataTest::verifyRecordingsSpreadOverWorkers), 1, false },
     };
 }
 
+// Running with --jobs must spread the recordings over the workers, instead of giving them all to a single one.
+void RecordedDataTest::verifyRecordingsSpreadOverWorkers()
+{
+    constexpr int kNumJobs = 4;
+
+    for (const auto& testsToRun : { std::vector<std::string>{}, std::vector<std::string>{ "verify-rec-data" } }) {
+        TestOptions options{};
+        options.testsToRun = testsToRun;
+        options.numJobs = kNumJobs;
+
+        const auto& workers = getCaseWorkers(options, "verify-rec-data");
+        assertEqual(workers.size(), m_files.size());
+
+        std::unordered_set<int> distinctWorkers(workers.begin(), workers.end());
+        assertEqual(distinctWorkers.size(), std::min<size_t>(kNumJobs, workers.size()));
+    }
+}
+
 void RecordedDataTest::setupRecordedDataVerification()
 {
     assert(!m_files.empty());
@@ -153,6 +181,7 @@ void RecordedDataTest::setupRecordedDataVerification()
 void RecordedDataTest::verifyRecordedData()
 {
     std::tie(m_dataFile, m_header) = openDataFile(m_files[m_currentDataIndex]);
+    startBenchmarkRecording(m_files[m_currentDataIndex]);
 
     static const auto kVersionSizes = {
         std::make_tuple(1, 5, sizeof(FrameV1p5)),
@@ -274,10 +303,14 @@ void RecordedDataTest::setFrameInput()
         if (m_frame.userKey == 'S')
             queueSdlKeyDown(SDL_SCANCODE_S);
     }
+
+    markBenchmarkFrameStart();
 }
 
 void RecordedDataTest::verifyFrame()
 {
+    markBenchmarkFrameEnd();
+
     for (auto vec : { &m_player1Keys, &m_player2Keys })
         for (auto key : *vec)
             setSdlKeyUp(key);
@@ -134,6 +134,8 @@ private:
     using Frame = FrameV1p5;
 #pragma pack(pop)
 
+    void findDataFiles();
+    void verifyRecordingsSpreadOverWorkers();
     void setupRecordedDataVerification();
     void verifyRecordedData();
     void verifyCalculateDeltaXandY();
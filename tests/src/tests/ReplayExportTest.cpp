@@ -0,0 +1,204 @@
+#include "ReplayExportTest.h"
+#include "replayExport.h"
+#include "ReplayDataStorage.h"
+#include "hilFile.h"
+#include "sprites.h"
+#include "windowManager.h"
+#include "timer.h"
+#include "unitTest.h"
+#include "mockLog.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+static ReplayExportTest t;
+
+#ifdef _WIN32
+static int fileDescriptor(FILE *f) { return _fileno(f); }
+static int duplicateFd(int fd) { return _dup(fd); }
+static void redirectFd(int fd, int targetFd) { _dup2(fd, targetFd); }
+static void closeFd(int fd) { _close(fd); }
+#else
+static int fileDescriptor(FILE *f) { return fileno(f); }
+static int duplicateFd(int fd) { return dup(fd); }
+static void redirectFd(int fd, int targetFd) { dup2(fd, targetFd); }
+static void closeFd(int fd) { close(fd); }
+#endif
+
+// Runs the function with everything written to the standard output file descriptor diverted into a temporary
+// file, and returns what was written.
+static std::string captureStdout(std::function<void()> f)
+{
+    const auto& path = (std::filesystem::temp_directory_path() / "swos-export-stdout.bin").string();
+
+    std::cout.flush();
+    fflush(stdout);
+
+    auto file = fopen(path.c_str(), "wb");
+    assertTrue(file);
+
+    int savedStdout = duplicateFd(fileDescriptor(stdout));
+    redirectFd(fileDescriptor(file), fileDescriptor(stdout));
+
+    auto restoreStdout = [&]() {
+        std::cout.flush();
+        fflush(stdout);
+        redirectFd(savedStdout, fileDescriptor(stdout));
+        closeFd(savedStdout);
+        fclose(file);
+    };
+
+    try {
+        f();
+    } catch (...) {
+        restoreStdout();
+        throw;
+    }
+
+    restoreStdout();
+
+    std::ifstream in(path, std::ios::binary);
+    std::string result((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    return result;
+}
+
+const char *ReplayExportTest::name() const
+{
+    return "replay-export";
+}
+
+const char *ReplayExportTest::displayName() const
+{
+    return "replay export";
+}
+
+auto ReplayExportTest::getCases() -> CaseList
+{
+    return {
+        { "test that stdout gets nothing but the video", "replay-export-stdout", nullptr,
+            bind(&ReplayExportTest::testStdoutStreamIsClean), 1, false },
+        { "test exporting a recorded replay", "replay-export-frames", nullptr,
+            bind(&ReplayExportTest::testExportedFrames), 1, false },
+    };
+}
+
+// There's no replay to load, so the export fails without writing anything, logging along the way.
+// Log echo is pointed at the standard output, like it is in the game before the export sets it up.
+void ReplayExportTest::testStdoutStreamIsClean()
+{
+    const auto& tempDir = std::filesystem::temp_directory_path();
+    const auto& replayPath = (tempDir / "swos-missing-replay.rpl").string();
+    const auto& sfxPath = (tempDir / "swos-missing-replay.sfx").string();
+
+    setReplayExportFile(replayPath.c_str());
+    setReplayExportFormat("y4m");
+    setReplayExportOutput("-");
+    setReplayExportSfxOutput(sfxPath.c_str());
+
+    LogSilencer logSilencer;
+    auto oldLogStream = setLogConsoleStream(&std::cout);
+
+    std::ostringstream errorOutput;
+    auto oldErrorBuffer = std::cerr.rdbuf(errorOutput.rdbuf());
+
+    setupReplayExportLog();
+
+    bool result = true;
+    const auto& output = captureStdout([&result]() { result = exportReplay(); });
+
+    std::cerr.rdbuf(oldErrorBuffer);
+    setLogConsoleStream(oldLogStream);
+    setReplayExportFile("");
+
+    assertFalse(result);
+    assertTrue(output.empty());
+    assertFalse(std::filesystem::exists(sfxPath));
+    assertTrue(errorOutput.str().find("Exporting replay") != std::string::npos);
+}
+
+// Records a short replay with a single sound effect, exports it to a file, and walks through the stream,
+// checking the header, frame markers and sizes, and the sfx track.
+void ReplayExportTest::testExportedFrames()
+{
+    constexpr int kNumFrames = 5;
+    constexpr int kSfxFrame = 2;
+    constexpr int kSfxSample = 3;
+    constexpr int kSfxVolume = 100;
+
+    const auto& tempDir = std::filesystem::temp_directory_path();
+    const auto& replayPath = (tempDir / "swos-export-test.rpl").string();
+    const auto& outputPath = (tempDir / "swos-export-test.y4m").string();
+    const auto& sfxPath = (tempDir / "swos-export-test.sfx").string();
+
+    LogSilencer logSilencer;
+
+    ReplayDataStorage replayData;
+    replayData.startRecordingNewReplay();
+
+    for (int i = 0; i < kNumFrames; i++) {
+        replayData.recordFrame({ FixedPoint(176 + 8 * i), FixedPoint(349), 0, 0, -1 });
+        replayData.recordSprite(kBallSprite1, FixedPoint(336), FixedPoint(449 + 2 * i));
+        if (i == kSfxFrame)
+            replayData.recordSfx(kSfxSample, kSfxVolume);
+    }
+
+    HilV2Header header{};
+    header.team1 = swos.topTeamInGame;
+    header.team2 = swos.bottomTeamInGame;
+    assertTrue(replayData.save(replayPath.c_str(), header, true, true));
+
+    setReplayExportFile(replayPath.c_str());
+    setReplayExportFormat("y4m");
+    setReplayExportOutput(outputPath.c_str());
+    setReplayExportSfxOutput(sfxPath.c_str());
+
+    auto result = exportReplay();
+
+    setReplayExportFile("");
+
+    std::ifstream in(outputPath, std::ios::binary);
+    std::string output((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    std::ifstream sfxIn(sfxPath);
+    std::string sfxTrack((std::istreambuf_iterator<char>(sfxIn)), std::istreambuf_iterator<char>());
+    sfxIn.close();
+
+    std::error_code error;
+    for (const auto& path : { replayPath, outputPath, sfxPath })
+        std::filesystem::remove(path, error);
+
+    assertTrue(result);
+
+    auto [width, height] = getWindowSize();
+    char streamHeader[128];
+    snprintf(streamHeader, sizeof(streamHeader), "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, targetFps());
+
+    assertTrue(output.compare(0, strlen(streamHeader), streamHeader) == 0);
+
+    constexpr char kFrameMarker[] = "FRAME\n";
+    const size_t kFrameSize = sizeof(kFrameMarker) - 1 + 3 * width * height;
+
+    int numFrames = 0;
+    for (size_t pos = strlen(streamHeader); pos < output.size(); pos += kFrameSize, numFrames++) {
+        assertTrue(output.compare(pos, sizeof(kFrameMarker) - 1, kFrameMarker) == 0);
+        assertTrue(output.size() - pos >= kFrameSize);
+    }
+
+    assertEqual(numFrames, kNumFrames);
+    assertEqual(output.size(), strlen(streamHeader) + kNumFrames * kFrameSize);
+
+    char sfxLine[64];
+    snprintf(sfxLine, sizeof(sfxLine), "\n%d,%d,%d\n", kSfxFrame, kSfxSample, kSfxVolume);
+    assertTrue(sfxTrack.find(sfxLine) != std::string::npos);
+}
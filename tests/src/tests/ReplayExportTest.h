@@ -0,0 +1,17 @@
+#pragma once
+
+#include "BaseTest.h"
+
+class ReplayExportTest : public BaseTest
+{
+    void init() override {}
+    void finish() override {}
+    void defaultCaseInit() override {}
+    const char *name() const override;
+    const char *displayName() const override;
+    CaseList getCases() override;
+
+private:
+    void testStdoutStreamIsClean();
+    void testExportedFrames();
+};
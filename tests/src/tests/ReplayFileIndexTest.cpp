@@ -0,0 +1,230 @@
+#include "ReplayFileIndexTest.h"
+#include "replayFileIndex.h"
+#include "ReplayDataStorage.h"
+#include "hilFile.h"
+#include "file.h"
+#include "unitTest.h"
+#include "mockLog.h"
+#include <filesystem>
+#include <fstream>
+
+static ReplayFileIndexTest t;
+
+constexpr char kTestDir[] = "replay-index-test";
+constexpr char kIndexFilename[] = "replays.idx";
+constexpr char kExtension[] = ".rpl";
+
+struct TestReplay {
+    const char *filename;
+    const char *team1;
+    const char *team2;
+    int team1Goals;
+    int team2Goals;
+    const char *round;
+    const char *summary;
+};
+
+static const TestReplay kTestReplays[] = {
+    { "final.rpl", "BRAZIL", "ITALY", 3, 2, "FINAL", "BRAZIL 3-2 ITALY, FINAL" },
+    { "friendly.rpl", "CANADA", "MEXICO", 0, 0, "", "CANADA 0-0 MEXICO" },
+    { "league.rpl", "ARSENAL", "CHELSEA", 1, 4, "ROUND 12", "ARSENAL 1-4 CHELSEA, ROUND 12" },
+};
+
+static std::filesystem::path fullPath(const char *filename = nullptr)
+{
+    std::filesystem::path path = pathInRootDir(kTestDir);
+    return filename ? path / filename : path;
+}
+
+static void writeReplay(const TestReplay& replay, int numFrames = 10)
+{
+    ReplayDataStorage replayData;
+    replayData.startRecordingNewReplay();
+
+    for (int i = 0; i < numFrames; i++)
+        replayData.recordFrame({ FixedPoint(i), FixedPoint(i), replay.team1Goals, replay.team2Goals, -1 });
+
+    HilV2Header header{};
+    strncpy(header.team1.teamName, replay.team1, sizeof(header.team1.teamName) - 1);
+    strncpy(header.team2.teamName, replay.team2, sizeof(header.team2.teamName) - 1);
+    strncpy(header.gameRound, replay.round, sizeof(header.gameRound) - 1);
+    header.team1Goals = replay.team1Goals;
+    header.team2Goals = replay.team2Goals;
+
+    const auto& path = joinPaths(kTestDir, replay.filename);
+    assertTrue(replayData.save(path.c_str(), header, true, true));
+}
+
+static FoundFileList refreshIndex()
+{
+    auto files = findReplayFilesWithSummaries(kExtension, kTestDir);
+
+    std::sort(files.begin(), files.end(), [](const auto& file1, const auto& file2) {
+        return file1.name < file2.name;
+    });
+
+    return files;
+}
+
+static void verifySummaries(const FoundFileList& files, const std::vector<TestReplay>& replays)
+{
+    assertEqual(files.size(), replays.size());
+
+    for (size_t i = 0; i < files.size(); i++) {
+        assertEqual(files[i].name, replays[i].filename);
+        assertEqual(files[i].description, replays[i].summary);
+    }
+}
+
+static uint32_t numIndexEntries()
+{
+    std::ifstream in(fullPath(kIndexFilename), std::ios::binary);
+    assertTrue(in.good());
+
+    // magic, version, number of entries
+    uint32_t header[3] = {};
+    in.read(reinterpret_cast<char *>(header), sizeof(header));
+    assertTrue(in.good());
+
+    return header[2];
+}
+
+const char *ReplayFileIndexTest::name() const
+{
+    return "replay-file-index";
+}
+
+const char *ReplayFileIndexTest::displayName() const
+{
+    return "replay file index";
+}
+
+auto ReplayFileIndexTest::getCases() -> CaseList
+{
+    return {
+        { "test building the index from scratch", "replay-index-cold-build",
+            bind(&ReplayFileIndexTest::setupReplayDirectory), bind(&ReplayFileIndexTest::testColdBuild), 1, false,
+            bind(&ReplayFileIndexTest::removeReplayDirectory) },
+        { "test reloading an unchanged directory", "replay-index-unchanged",
+            bind(&ReplayFileIndexTest::setupReplayDirectory), bind(&ReplayFileIndexTest::testUnchangedReload), 1, false,
+            bind(&ReplayFileIndexTest::removeReplayDirectory) },
+        { "test refreshing a modified file", "replay-index-modified-file",
+            bind(&ReplayFileIndexTest::setupReplayDirectory), bind(&ReplayFileIndexTest::testModifiedFile), 1, false,
+            bind(&ReplayFileIndexTest::removeReplayDirectory) },
+        { "test dropping a deleted file", "replay-index-deleted-file",
+            bind(&ReplayFileIndexTest::setupReplayDirectory), bind(&ReplayFileIndexTest::testDeletedFile), 1, false,
+            bind(&ReplayFileIndexTest::removeReplayDirectory) },
+        { "test rescanning after a broken index", "replay-index-corrupt",
+            bind(&ReplayFileIndexTest::setupReplayDirectory), bind(&ReplayFileIndexTest::testCorruptIndex), 1, false,
+            bind(&ReplayFileIndexTest::removeReplayDirectory) },
+    };
+}
+
+void ReplayFileIndexTest::setupReplayDirectory()
+{
+    removeReplayDirectory();
+    std::filesystem::create_directories(fullPath());
+
+    for (const auto& replay : kTestReplays)
+        writeReplay(replay);
+}
+
+void ReplayFileIndexTest::removeReplayDirectory()
+{
+    std::error_code error;
+    std::filesystem::remove_all(fullPath(), error);
+}
+
+void ReplayFileIndexTest::testColdBuild()
+{
+    assertFalse(std::filesystem::exists(fullPath(kIndexFilename)));
+
+    const auto& files = refreshIndex();
+
+    verifySummaries(files, { std::begin(kTestReplays), std::end(kTestReplays) });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), std::size(kTestReplays));
+    assertEqual(numIndexEntries(), std::size(kTestReplays));
+}
+
+void ReplayFileIndexTest::testUnchangedReload()
+{
+    refreshIndex();
+
+    auto indexTime = std::filesystem::last_write_time(fullPath(kIndexFilename));
+    const auto& files = refreshIndex();
+
+    verifySummaries(files, { std::begin(kTestReplays), std::end(kTestReplays) });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), 0u);
+    assertTrue(std::filesystem::last_write_time(fullPath(kIndexFilename)) == indexTime);
+}
+
+// Score changes along with the size; the modification time is pushed forward explicitly since the file system
+// might not have the resolution to tell the two writes apart.
+void ReplayFileIndexTest::testModifiedFile()
+{
+    refreshIndex();
+
+    auto replay = kTestReplays[1];
+    replay.team2Goals = 1;
+    replay.summary = "CANADA 0-1 MEXICO";
+
+    const auto& path = fullPath(replay.filename);
+    auto oldTime = std::filesystem::last_write_time(path);
+    writeReplay(replay, 20);
+    std::filesystem::last_write_time(path, oldTime + std::chrono::seconds(10));
+
+    const auto& files = refreshIndex();
+
+    verifySummaries(files, { kTestReplays[0], replay, kTestReplays[2] });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), 1u);
+
+    // only modification time changed
+    std::filesystem::last_write_time(path, oldTime + std::chrono::seconds(20));
+    refreshIndex();
+    assertEqual(numReplayHeadersReadOnLastRefresh(), 1u);
+}
+
+void ReplayFileIndexTest::testDeletedFile()
+{
+    refreshIndex();
+
+    std::filesystem::remove(fullPath(kTestReplays[2].filename));
+
+    const auto& files = refreshIndex();
+
+    verifySummaries(files, { kTestReplays[0], kTestReplays[1] });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), 0u);
+    assertEqual(numIndexEntries(), 2u);
+}
+
+// Garbage in place of the index means reading everything again; a truncated one keeps the entries that made it.
+void ReplayFileIndexTest::testCorruptIndex()
+{
+    LogSilencer logSilencer;
+
+    refreshIndex();
+
+    const auto& indexPath = fullPath(kIndexFilename);
+    auto indexSize = std::filesystem::file_size(indexPath);
+
+    {
+        std::ofstream out(indexPath, std::ios::binary | std::ios::trunc);
+        out << "this is not an index";
+    }
+
+    auto files = refreshIndex();
+
+    verifySummaries(files, { std::begin(kTestReplays), std::end(kTestReplays) });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), std::size(kTestReplays));
+    assertEqual(std::filesystem::file_size(indexPath), indexSize);
+
+    constexpr size_t kIndexHeaderSize = 12;
+    auto entrySize = (indexSize - kIndexHeaderSize) / std::size(kTestReplays);
+    std::filesystem::resize_file(indexPath, kIndexHeaderSize + entrySize + entrySize / 2);
+
+    files = refreshIndex();
+
+    verifySummaries(files, { std::begin(kTestReplays), std::end(kTestReplays) });
+    assertEqual(numReplayHeadersReadOnLastRefresh(), std::size(kTestReplays) - 1);
+    assertEqual(numIndexEntries(), std::size(kTestReplays));
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "BaseTest.h"
+
+class ReplayFileIndexTest : public BaseTest
+{
+    void init() override {}
+    void finish() override {}
+    void defaultCaseInit() override {}
+    const char *name() const override;
+    const char *displayName() const override;
+    CaseList getCases() override;
+
+private:
+    void setupReplayDirectory();
+    void removeReplayDirectory();
+    void testColdBuild();
+    void testUnchangedReload();
+    void testModifiedFile();
+    void testDeletedFile();
+    void testCorruptIndex();
+};
@@ -63,13 +63,6 @@ void WindowModeMenuTest::init()
 
     auto hook = std::bind(&WindowModeMenuTest::verifyYellowPleaseWaitTextPresence, this);
     m_hookId = addUpdateHook(hook);
-
-    for (int i = 0; i < kNumDisplayListsForScrollTesting; i++) {
-        auto modes(kDisplayModes);
-        modes.resize(5 * i);
-        for (int j = 0; j < kNumScrollMethods; j++)
-            m_testScrollingData.emplace_back(modes, static_cast<ScrollMethod>(j));
-    }
 }
 
 void WindowModeMenuTest::finish()
@@ -96,8 +89,22 @@ const char *WindowModeMenuTest::displayName() const
     return "window mode menu";
 }
 
+// Filled in here instead of init(), since the number of cases must be known before the test is initialized.
+void WindowModeMenuTest::fillScrollingTestData()
+{
+    for (int i = 0; i < kNumDisplayListsForScrollTesting; i++) {
+        auto modes(kDisplayModes);
+        modes.resize(5 * i);
+        for (int j = 0; j < kNumScrollMethods; j++)
+            m_testScrollingData.emplace_back(modes, static_cast<ScrollMethod>(j));
+    }
+}
+
 auto WindowModeMenuTest::getCases() -> CaseList
 {
+    if (m_testScrollingData.empty())
+        fillScrollingTestData();
+
     // don't make it static since scrolling data is generated in init()
     return {
         { "test window dimensions", "win-dimensions", bind(&WindowModeMenuTest::setupWindowSizeTest),
@@ -22,6 +22,7 @@ private:
     void setupModeSwitchingTest();
     void testModeSwitching();
 
+    void fillScrollingTestData();
     void setupResolutionListScrollingTest();
     void testResolutionListScrolling();
     enum ScrollMethod { kArrowClick, kArrowMouseWheel, kResolutionListMouseWheel, kNumScrollMethods };
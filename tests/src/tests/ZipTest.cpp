@@ -0,0 +1,197 @@
+#include "ZipTest.h"
+#include "zip.h"
+#include "SoundSample.h"
+#include "file.h"
+#include "unitTest.h"
+#include "mockFile.h"
+#include "resData.h"
+
+static ZipTest t;
+
+struct ZipEntryData {
+    int index;
+    std::string data;
+};
+
+using ZipEntryDataList = std::vector<ZipEntryData>;
+
+static std::string zipPath()
+{
+    const auto& relativePath = joinPaths("audio", "commentary.zip");
+    return pathInRootDir(relativePath.c_str());
+}
+
+// leave space for the wave header in front of raw files, like the commentary loader does
+static std::vector<ZipArchive::ReadRequest> getReadRequests(const ZipArchive& archive)
+{
+    std::vector<ZipArchive::ReadRequest> requests;
+
+    const auto& entries = archive.entries();
+    for (int i = 0; i < static_cast<int>(entries.size()); i++)
+        requests.push_back({ i, SoundSample::additionalHeaderSize(entries[i].name.c_str()) });
+
+    return requests;
+}
+
+static ZipEntryDataList readSequentially(ZipArchive& archive, const std::vector<ZipArchive::ReadRequest>& requests)
+{
+    ZipEntryDataList entries;
+
+    for (const auto& request : requests) {
+        auto data = archive.readEntry(request.index, request.extraSpace);
+        assertTrue(data.first);
+        entries.push_back({ request.index, { data.first, static_cast<size_t>(data.second) } });
+        delete[] data.first;
+    }
+
+    return entries;
+}
+
+static void logReadSpeed(const char *description, int numEntries, size_t numBytes, uint64_t startTime)
+{
+    auto elapsed = static_cast<double>(SDL_GetPerformanceCounter() - startTime) / SDL_GetPerformanceFrequency();
+    logInfo("%s: %d entries in %.2f ms, %.0f entries/s, %.1f MB/s", description, numEntries, elapsed * 1'000,
+        numEntries / elapsed, numBytes / elapsed / (1024 * 1024));
+}
+
+void ZipTest::init()
+{
+    enableFileMocking(true);
+}
+
+void ZipTest::finish()
+{
+    enableFileMocking(false);
+}
+
+const char *ZipTest::name() const
+{
+    return "zip";
+}
+
+const char *ZipTest::displayName() const
+{
+    return "zip files";
+}
+
+auto ZipTest::getCases() -> CaseList
+{
+    return {
+        { "test parallel read order", "zip-parallel-read-order",
+            bind(&ZipTest::setupZipFile), bind(&ZipTest::testParallelReadOrder), 1, false,
+            bind(&ZipTest::finishZipFile) },
+        { "test stopping parallel read early", "zip-parallel-read-early-stop",
+            bind(&ZipTest::setupZipFile), bind(&ZipTest::testParallelReadEarlyStop), 1, false,
+            bind(&ZipTest::finishZipFile) },
+        { "benchmark parallel read", "zip-parallel-read-benchmark",
+            bind(&ZipTest::setupZipFile), bind(&ZipTest::benchmarkParallelRead), 1, false,
+            bind(&ZipTest::finishZipFile) },
+    };
+}
+
+void ZipTest::setupZipFile()
+{
+    int size;
+    std::tie(m_zipData, size) = loadResFile("commentary.zip");
+
+    resetFakeFiles();
+    addFakeFile({ "audio\\commentary.zip", m_zipData.get(), size });
+}
+
+void ZipTest::finishZipFile()
+{
+    resetFakeFiles();
+    m_zipData.reset();
+}
+
+void ZipTest::testParallelReadOrder()
+{
+    ZipArchive archive;
+    assertTrue(archive.open(zipPath().c_str()));
+
+    const auto& requests = getReadRequests(archive);
+    const auto& expected = readSequentially(archive, requests);
+    assertTrue(!expected.empty());
+
+    for (int numThreads : { 1, 2, 3, 8, 64 }) {
+        ZipEntryDataList entries;
+
+        bool result = archive.readEntries(requests, [&entries](int index, char *buffer, int bufferLength) {
+            entries.push_back({ index, { buffer, static_cast<size_t>(bufferLength) } });
+            delete[] buffer;
+            return true;
+        }, numThreads);
+        assertTrue(result);
+
+        assertEqual(entries.size(), expected.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            assertEqual(entries[i].index, expected[i].index);
+            assertEqual(entries[i].data.size(), expected[i].data.size());
+            int offset = requests[i].extraSpace;
+            assertTrue(!memcmp(entries[i].data.data() + offset, expected[i].data.data() + offset,
+                entries[i].data.size() - offset));
+        }
+    }
+}
+
+void ZipTest::testParallelReadEarlyStop()
+{
+    ZipArchive archive;
+    assertTrue(archive.open(zipPath().c_str()));
+
+    const auto& requests = getReadRequests(archive);
+    assertTrue(requests.size() > 3);
+
+    int numProcessed = 0;
+    bool result = archive.readEntries(requests, [&numProcessed](int, char *buffer, int) {
+        delete[] buffer;
+        return ++numProcessed < 3;
+    }, 4);
+
+    assertTrue(result);
+    assertEqual(numProcessed, 3);
+}
+
+// Only reports the speed, the results are checked by the other cases.
+void ZipTest::benchmarkParallelRead()
+{
+    constexpr int kNumIterations = 50;
+
+    ZipArchive archive;
+    assertTrue(archive.open(zipPath().c_str()));
+
+    const auto& requests = getReadRequests(archive);
+    int numEntries = kNumIterations * static_cast<int>(requests.size());
+
+    size_t numBytes = 0;
+    auto startTime = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < kNumIterations; i++) {
+        for (const auto& request : requests) {
+            auto data = archive.readEntry(request.index, request.extraSpace);
+            numBytes += data.second;
+            delete[] data.first;
+        }
+    }
+
+    logReadSpeed("Sequential read", numEntries, numBytes, startTime);
+
+    int maxThreads = std::max(4, static_cast<int>(std::thread::hardware_concurrency()));
+
+    for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+        numBytes = 0;
+        startTime = SDL_GetPerformanceCounter();
+
+        for (int i = 0; i < kNumIterations; i++) {
+            archive.readEntries(requests, [&numBytes](int, char *buffer, int bufferLength) {
+                numBytes += bufferLength;
+                delete[] buffer;
+                return true;
+            }, numThreads);
+        }
+
+        char description[64];
+        snprintf(description, sizeof(description), "Parallel read, %d thread(s)", numThreads);
+        logReadSpeed(description, numEntries, numBytes, startTime);
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "BaseTest.h"
+
+class ZipTest : public BaseTest
+{
+    void init() override;
+    void finish() override;
+    void defaultCaseInit() override {}
+    const char *name() const override;
+    const char *displayName() const override;
+    CaseList getCases() override;
+
+private:
+    void setupZipFile();
+    void finishZipFile();
+    void testParallelReadOrder();
+    void testParallelReadEarlyStop();
+    void benchmarkParallelRead();
+
+    std::unique_ptr<char []> m_zipData;
+};